@@ -0,0 +1,317 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BatchJob.h"
+#include "../spectrum/Processor.h"
+#include "../spectrum/TapeLoader.h"
+#include "../spectrum/WavAudioSink.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Key names by keyboard half-row and bit, as read through port 0xFE
+const char *const KEY_NAMES[8][5] = {
+    {"SHIFT", "Z", "X", "C", "V"}, {"A", "S", "D", "F", "G"},
+    {"Q", "W", "E", "R", "T"},     {"1", "2", "3", "4", "5"},
+    {"0", "9", "8", "7", "6"},     {"P", "O", "I", "U", "Y"},
+    {"ENTER", "L", "K", "J", "H"}, {"SPACE", "SYM", "M", "N", "B"}};
+
+std::string upper(std::string text) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](unsigned char c) { return (char)std::toupper(c); });
+  return text;
+}
+
+bool isTapeFile(const std::string &path) {
+  std::string::size_type dot = path.find_last_of('.');
+  if (dot == std::string::npos)
+    return false;
+  std::string ext = upper(path.substr(dot + 1));
+  return ext == "TAP" || ext == "TZX";
+}
+
+std::string jsonString(const std::string &text) {
+  std::string out = "\"";
+  for (unsigned char c : text) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += (char)c;
+    } else if (c < 0x20) {
+      char escape[8];
+      snprintf(escape, sizeof(escape), "\\u%04x", c);
+      out += escape;
+    } else {
+      out += (char)c;
+    }
+  }
+  return out + "\"";
+}
+
+// FNV-1a over the display file and attributes
+std::uint64_t hashScreen(const byte *screen) {
+  std::uint64_t hash = 1469598103934665603ULL;
+  for (int i = 0; i < VIDEO_DATA; i++) {
+    hash ^= screen[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// The loaders log and carry on when a file is missing; a batch run
+// should report it instead
+void checkReadable(const std::string &path) {
+  if (!std::ifstream(path))
+    throw std::runtime_error("Can't open " + path);
+}
+
+std::string registerJson(const Z80Registers &r, const ProcessorState &state) {
+  char buffer[320];
+  snprintf(buffer, sizeof(buffer),
+           "{\"AF\":\"%04X\",\"BC\":\"%04X\",\"DE\":\"%04X\",\"HL\":\"%04X\","
+           "\"AF'\":\"%04X\",\"BC'\":\"%04X\",\"DE'\":\"%04X\","
+           "\"HL'\":\"%04X\",\"IX\":\"%04X\",\"IY\":\"%04X\","
+           "\"SP\":\"%04X\",\"PC\":\"%04X\",\"I\":\"%02X\",\"R\":\"%02X\","
+           "\"IFF\":%d,\"IM\":%d,\"halted\":%s}",
+           r.AF, r.BC, r.DE, r.HL, r.AF_, r.BC_, r.DE_, r.HL_, r.IX, r.IY,
+           r.SP, r.PC, r.I, r.R, state.areInterruptsEnabled() ? 1 : 0,
+           state.getInterruptMode(), state.isHalted() ? "true" : "false");
+  return buffer;
+}
+
+} // namespace
+
+std::string BatchResult::toJson() const {
+  std::string json = "{\"job\":" + std::to_string(index) +
+                     ",\"name\":" + jsonString(name);
+  if (!error.empty())
+    json += ",\"error\":" + jsonString(error);
+
+  char screen[32];
+  snprintf(screen, sizeof(screen), "%016llx",
+           (unsigned long long)screenHash);
+  char wall[32];
+  snprintf(wall, sizeof(wall), "%.3f", wallMs);
+
+  json += ",\"frames\":" + std::to_string(frames) +
+          ",\"tstates\":" + std::to_string(tStates) +
+          ",\"screen\":\"" + screen + "\"";
+  if (!registers.empty())
+    json += ",\"registers\":" + registers;
+  return json + ",\"wall_ms\":" + wall + "}";
+}
+
+/**
+ * Read a manifest
+ * @param filename the manifest to read
+ * @return the jobs in file order
+ */
+std::vector<BatchJob> BatchJob::loadManifest(const char *filename) {
+  std::ifstream file(filename);
+  if (!file)
+    throw std::runtime_error(std::string("Can't open manifest ") + filename);
+
+  std::vector<BatchJob> jobs;
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(file, line)) {
+    lineNumber++;
+    std::string::size_type first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#')
+      continue;
+
+    try {
+      BatchJob job = parse(line);
+      job.index = (int)jobs.size();
+      jobs.push_back(job);
+    } catch (const std::exception &ex) {
+      throw std::runtime_error(std::string(filename) + ":" +
+                               std::to_string(lineNumber) + ": " + ex.what());
+    }
+  }
+  return jobs;
+}
+
+/**
+ * Parse one manifest line
+ * @param line key=value pairs and/or a bare snapshot or tape path
+ * @return the job
+ */
+BatchJob BatchJob::parse(const std::string &line) {
+  BatchJob job;
+  std::istringstream tokens(line);
+  std::string token;
+  while (tokens >> token) {
+    std::string::size_type equals = token.find('=');
+    if (equals == std::string::npos) {
+      (isTapeFile(token) ? job.tape : job.snapshot) = token;
+      continue;
+    }
+
+    std::string key = token.substr(0, equals);
+    std::string value = token.substr(equals + 1);
+    if (key == "rom")
+      job.rom = value;
+    else if (key == "snapshot")
+      job.snapshot = value;
+    else if (key == "tape")
+      job.tape = value;
+    else if (key == "input")
+      job.input = value;
+    else if (key == "wav")
+      job.wav = value;
+    else if (key == "name")
+      job.name = value;
+    else if (key == "frames") {
+      char *end = nullptr;
+      job.frames = strtol(value.c_str(), &end, 10);
+      if (value.empty() || *end || job.frames < 0)
+        throw std::runtime_error("bad frame count '" + value + "'");
+    } else {
+      throw std::runtime_error("unknown key '" + key + "'");
+    }
+  }
+
+  if (job.name.empty())
+    job.name = !job.snapshot.empty() ? job.snapshot
+               : !job.tape.empty()   ? job.tape
+                                     : job.rom;
+  return job;
+}
+
+/**
+ * Read the input script, if there is one
+ * @return key events in frame order
+ */
+std::vector<BatchJob::KeyEvent> BatchJob::loadInput() const {
+  std::vector<KeyEvent> events;
+  if (input.empty())
+    return events;
+
+  std::ifstream file(input);
+  if (!file)
+    throw std::runtime_error("Can't open input script " + input);
+
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(file, line)) {
+    lineNumber++;
+    std::istringstream fields(line);
+    KeyEvent event{};
+    std::string key, action;
+    if (!(fields >> event.frame))
+      continue; // blank or comment
+
+    fields >> key >> action;
+    key = upper(key);
+    action = upper(action);
+    bool found = false;
+    for (int row = 0; row < 8 && !found; row++) {
+      for (int bit = 0; bit < 5 && !found; bit++) {
+        if (key == KEY_NAMES[row][bit]) {
+          event.line = row;
+          event.bit = bit;
+          found = true;
+        }
+      }
+    }
+    if (!found || (action != "DOWN" && action != "UP"))
+      throw std::runtime_error(input + ":" + std::to_string(lineNumber) +
+                               ": expected <frame> <key> down|up");
+    event.pressed = action == "DOWN";
+    events.push_back(event);
+  }
+
+  std::stable_sort(events.begin(), events.end(),
+                   [](const KeyEvent &a, const KeyEvent &b) {
+                     return a.frame < b.frame;
+                   });
+  return events;
+}
+
+/**
+ * Run the job on a fresh processor
+ * @param romImage the loaded ROM named by the job
+ * @return the final state, or the error that stopped the job
+ */
+BatchResult BatchJob::run(Rom &romImage) const {
+  BatchResult result;
+  result.index = index;
+  result.name = name;
+
+  auto start = std::chrono::steady_clock::now();
+  try {
+    std::vector<KeyEvent> events = loadInput();
+    if (romImage.getSize() <= 0)
+      throw std::runtime_error("Can't load ROM " + rom);
+    if (!tape.empty())
+      checkReadable(tape);
+    if (!snapshot.empty())
+      checkReadable(snapshot);
+
+    // Outlives the processor writing to it
+    std::unique_ptr<WavAudioSink> wavSink;
+    if (!wav.empty())
+      wavSink = std::make_unique<WavAudioSink>(wav);
+
+    Processor processor;
+    processor.setAudioSink(wavSink.get());
+    processor.init(romImage);
+    processor.setTurbo(true);
+    ProcessorState &state = processor.getState();
+
+    if (!tape.empty()) {
+      processor.loadTape(TapeLoader::load(tape.c_str()));
+      state.setFastLoad(true);
+    }
+    if (!snapshot.empty())
+      processor.loadSnapshot(snapshot.c_str());
+
+    size_t nextEvent = 0;
+    long carry = 0; // frame time the next frame starts at
+    for (long frame = 0; frame < frames && processor.isRunning(); frame++) {
+      for (; nextEvent < events.size() && events[nextEvent].frame <= frame;
+           nextEvent++) {
+        const KeyEvent &event = events[nextEvent];
+        state.keyboard.setKey(event.line, event.bit, event.pressed);
+      }
+
+      processor.executeFrame();
+      long end = state.getFrameTStates();
+      result.tStates += end - carry;
+      long length = processor.getFrameLength();
+      carry = end >= length ? end - length : 0;
+      result.frames++;
+    }
+
+    result.error = processor.getLastError();
+    result.screenHash = hashScreen(state.memory.getVideoBuffer()->getBuffer());
+    result.registers = registerJson(state.registers, state);
+  } catch (const std::exception &ex) {
+    result.error = ex.what();
+  }
+
+  result.wallMs = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+  return result;
+}
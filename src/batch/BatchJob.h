@@ -0,0 +1,82 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_BATCHJOB_H
+#define ZXEMULATOR_BATCHJOB_H
+
+#include "../spectrum/Rom.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Outcome of one job, written out as a line of JSON
+struct BatchResult {
+  int index = 0;
+  std::string name;
+  std::string error; // empty when the job ran to the end
+  long frames = 0;
+  long long tStates = 0;
+  std::uint64_t screenHash = 0; // FNV-1a of the display and attributes
+  std::string registers;        // JSON object
+  double wallMs = 0;
+
+  std::string toJson() const;
+};
+
+/**
+ * One emulator run for zxbatch: a ROM, an optional snapshot or tape, a
+ * frame count and an optional input script.
+ *
+ * A manifest has one job per line as whitespace separated key=value pairs
+ * (rom, snapshot, tape, frames, input, wav, name). A bare word is taken as the
+ * snapshot, or the tape for .tap/.tzx files. Blank lines and lines
+ * starting with # are skipped.
+ *
+ * An input script has one key event per line: frame, key name and
+ * down/up, e.g. "120 J down". Keys are named as on the keyboard, plus
+ * SHIFT, SYM, ENTER and SPACE.
+ */
+class BatchJob {
+public:
+  int index = 0;
+  std::string name;
+  std::string rom = "roms/48k.bin";
+  std::string snapshot;
+  std::string tape;
+  std::string input;
+  std::string wav; // audio recording, none if empty
+  long frames = 50;
+
+  // Throws std::runtime_error naming the line at fault
+  static std::vector<BatchJob> loadManifest(const char *filename);
+  static BatchJob parse(const std::string &line);
+
+  // Run on the calling thread. The ROM is only read, so one copy can be
+  // shared by every job using it.
+  BatchResult run(Rom &romImage) const;
+
+private:
+  struct KeyEvent {
+    long frame;
+    int line;
+    int bit;
+    bool pressed;
+  };
+
+  std::vector<KeyEvent> loadInput() const;
+};
+
+#endif // ZXEMULATOR_BATCHJOB_H
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WorkStealingPool.h"
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(unsigned int threads) {
+  threadCount = threads ? threads : std::thread::hardware_concurrency();
+  if (threadCount == 0)
+    threadCount = 1;
+
+  for (unsigned int i = 0; i < threadCount; i++)
+    queues.push_back(std::make_unique<Queue>());
+}
+
+/**
+ * Deal the tasks out and run them on the workers. The calling thread acts
+ * as worker 0.
+ * @param tasks independent tasks, in no particular order
+ */
+void WorkStealingPool::run(std::vector<Task> tasks) {
+  for (size_t i = 0; i < tasks.size(); i++)
+    queues[i % threadCount]->tasks.push_back(std::move(tasks[i]));
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 1; i < threadCount; i++)
+    workers.emplace_back(&WorkStealingPool::work, this, i);
+  work(0);
+
+  for (std::thread &worker : workers)
+    worker.join();
+}
+
+/**
+ * Run tasks until every queue is empty. Nothing is queued once run() has
+ * started, so an empty sweep means there is nothing left to do.
+ * @param worker index of this worker's own queue
+ */
+void WorkStealingPool::work(unsigned int worker) {
+  Task task;
+  while (takeOwn(worker, task) || steal(worker, task)) {
+    task();
+    task = nullptr;
+  }
+}
+
+bool WorkStealingPool::takeOwn(unsigned int worker, Task &task) {
+  Queue &queue = *queues[worker];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty())
+    return false;
+  task = std::move(queue.tasks.back());
+  queue.tasks.pop_back();
+  return true;
+}
+
+bool WorkStealingPool::steal(unsigned int worker, Task &task) {
+  for (unsigned int i = 1; i < threadCount; i++) {
+    Queue &queue = *queues[(worker + i) % threadCount];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
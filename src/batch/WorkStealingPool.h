@@ -0,0 +1,58 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_WORKSTEALINGPOOL_H
+#define ZXEMULATOR_WORKSTEALINGPOOL_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Runs a fixed set of independent tasks across worker threads. Tasks are
+ * dealt round-robin onto one deque per worker. A worker takes from the
+ * back of its own deque and, once that is empty, steals from the front of
+ * the others, so a few long jobs don't leave the rest of the cores idle.
+ */
+class WorkStealingPool {
+public:
+  using Task = std::function<void()>;
+
+  // threads == 0 uses one per hardware thread
+  explicit WorkStealingPool(unsigned int threads = 0);
+
+  // Run every task, returning once all have finished
+  void run(std::vector<Task> tasks);
+
+  unsigned int getThreadCount() const { return threadCount; }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  unsigned int threadCount;
+  std::vector<std::unique_ptr<Queue>> queues;
+
+  bool takeOwn(unsigned int worker, Task &task);
+  bool steal(unsigned int worker, Task &task);
+  void work(unsigned int worker);
+};
+
+#endif // ZXEMULATOR_WORKSTEALINGPOOL_H
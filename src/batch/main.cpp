@@ -0,0 +1,113 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// zxbatch: run a manifest of emulator jobs across every core and write one
+// line of JSON per job. See BatchJob.h for the manifest format.
+
+#include "../utils/Logger.h"
+#include "BatchJob.h"
+#include "WorkStealingPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+using namespace std;
+using namespace utils;
+
+static void usage() {
+  cerr << "usage: zxbatch [-j threads] [-o results.jsonl] manifest" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  unsigned int threads = 0;
+  string outputFile;
+  string manifestFile;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if ((arg == "-j" || arg == "--jobs") && i + 1 < argc) {
+      threads = (unsigned int)atoi(argv[++i]);
+    } else if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+      outputFile = argv[++i];
+    } else if (manifestFile.empty() && arg[0] != '-') {
+      manifestFile = arg;
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (manifestFile.empty()) {
+    usage();
+    return 2;
+  }
+
+  // Results own stdout; everything the emulator logs goes to stderr
+  Logger::setOutput(cerr);
+
+  try {
+    vector<BatchJob> jobs = BatchJob::loadManifest(manifestFile.c_str());
+
+    // Each ROM is loaded once and shared, read only, by its jobs
+    map<string, unique_ptr<Rom>> roms;
+    for (const BatchJob &job : jobs) {
+      unique_ptr<Rom> &rom = roms[job.rom];
+      if (!rom)
+        rom = make_unique<Rom>(job.rom.c_str());
+    }
+
+    ofstream file;
+    if (!outputFile.empty()) {
+      file.open(outputFile);
+      if (!file)
+        throw runtime_error("Can't write " + outputFile);
+    }
+    ostream &output = outputFile.empty() ? cout : file;
+    mutex outputMutex;
+
+    vector<WorkStealingPool::Task> tasks;
+    for (const BatchJob &job : jobs) {
+      Rom *rom = roms[job.rom].get();
+      tasks.push_back([&job, rom, &output, &outputMutex]() {
+        string line = job.run(*rom).toJson();
+        lock_guard<mutex> lock(outputMutex);
+        output << line << '\n' << flush;
+      });
+    }
+
+    WorkStealingPool pool(threads);
+    auto start = chrono::steady_clock::now();
+    pool.run(move(tasks));
+    double seconds =
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    char summary[128];
+    snprintf(summary, sizeof(summary),
+             "%zu jobs on %u threads in %.2fs (%.1f jobs/s)", jobs.size(),
+             pool.getThreadCount(), seconds,
+             seconds > 0 ? jobs.size() / seconds : 0.0);
+    Logger::write(summary);
+  } catch (exception &ex) {
+    cerr << "zxbatch: " << ex.what() << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EmulatorThread.h"
+#include "../spectrum/SnapshotLoader.h"
+#include "../spectrum/TapeLoader.h"
+#include "../utils/Logger.h"
+#include <chrono>
+#include <exception>
+
+using namespace utils;
+
+EmulatorThread::EmulatorThread(Processor &processor) : processor(processor) {}
+
+EmulatorThread::~EmulatorThread() { stop(); }
+
+void EmulatorThread::start() {
+  quit = false;
+  publishFrame(); // Something to draw before the first frame is done
+  thread = std::thread(&EmulatorThread::run, this);
+}
+
+void EmulatorThread::stop() {
+  quit = true;
+  if (thread.joinable())
+    thread.join();
+}
+
+bool EmulatorThread::send(const EmulatorCommand &command) {
+  return commands.push(&command, 1) == 1;
+}
+
+/**
+ * The emulation loop: apply queued commands, run a frame, publish it and
+ * wait out the rest of the 20ms
+ */
+void EmulatorThread::run() {
+  const auto frameDuration = std::chrono::milliseconds(20); // 50Hz
+
+  while (!quit) {
+    auto start = std::chrono::steady_clock::now();
+
+    EmulatorCommand command;
+    while (commands.pop(&command, 1)) {
+      // A bad file mustn't end the thread, and the app with it; the
+      // window shows the error instead
+      try {
+        apply(command);
+      } catch (std::exception &ex) {
+        Logger::write((std::string("Error: ") + ex.what()).c_str());
+        processor.lastError = ex.what();
+        // It may have got part way, writing memory behind the cache
+        processor.getState().memory.getDecodeCache().clear();
+        processor.getState().memory.markScreenDirty();
+      }
+    }
+
+    processor.executeFrame();
+    publishFrame();
+
+    std::this_thread::sleep_until(start + frameDuration);
+  }
+}
+
+/**
+ * Carry out a command from the window
+ * @param command the command
+ */
+void EmulatorThread::apply(const EmulatorCommand &command) {
+  ProcessorState &state = processor.getState();
+  switch (command.type) {
+  case EmulatorCommand::KEY:
+    state.keyboard.setKey(command.line, command.bit, command.pressed);
+    break;
+  case EmulatorCommand::KEMPSTON:
+    state.keyboard.setKempstonKey(command.bit, command.pressed);
+    break;
+  case EmulatorCommand::PAUSE:
+    processor.pause();
+    break;
+  case EmulatorCommand::RESUME:
+    processor.resume();
+    break;
+  case EmulatorCommand::STEP:
+    processor.step();
+    break;
+  case EmulatorCommand::STEP_OVER:
+    processor.stepOver();
+    break;
+  case EmulatorCommand::STEP_OUT:
+    processor.stepOut();
+    break;
+  case EmulatorCommand::DEBUG_MODE:
+    processor.setDebugMode(command.pressed);
+    break;
+  case EmulatorCommand::BREAKPOINT:
+    processor.getDebugger().setBreakpoint(command.line, command.pressed);
+    break;
+  case EmulatorCommand::RESET:
+    processor.reset();
+    processor.pause();
+    break;
+  case EmulatorCommand::LOAD_FILE: {
+    const std::string &file = *command.path;
+    Logger::write(("Loading pending file: " + file).c_str());
+    std::string ext;
+    if (file.find_last_of(".") != std::string::npos) {
+      ext = file.substr(file.find_last_of(".") + 1);
+      for (auto &c : ext)
+        c = tolower(c);
+    }
+    if (ext == "tap" || ext == "tzx") {
+      processor.loadTape(TapeLoader::load(file.c_str()));
+      state.setFastLoad(true);
+    } else {
+      processor.loadSnapshot(file.c_str());
+    }
+    break;
+  }
+  case EmulatorCommand::SAVE_SNAPSHOT:
+    SnapshotLoader::exportSNA(command.path->c_str(), state);
+    break;
+  }
+}
+
+/**
+ * Copy what the window needs out of the processor and hand it over
+ */
+void EmulatorThread::publishFrame() {
+  PresentedFrame &frame = frames.writeBuffer();
+  Memory &memory = processor.getState().memory;
+  frame.number = ++frameNumber;
+  processor.getVideoBuffer()->copyTo(frame.video);
+  frame.video.dirty = memory.getDirtyCells();
+  memory.clearDirtyCells();
+  frame.registers = processor.getState().registers;
+  frame.idleTStatesSkipped = processor.getStats().idleTStatesSkipped;
+  frame.running = processor.isRunning();
+  frame.paused = processor.isPaused();
+  frame.lastError = processor.getLastError();
+  frames.publish();
+}
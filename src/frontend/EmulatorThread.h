@@ -0,0 +1,99 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_EMULATORTHREAD_H
+#define ZXEMULATOR_EMULATORTHREAD_H
+
+#include "../spectrum/Processor.h"
+#include "../utils/SpscRing.h"
+#include "../utils/TripleBuffer.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+// A request from the window to the emulation thread
+struct EmulatorCommand {
+  enum Type {
+    KEY,      // line, bit, pressed
+    KEMPSTON, // bit, pressed
+    PAUSE,
+    RESUME,
+    STEP,
+    STEP_OVER,
+    STEP_OUT,
+    DEBUG_MODE, // pressed: run the debug loop from the next frame
+    BREAKPOINT, // line: address, pressed: set or clear
+    RESET,      // and pause
+    LOAD_FILE,
+    SAVE_SNAPSHOT
+  };
+
+  Type type = KEY;
+  int line = 0;
+  int bit = 0;
+  bool pressed = false;
+  std::shared_ptr<const std::string> path; // LOAD_FILE and SAVE_SNAPSHOT
+};
+
+// Everything the window shows for one emulated frame
+struct PresentedFrame {
+  long number = 0; // Counts up, so a gap means frames were dropped
+  VideoFrame video;
+  Z80Registers registers;
+  long idleTStatesSkipped = 0;
+  bool running = false;
+  bool paused = false;
+  std::string lastError;
+};
+
+/**
+ * Runs the processor on its own thread so a slow display, or a file dialog
+ * holding up the window, doesn't stall emulation or audio. Finished frames
+ * are published through a triple buffer and commands come back through a
+ * lock-free queue; the window never touches the processor directly.
+ */
+class EmulatorThread {
+private:
+  Processor &processor;
+  std::thread thread;
+  std::atomic<bool> quit{false};
+  long frameNumber = 0;
+
+  utils::SpscRing<EmulatorCommand, 256> commands;
+  utils::TripleBuffer<PresentedFrame> frames;
+
+  void run();
+  void apply(const EmulatorCommand &command);
+  void publishFrame();
+
+public:
+  // The processor belongs to the thread from start() until stop()
+  explicit EmulatorThread(Processor &processor);
+  ~EmulatorThread();
+
+  void start();
+  void stop();
+
+  // Window thread only. Returns false if the queue was full.
+  bool send(const EmulatorCommand &command);
+
+  // Window thread only: move on to the newest frame, if there is one
+  bool nextFrame() { return frames.update(); }
+  const PresentedFrame &getFrame() const { return frames.readBuffer(); }
+};
+
+#endif // ZXEMULATOR_EMULATORTHREAD_H
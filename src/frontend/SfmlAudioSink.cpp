@@ -0,0 +1,84 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SfmlAudioSink.h"
+#include "../spectrum/Audio.h"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <thread>
+
+SfmlAudioSink::SfmlAudioSink() {
+  std::vector<sf::SoundChannel> channelMap = {sf::SoundChannel::Mono};
+  initialize(1, Audio::SAMPLE_RATE, channelMap);
+}
+
+SfmlAudioSink::~SfmlAudioSink() { stop(); }
+
+void SfmlAudioSink::start() {
+  reset();
+  play();
+}
+
+/**
+ * Top the ring up to the prefill with silence. Only the audio thread may
+ * take samples out, so anything already queued stays and plays out.
+ */
+void SfmlAudioSink::reset() {
+  static const std::int16_t silence[PREFILL_SAMPLES] = {};
+  std::size_t queued = ring.size();
+  if (queued < PREFILL_SAMPLES)
+    ring.push(silence, PREFILL_SAMPLES - queued);
+}
+
+void SfmlAudioSink::write(const std::int16_t *data, std::size_t count) {
+  std::size_t written = ring.push(data, count);
+  if (written < count)
+    overruns += count - written;
+}
+
+/**
+ * Wait while more than a few frames are queued. This locks emulation speed
+ * to the audio card clock (44.1kHz).
+ */
+void SfmlAudioSink::throttle() {
+  while (ring.size() > MAX_QUEUED_SAMPLES) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+bool SfmlAudioSink::onGetData(Chunk &data) {
+  std::size_t count = ring.pop(samples, std::size(samples));
+
+  // If the ring is empty (underrun), play the last sample to maintain DC
+  // level
+  if (count == 0) {
+    underruns++;
+    count = 10;
+    std::fill(samples, samples + count, lastSample);
+  }
+
+  lastSample = samples[count - 1];
+
+  data.samples = samples;
+  data.sampleCount = count;
+
+  return true;
+}
+
+void SfmlAudioSink::onSeek(sf::Time timeOffset) {
+  // Not supported/needed for emulation stream
+}
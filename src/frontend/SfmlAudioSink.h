@@ -0,0 +1,65 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_SFMLAUDIOSINK_H
+#define ZXEMULATOR_SFMLAUDIOSINK_H
+
+#include "../spectrum/AudioSink.h"
+#include "../utils/SpscRing.h"
+#include <SFML/Audio.hpp>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Plays the processor's audio through SFML. Lives in the front end so the
+ * core never links against an audio device. Samples pass from the
+ * emulation thread to SFML's audio thread through a lock-free ring, so
+ * neither thread can stall the other, and throttle() holds the emulator
+ * back while the ring is filling up.
+ */
+class SfmlAudioSink : public AudioSink, private sf::SoundStream {
+private:
+  // About 185ms, room for the queue below plus a few frames in turbo
+  utils::SpscRing<std::int16_t, 8192> ring;
+  std::int16_t samples[1024]; // Being played by SFML
+  std::int16_t lastSample = 0;
+
+  std::atomic<long> underruns{0}; // times SFML found the ring empty
+  std::atomic<long> overruns{0};  // samples dropped with the ring full
+
+  // About 45ms of silence queued on start, so a slow first frame doesn't
+  // underrun, and 3 frames (60ms) queued before emulation waits
+  static constexpr std::size_t PREFILL_SAMPLES = 2000;
+  static constexpr std::size_t MAX_QUEUED_SAMPLES = 2646;
+
+  virtual bool onGetData(Chunk &data) override;
+  virtual void onSeek(sf::Time timeOffset) override;
+
+public:
+  SfmlAudioSink();
+  virtual ~SfmlAudioSink();
+
+  void start();
+
+  void write(const std::int16_t *data, std::size_t count) override;
+  void throttle() override;
+  void reset() override;
+
+  long getUnderruns() const { return underruns; }
+  long getOverruns() const { return overruns; }
+};
+
+#endif // ZXEMULATOR_SFMLAUDIOSINK_H
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include "frontend/EmulatorThread.h"
+#include "frontend/SfmlAudioSink.h"
 #include "spectrum/Processor.h"
 #include "spectrum/TapeLoader.h"
 #include "spectrum/video/Screen.h"
@@ -97,10 +99,19 @@ int main(int argc, char *argv[]) {
     Logger::write("Starting ZX Spectrum Emulator v0.4.1");
     Logger::write(("Loading ROM from: " + romFileLocation).c_str());
 
+    // Play the beeper through the sound card. Declared first so it
+    // outlives the processor writing to it.
+    SfmlAudioSink audioSink;
+
     // Create a processor and load the basic ROM
     Processor processor;
     processor.init(romFileLocation.c_str());
     // processor.setFastLoad(fastLoad); // Will add this method
+    // Show mid-frame screen writes where the beam met them
+    processor.setBeamRacing(true);
+
+    processor.setAudioSink(&audioSink);
+    audioSink.start();
 
     if (!tapeFile.empty()) {
       Tape tape = TapeLoader::load(tapeFile.c_str());
@@ -116,18 +127,21 @@ int main(int argc, char *argv[]) {
 
     // Debug: Check ROM integrity at 0x0672
     // byte b = processor.getState().memory.getByte(0x0672); // Need access?
-    // ProcessorState exposes memory. Memory exposes [] or dump.
-    // memory[0x0672]
-    printf("ROM[0672] = %02X\n", (int)processor.getState().memory[0x0672]);
+    // ProcessorState exposes memory. Memory exposes fastRead or dump.
+    printf("ROM[0672] = %02X\n",
+           (int)processor.getState().memory.fastRead(0x0672));
 
     // Create the screen
     Screen *screen = Screen::Factory();
-    screen->init(processor.getVideoBuffer());
-    screen->setProcessor(&processor);
+    screen->init();
+
+    EmulatorThread emulator(processor);
+    screen->setEmulator(&emulator);
 
     screen->show();
 
     if (debugMode) {
+      processor.setDebugMode(true);
       processor.pause();
       screen->setDebugMode(true);
     }
@@ -136,48 +150,32 @@ int main(int argc, char *argv[]) {
     platform::mac::installFileHandler(handleMacOpenFile);
 #endif
 
-    auto frameDuration = std::chrono::milliseconds(20); // 50Hz
+    // From here on the processor belongs to the emulation thread
+    emulator.start();
 
     while (screen->processEvents()) {
       // Check for pending file load (from Drag & Drop or Mac Open Event)
       if (!g_pendingLoadFile.empty()) {
-        std::string fileToLoad = g_pendingLoadFile;
+        EmulatorCommand command;
+        command.type = EmulatorCommand::LOAD_FILE;
+        command.path = std::make_shared<const std::string>(g_pendingLoadFile);
         g_pendingLoadFile = "";
-
-        Logger::write(("Loading pending file: " + fileToLoad).c_str());
-        std::string fn = fileToLoad;
-        std::string ext = "";
-        if (fn.find_last_of(".") != std::string::npos) {
-          ext = fn.substr(fn.find_last_of(".") + 1);
-          for (auto &c : ext)
-            c = tolower(c);
-        }
-
-        // Simple detection logic duplicated from main arg parsing
-        // Ideal refactor: move 'loadFile' to Processor or Loader class
-        if (ext == "tap" || ext == "tzx") {
-          Tape tape = TapeLoader::load(fileToLoad.c_str());
-          processor.loadTape(tape);
-          processor.getState().setFastLoad(true);
-        } else {
-          processor.loadSnapshot(fileToLoad.c_str());
-        }
+        emulator.send(command);
       }
 
-      auto start = std::chrono::high_resolution_clock::now();
-
-      processor.executeFrame();
-      screen->update();
-
-      auto end = std::chrono::high_resolution_clock::now();
-      auto elapsed =
-          std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-
-      if (elapsed < frameDuration) {
-        std::this_thread::sleep_for(frameDuration - elapsed);
-      }
+      // Draw whenever the emulator has finished a frame
+      if (emulator.nextFrame())
+        screen->update(emulator.getFrame());
+      else
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
     }
 
+    emulator.stop();
+    Logger::write(("Audio underruns: " +
+                   std::to_string(audioSink.getUnderruns()) +
+                   ", samples dropped: " +
+                   std::to_string(audioSink.getOverruns()))
+                      .c_str());
   } catch (exception &ex) {
     printf("Error: %s", ex.what());
   }
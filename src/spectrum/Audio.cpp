@@ -15,111 +15,116 @@
  */
 
 #include "Audio.h"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
-Audio::Audio() {
-  // Precise timing for 50Hz frame structure (69888 T-States per frame)
-  // We need exactly 44100/50 = 882 samples per frame.
-  // 69888 / 882 = 79.238095...
-  tStatesPerSample = 69888.0 / ((double)SAMPLE_RATE / 50.0);
-  tStateAccumulator = 0.0;
+namespace {
 
-  // Reserve logical buffer size
-  buffer.reserve(44100);
-
-  std::vector<sf::SoundChannel> channelMap = {sf::SoundChannel::Mono};
-  initialize(1, SAMPLE_RATE, channelMap);
-}
-
-Audio::~Audio() { stop(); }
-
-void Audio::start() { play(); }
-
-void Audio::reset() {
-  stop();
-  {
-    std::lock_guard<std::mutex> lock(mutex);
-    buffer.clear();
-    samples.clear();
-    // Pre-fill buffer with ~45ms of silence to start with cushion
-    // This prevents immediate underrun if emulation thread is slightly delayed
-    buffer.resize(2000, 0);
+/**
+ * Band-limited step kernels, one row per sub-sample phase. Each row is the
+ * difference of a windowed sinc step, scaled so it sums to exactly 1 << 15;
+ * integrating the deltas then settles on the new level with no drift.
+ */
+struct StepKernels {
+  std::int32_t rows[Audio::KERNEL_PHASES][Audio::KERNEL_WIDTH];
+
+  StepKernels() {
+    const double pi = 3.14159265358979323846;
+    const double cutoff = 0.45; // Of the sample rate, just under Nyquist
+    const double half = Audio::KERNEL_WIDTH / 2;
+
+    for (int phase = 0; phase < Audio::KERNEL_PHASES; phase++) {
+      double taps[Audio::KERNEL_WIDTH];
+      double total = 0;
+      for (int i = 0; i < Audio::KERNEL_WIDTH; i++) {
+        double x = i - half - (double)phase / Audio::KERNEL_PHASES;
+        double sinc = x == 0 ? 1 : std::sin(2 * pi * cutoff * x) /
+                                       (2 * pi * cutoff * x);
+        double window = 0.42 + 0.5 * std::cos(pi * x / half) +
+                        0.08 * std::cos(2 * pi * x / half); // Blackman
+        taps[i] = std::fabs(x) < half ? sinc * window : 0;
+        total += taps[i];
+      }
+
+      std::int32_t rounded = 0;
+      int peak = 0;
+      for (int i = 0; i < Audio::KERNEL_WIDTH; i++) {
+        rows[phase][i] = (std::int32_t)std::lround(taps[i] / total * 32768);
+        rounded += rows[phase][i];
+        if (rows[phase][i] > rows[phase][peak])
+          peak = i;
+      }
+      rows[phase][peak] += 32768 - rounded;
+    }
   }
-  tStateAccumulator = 0;
-  play();
-}
-
-void Audio::update(int tStates, bool speakerBit, bool earBit) {
-  tStateAccumulator += tStates;
-
-  while (tStateAccumulator >= tStatesPerSample) {
-    tStateAccumulator -= tStatesPerSample;
+};
 
-    // Sample logic:
-    // Speaker bit (0/1) + Ear bit (0/1)
-    short sampleValue = 0;
-
-    if (speakerBit)
-      sampleValue += 20000;
-    if (earBit)
-      sampleValue += 8000;
-
-    // Store in local pending buffer (no lock needed)
-    pendingSamples.push_back(sampleValue);
-  }
+const StepKernels kernels;
 
-  // Auto-flush small chunks to keep the stream fluid
-  if (pendingSamples.size() >= 100) {
-    flush();
-  }
-}
+} // namespace
 
-void Audio::flush() {
-  if (pendingSamples.empty())
-    return;
+Audio::Audio(AudioSink &sink) : sink(&sink) {}
 
-  std::lock_guard<std::mutex> lock(mutex);
-  buffer.insert(buffer.end(), pendingSamples.begin(), pendingSamples.end());
-  pendingSamples.clear();
+void Audio::reset() {
+  level = 0;
+  sum = 0;
+  std::fill(std::begin(deltas), std::end(deltas), 0);
+  sink->reset();
 }
 
-size_t Audio::getBufferSize() {
-  std::lock_guard<std::mutex> lock(mutex);
-  return buffer.size();
+/**
+ * Add a band-limited step at a frame time
+ * @param tStates the frame time of the edge, within the frame
+ * @param delta the change in level
+ */
+void Audio::addStep(int tStates, int delta) {
+  // Position in 1/KERNEL_PHASES of a sample, rounded
+  long position = ((long)tStates * SAMPLES_PER_FRAME * KERNEL_PHASES +
+                   frameTStates / 2) /
+                  frameTStates;
+  std::int64_t *out = deltas + position / KERNEL_PHASES;
+  const std::int32_t *row = kernels.rows[position % KERNEL_PHASES];
+  for (int i = 0; i < KERNEL_WIDTH; i++)
+    out[i] += (std::int64_t)delta * row[i];
 }
 
-bool Audio::onGetData(Chunk &data) {
-  std::lock_guard<std::mutex> lock(mutex);
-
-  static std::int16_t lastSample = 0;
-
-  // If buffer is empty (underrun), return last sample to maintain DC level
-  if (buffer.empty()) {
-    static std::int16_t underrunBuffer[10];
-    std::fill(std::begin(underrunBuffer), std::end(underrunBuffer), lastSample);
-
-    data.samples = underrunBuffer;
-    data.sampleCount = 10;
-    return true;
+/**
+ * Render the frame's edges and write the samples up to the frame time
+ * reached. Edges past the end of the frame are kept for the next one,
+ * moved to its frame time.
+ * @param edges level changes in time order, left holding the carried ones
+ * @param endTStates the frame time the processor reached
+ */
+void Audio::renderFrame(std::vector<AudioEdge> &edges, int endTStates) {
+  size_t carried = 0;
+  for (const AudioEdge &edge : edges) {
+    if (edge.tStates >= frameTStates) {
+      edges[carried++] = {edge.tStates - frameTStates, edge.level};
+      continue;
+    }
+    addStep(std::max(edge.tStates, 0), edge.level - level);
+    level = edge.level;
   }
-
-  // Return all available data
-  // Use swap to avoid copying data and minimize time holding the lock
-  samples.swap(buffer);
-
-  // Clear the buffer (now containing old samples data) to keep capacity
-  buffer.clear();
-
-  if (!samples.empty()) {
-    lastSample = samples.back();
+  edges.resize(carried);
+
+  // Samples due before the end, a full frame's worth unless paused
+  int end = std::min(std::max(endTStates, 0), frameTStates);
+  int count = (int)(((long)end * SAMPLES_PER_FRAME + frameTStates - 1) /
+                    frameTStates);
+
+  for (int i = 0; i < count; i++) {
+    sum += deltas[i];
+    std::int64_t value = (sum + (1 << 14)) >> 15;
+    samples[i] = (std::int16_t)std::min<std::int64_t>(
+        std::max<std::int64_t>(value, INT16_MIN), INT16_MAX);
   }
 
-  data.samples = samples.data();
-  data.sampleCount = samples.size();
-
-  return true;
-}
+  // The tails of the last steps start the next frame
+  const int total = SAMPLES_PER_FRAME + KERNEL_WIDTH;
+  std::memmove(deltas, deltas + count, (total - count) * sizeof(deltas[0]));
+  std::fill(deltas + total - count, deltas + total, 0);
 
-void Audio::onSeek(sf::Time timeOffset) {
-  // Not supported/needed for emulation stream
+  if (count)
+    sink->write(samples, count);
 }
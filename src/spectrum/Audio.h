@@ -18,38 +18,64 @@
 #define ZXEMULATOR_AUDIO_H
 
 #include "../utils/BaseTypes.h"
-#include <SFML/Audio.hpp>
+#include "AudioSink.h"
+#include "MachineModel.h"
 #include <cstdint>
-#include <mutex>
 #include <vector>
 
-class Audio : public sf::SoundStream {
-private:
-  std::vector<std::int16_t> pendingSamples;
-  std::vector<std::int16_t> samples;
-  std::mutex mutex;
-  std::vector<std::int16_t> buffer;
-
-  double tStatesPerSample;
-  double tStateAccumulator;
+// The speaker and EAR output level from a frame time onwards
+struct AudioEdge {
+  int tStates;
+  std::int16_t level;
+};
 
+/**
+ * Beeper and EAR synthesis. The processor records level changes against
+ * frame time as they happen and once a frame they are rendered as
+ * band-limited steps (BLEP): each edge adds a windowed sinc step at its
+ * sub-sample position, so nothing is done per instruction and the square
+ * waves don't alias. The frame's samples go to an AudioSink in one batch.
+ */
+class Audio {
+public:
   // Approximate sample rate
-  const unsigned int SAMPLE_RATE = 44100;
-  // T-states per second approx 3.5MHz
-  const double CPU_FREQUENCY = 3500000.0;
+  static constexpr unsigned int SAMPLE_RATE = 44100;
+  // Exactly 44100/50, so a sample every 79.238 T-states on a 48K
+  static constexpr int SAMPLES_PER_FRAME = SAMPLE_RATE / 50;
+
+  // Step kernel length in samples and sub-sample positions per sample.
+  // Output lags the edges by half the kernel.
+  static constexpr int KERNEL_WIDTH = 16;
+  static constexpr int KERNEL_PHASES = 64;
 
-  virtual bool onGetData(Chunk &data) override;
-  virtual void onSeek(sf::Time timeOffset) override;
+private:
+  AudioSink *sink;
+  int frameTStates = Spectrum48K::FRAME_TSTATES;
+
+  std::int16_t level = 0; // Level after the last rendered edge
+  std::int64_t sum = 0;   // Running total of the deltas, 15 bit fraction
+  std::int64_t deltas[SAMPLES_PER_FRAME + KERNEL_WIDTH] = {};
+  std::int16_t samples[SAMPLES_PER_FRAME];
+
+  void addStep(int tStates, int delta);
 
 public:
-  Audio();
-  virtual ~Audio();
+  explicit Audio(AudioSink &sink);
 
-  void update(int tStates, bool speakerBit, bool earBit);
-  void flush();
-  size_t getBufferSize();
-  void start();
+  // Output level for the speaker and EAR bits
+  static std::int16_t levelFor(bool speakerBit, bool earBit) {
+    return (speakerBit ? 20000 : 0) + (earBit ? 8000 : 0);
+  }
+
+  void renderFrame(std::vector<AudioEdge> &edges, int endTStates);
   void reset();
+
+  // Frame length of the machine, spread over SAMPLES_PER_FRAME samples
+  void setFrameTStates(int value) { frameTStates = value; }
+  int getFrameTStates() const { return frameTStates; }
+
+  void setSink(AudioSink &value) { sink = &value; }
+  AudioSink &getSink() const { return *sink; }
 };
 
 #endif // ZXEMULATOR_AUDIO_H
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_AUDIOSINK_H
+#define ZXEMULATOR_AUDIOSINK_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Where the processor's audio goes. Samples are mono, signed 16-bit at
+ * Audio::SAMPLE_RATE and arrive in order from the emulation thread.
+ */
+class AudioSink {
+public:
+  virtual ~AudioSink() = default;
+
+  // False when samples would only be thrown away. The processor then
+  // skips generating them altogether.
+  virtual bool wantsSamples() const { return true; }
+
+  virtual void write(const std::int16_t *samples, std::size_t count) = 0;
+
+  // Called once per frame unless running in turbo. A sink playing in real
+  // time blocks here to hold the emulator to its clock.
+  virtual void throttle() {}
+
+  // The processor was reset; drop anything queued
+  virtual void reset() {}
+};
+
+// Discards everything, without samples ever being generated
+class NullAudioSink : public AudioSink {
+public:
+  bool wantsSamples() const override { return false; }
+  void write(const std::int16_t *, std::size_t) override {}
+};
+
+#endif // ZXEMULATOR_AUDIOSINK_H
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_DEBUGBUS_H
+#define ZXEMULATOR_DEBUGBUS_H
+
+#include "Debugger.h"
+#include "ProcessorState.h"
+#include "Z80State.h"
+
+/**
+ * The Spectrum's bus with the debugger listening: accesses go to the
+ * ProcessorState as usual and are noted for the watchpoints on the way.
+ *
+ * The handlers get a copy of their own for this bus, so the watchpoint
+ * checks cost nothing when not debugging. The debug loop loads the CPU
+ * state into the bus before each instruction and stores it back after.
+ */
+class DebugBus : public Z80State {
+public:
+  DebugBus(ProcessorState &state, Debugger &debugger)
+      : state(state), debugger(debugger) {}
+
+  void load() { static_cast<Z80State &>(*this) = state; }
+  void store() { static_cast<Z80State &>(state) = *this; }
+
+  // Bus accesses, see Z80State. Opcode fetches aren't watched, as
+  // breakpoints stop those.
+  byte fetch(word address) const { return state.fetch(address); }
+  byte read(word address) {
+    debugger.noteMemory(address, Debugger::READ);
+    return state.read(address);
+  }
+  void write(word address, byte value) {
+    debugger.noteMemory(address, Debugger::WRITE);
+    state.write(address, value);
+  }
+  byte in(word port) {
+    debugger.notePort(port, Debugger::READ);
+    return state.in(port);
+  }
+  void out(word port, byte value) {
+    debugger.notePort(port, Debugger::WRITE);
+    state.out(port, value);
+  }
+
+private:
+  ProcessorState &state;
+  Debugger &debugger;
+};
+
+#endif // ZXEMULATOR_DEBUGBUS_H
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Debugger.h"
+#include <algorithm>
+
+/**
+ * Stop before running the instruction at an address
+ * @param address the first byte of the instruction
+ * @param set false to remove the breakpoint
+ */
+void Debugger::setBreakpoint(emulator_types::word address, bool set) {
+  if (set)
+    m_memory[address] |= BREAKPOINT;
+  else
+    m_memory[address] &= ~BREAKPOINT;
+}
+
+/**
+ * Stop after an instruction reads or writes an address
+ * @param address the address
+ * @param access READ, WRITE, both, or 0 to stop watching
+ */
+void Debugger::watchMemory(emulator_types::word address,
+                           emulator_types::byte access) {
+  m_memory[address] = (m_memory[address] & BREAKPOINT) | access;
+}
+
+/**
+ * Stop after an IN or OUT on any port where (port & mask) == match
+ * @param mask the address lines to compare
+ * @param match their value
+ * @param access READ for IN, WRITE for OUT, both, or 0 to stop watching
+ */
+void Debugger::watchPort(emulator_types::word mask, emulator_types::word match,
+                         emulator_types::byte access) {
+  for (int port = 0; port < 0x10000; port++) {
+    if ((port & mask) == match)
+      m_ports[port] = access;
+  }
+}
+
+void Debugger::clear() {
+  std::fill(m_memory.begin(), m_memory.end(), 0);
+  std::fill(m_ports.begin(), m_ports.end(), 0);
+  resetStop();
+}
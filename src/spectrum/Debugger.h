@@ -0,0 +1,94 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_DEBUGGER_H
+#define ZXEMULATOR_DEBUGGER_H
+
+#include "../utils/BaseTypes.h"
+#include <vector>
+
+/**
+ * Breakpoints and watchpoints, for the processor's debug run loop.
+ *
+ * Each address and each port has a byte of flags, so checking an access
+ * is a single lookup. Watched ports are set like PortMap devices, on every
+ * port whose decoded lines match, so a watch on the ULA sees every even
+ * port. Only the debug loop looks at any of this; the fast loop has no
+ * hooks at all.
+ */
+class Debugger {
+public:
+  // Accesses to watch, on memory or on a port (IN and OUT)
+  static constexpr emulator_types::byte READ = 0x01;
+  static constexpr emulator_types::byte WRITE = 0x02;
+
+  // Why the debug loop last stopped
+  enum class StopReason {
+    NONE,
+    STEP,        // A single step, step over or step out finished
+    BREAKPOINT,  // About to run the instruction at address
+    MEMORY_READ, // The last instruction touched a watched address
+    MEMORY_WRITE,
+    PORT_IN, // Or a watched port
+    PORT_OUT
+  };
+  struct Stop {
+    StopReason reason = StopReason::NONE;
+    emulator_types::word address = 0;
+  };
+
+  Debugger() : m_memory(0x10000), m_ports(0x10000) {}
+
+  void setBreakpoint(emulator_types::word address, bool set = true);
+  bool isBreakpoint(emulator_types::word address) const {
+    return m_memory[address] & BREAKPOINT;
+  }
+  // Watch READ and/or WRITE accesses to an address, or stop watching it
+  void watchMemory(emulator_types::word address, emulator_types::byte access);
+  // Watch IN (READ) and/or OUT (WRITE) on ports where (port & mask) == match
+  void watchPort(emulator_types::word mask, emulator_types::word match,
+                 emulator_types::byte access);
+  void clear();
+
+  // Note accesses as the debug loop makes them
+  void noteMemory(emulator_types::word address, emulator_types::byte access) {
+    if (m_memory[address] & access)
+      stop(access == READ ? StopReason::MEMORY_READ : StopReason::MEMORY_WRITE,
+           address);
+  }
+  void notePort(emulator_types::word port, emulator_types::byte access) {
+    if (m_ports[port] & access)
+      stop(access == READ ? StopReason::PORT_IN : StopReason::PORT_OUT, port);
+  }
+
+  // The first reason to stop since the last reset
+  void stop(StopReason reason, emulator_types::word address) {
+    if (m_stop.reason == StopReason::NONE)
+      m_stop = {reason, address};
+  }
+  bool isStopping() const { return m_stop.reason != StopReason::NONE; }
+  const Stop &getStop() const { return m_stop; }
+  void resetStop() { m_stop = Stop(); }
+
+private:
+  static constexpr emulator_types::byte BREAKPOINT = 0x04;
+
+  std::vector<emulator_types::byte> m_memory; // READ, WRITE and BREAKPOINT
+  std::vector<emulator_types::byte> m_ports;  // READ and WRITE
+  Stop m_stop;
+};
+
+#endif // ZXEMULATOR_DEBUGGER_H
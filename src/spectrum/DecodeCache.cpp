@@ -0,0 +1,53 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DecodeCache.h"
+
+/**
+ * Keep a recorded block and mark the bytes it was recorded from
+ * @param block the block, keyed by its start address
+ */
+void DecodeCache::storeBlock(std::unique_ptr<Block> block) {
+  for (int i = 0; i < block->span; i++)
+    m_covered[(emulator_types::word)(block->start + i)] |= COVERED_BLOCK;
+  markCode(block->start, block->span);
+  m_blocks[block->start] = std::move(block);
+}
+
+/**
+ * Drop every block covering a written address
+ * @param address the address written
+ */
+void DecodeCache::dropBlocks(emulator_types::word address) {
+  for (int i = 0; i < MAX_BLOCK_SPAN; i++) {
+    std::unique_ptr<Block> &block =
+        m_blocks[(emulator_types::word)(address - i)];
+    if (block && i < block->span)
+      block.reset();
+  }
+}
+
+/**
+ * Forget all decoded code, used after memory is replaced wholesale
+ */
+void DecodeCache::clear() {
+  m_entries.assign(m_entries.size(), Entry());
+  m_covered.assign(m_covered.size(), 0);
+  for (std::unique_ptr<Block> &block : m_blocks)
+    block.reset();
+  m_codeSlots = 0;
+  m_generation++;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_DECODECACHE_H
+#define ZXEMULATOR_DECODECACHE_H
+
+#include "../utils/BaseTypes.h"
+#include <memory>
+#include <vector>
+
+class ProcessorState;
+
+// An instruction resolved to the handler that executes it on a Bus
+template <class Bus> struct DecodedInstruction {
+  int (*handler)(Bus &state) = nullptr; // nullptr when it needs decoding
+  emulator_types::byte skip = 0; // prefix and opcode bytes already consumed
+  emulator_types::byte flags = 0;
+};
+
+/**
+ * Predecoded instructions and recorded blocks keyed by address.
+ *
+ * Each entry holds the handler an instruction resolves to once its prefix
+ * bytes have been walked, so repeated execution of the same code is a single
+ * indirect call. Operands are still read by the handler, straight from memory,
+ * as an entry is only kept while the bytes it was decoded from are unchanged.
+ *
+ * A block is a run of entries recorded as they executed. Every instruction
+ * but the last always falls through to the next one, so the block can be
+ * replayed without decoding or peripheral updates between instructions.
+ *
+ * Memory invalidates entries and blocks as RAM is written. The ROM is never
+ * written so ROM code lives until the cache is cleared, or until paging
+ * maps a different bank into its 16K slot.
+ */
+class DecodeCache {
+public:
+  // Entry flags
+  static constexpr emulator_types::byte ENDS_BLOCK = 0x01; // may jump or HALT
+  static constexpr emulator_types::byte PORT_IO = 0x02;    // IN / OUT
+  static constexpr emulator_types::byte REPEATS = 0x04;    // LDIR, CPIR...
+
+  // Entries are for the Spectrum's bus
+  using Entry = DecodedInstruction<ProcessorState>;
+
+  struct Block {
+    std::vector<Entry> ops;
+    emulator_types::word start = 0;
+    int span = 0; // bytes covered from start
+  };
+
+  // Longest Z80 instruction (DD CB d op), so a write can only change an
+  // instruction starting up to this many bytes earlier
+  static constexpr int MAX_INSTRUCTION_LENGTH = 4;
+  // Longest run of code a block may cover
+  static constexpr int MAX_BLOCK_SPAN = 64;
+  // Memory is paged in 16K slots
+  static constexpr int SLOT_SHIFT = 14;
+
+  DecodeCache()
+      : m_entries(0x10000), m_covered(0x10000), m_blocks(0x10000) {}
+
+  const Entry &operator[](emulator_types::word address) const {
+    return m_entries[address];
+  }
+
+  void store(emulator_types::word address, const Entry &entry) {
+    m_entries[address] = entry;
+    for (int i = 0; i < MAX_INSTRUCTION_LENGTH; i++)
+      m_covered[(emulator_types::word)(address + i)] |= COVERED_ENTRY;
+    markCode(address, MAX_INSTRUCTION_LENGTH);
+  }
+
+  const Block *block(emulator_types::word address) const {
+    return m_blocks[address].get();
+  }
+
+  void storeBlock(std::unique_ptr<Block> block);
+
+  // Bumped whenever cached code is invalidated. A block being recorded or
+  // replayed stops as soon as this changes.
+  unsigned long getGeneration() const { return m_generation; }
+
+  // A byte has been written: drop everything that could include it. Most
+  // writes are to data, which the covered map lets us skip cheaply.
+  inline void invalidate(emulator_types::word address) {
+    emulator_types::byte covered = m_covered[address];
+    if (!covered)
+      return;
+    m_covered[address] = 0;
+    m_generation++;
+    for (int i = 0; i < MAX_INSTRUCTION_LENGTH; i++)
+      m_entries[(emulator_types::word)(address - i)].handler = nullptr;
+    if (covered & COVERED_BLOCK)
+      dropBlocks(address);
+  }
+
+  // A different bank is mapped at a slot: drop everything cached from the
+  // old one. Free unless code from the slot was cached.
+  void invalidateSlot(int slot) {
+    if (!(m_codeSlots & (1u << slot)))
+      return;
+    m_codeSlots &= ~(1u << slot);
+    for (int i = 0; i < (1 << SLOT_SHIFT); i++)
+      invalidate((emulator_types::word)((slot << SLOT_SHIFT) + i));
+  }
+
+  void clear();
+
+private:
+  static constexpr emulator_types::byte COVERED_ENTRY = 0x01;
+  static constexpr emulator_types::byte COVERED_BLOCK = 0x02;
+
+  std::vector<Entry> m_entries;
+  // Marks every byte that may belong to a decoded instruction or block
+  std::vector<emulator_types::byte> m_covered;
+  std::vector<std::unique_ptr<Block>> m_blocks;
+  unsigned long m_generation = 0;
+  unsigned m_codeSlots = 0; // Slots holding cached code, a bit each
+
+  void markCode(emulator_types::word address, int length) {
+    m_codeSlots |= 1u << (address >> SLOT_SHIFT);
+    m_codeSlots |=
+        1u << ((emulator_types::word)(address + length - 1) >> SLOT_SHIFT);
+  }
+
+  void dropBlocks(emulator_types::word address);
+};
+
+#endif // ZXEMULATOR_DECODECACHE_H
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_EVENTSCHEDULER_H
+#define ZXEMULATOR_EVENTSCHEDULER_H
+
+#include <climits>
+
+/**
+ * T-state times, within the current frame, at which something outside the
+ * CPU needs attention.
+ *
+ * The run loop executes instructions without touching the peripherals until
+ * the earliest scheduled event, then brings them up to date in one go. Port
+ * accesses (beeper, border, keyboard and EAR reads) are synchronous and are
+ * handled by the run loop as they are reached.
+ */
+class EventScheduler {
+public:
+  enum Event {
+    FRAME_END, // next interrupt
+    TAPE_EDGE, // EAR input changes
+    SCANLINE,  // beam starts a display line
+    EVENT_COUNT
+  };
+
+  static constexpr int NEVER = INT_MAX;
+
+  void schedule(Event event, int time) { times[event] = time; }
+  void cancel(Event event) { times[event] = NEVER; }
+  int timeOf(Event event) const { return times[event]; }
+
+  // Time of the earliest pending event
+  int nextTime() const {
+    int next = NEVER;
+    for (int time : times)
+      if (time < next)
+        next = time;
+    return next;
+  }
+
+private:
+  int times[EVENT_COUNT] = {NEVER, NEVER, NEVER};
+};
+
+#endif // ZXEMULATOR_EVENTSCHEDULER_H
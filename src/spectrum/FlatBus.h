@@ -0,0 +1,59 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_FLATBUS_H
+#define ZXEMULATOR_FLATBUS_H
+
+#include "../utils/BaseTypes.h"
+#include "Z80State.h"
+#include <array>
+
+/**
+ * A Z80 with 64K of RAM and nothing else: the bus for CP/M style test
+ * harnesses and fuzzing. There is no ROM, paging or decode cache, so it is
+ * run with Opcodes::step() and its memory can be written directly.
+ *
+ * Port reads return portInput; writes are counted and the last one kept
+ * for the harness to look at.
+ */
+class FlatBus : public Z80State {
+public:
+  std::array<emulator_types::byte, 0x10000> memory{};
+
+  emulator_types::byte portInput = 0xFF;
+  emulator_types::word lastPort = 0;
+  emulator_types::byte lastOutput = 0;
+  unsigned long portWrites = 0;
+
+  // Bus accesses, see Z80State
+  emulator_types::byte fetch(emulator_types::word address) const {
+    return memory[address];
+  }
+  emulator_types::byte read(emulator_types::word address) const {
+    return memory[address];
+  }
+  void write(emulator_types::word address, emulator_types::byte value) {
+    memory[address] = value;
+  }
+  emulator_types::byte in(emulator_types::word) const { return portInput; }
+  void out(emulator_types::word port, emulator_types::byte value) {
+    lastPort = port;
+    lastOutput = value;
+    portWrites++;
+  }
+};
+
+#endif // ZXEMULATOR_FLATBUS_H
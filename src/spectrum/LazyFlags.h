@@ -0,0 +1,120 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_LAZYFLAGS_H
+#define ZXEMULATOR_LAZYFLAGS_H
+
+#include "../utils/BaseTypes.h"
+#include "ProcessorMacros.h"
+#include "ProcessorTypes.h"
+#include "instructions/FlagTables.h"
+
+/**
+ * Deferred flag state for the lazy flag core.
+ *
+ * Instead of computing F, the 8-bit ALU operations record what they did and
+ * F is only built when something needs the whole register. Conditional
+ * branches ask for the single flag they test, which can be answered straight
+ * from the recorded result without materialising F.
+ *
+ * When nothing is pending, registers.F is authoritative.
+ */
+struct LazyFlags {
+  enum Kind : emulator_types::byte {
+    NONE, // registers.F is up to date
+    ADD,  // ADD / ADC
+    SUB,  // SUB / SBC
+    CP,
+    AND,
+    OR, // OR / XOR
+    INC,
+    DEC
+  };
+
+  Kind kind = NONE;
+  emulator_types::byte a = 0; // first operand
+  emulator_types::byte b = 0; // second operand
+  int result = 0;             // unmasked result, bit 8 is the carry
+  emulator_types::byte carry = 0; // carry preserved by INC / DEC
+
+  bool pending() const { return kind != NONE; }
+
+  void record(Kind k, emulator_types::byte op1, emulator_types::byte op2,
+              int res) {
+    kind = k;
+    a = op1;
+    b = op2;
+    result = res;
+  }
+
+  // F has been overwritten as a whole (POP AF, snapshot load)
+  void discard() { kind = NONE; }
+
+  bool carrySet(const Z80Registers &r) const {
+    switch (kind) {
+    case NONE:
+      return r.F & C_FLAG;
+    case AND:
+    case OR:
+      return false;
+    case INC:
+    case DEC:
+      return carry;
+    default:
+      return result & 0x100;
+    }
+  }
+
+  bool zeroSet(const Z80Registers &r) const {
+    return pending() ? (result & 0xFF) == 0 : (r.F & Z_FLAG);
+  }
+
+  bool signSet(const Z80Registers &r) const {
+    return pending() ? (result & 0x80) : (r.F & S_FLAG);
+  }
+
+  // Build F from the recorded operation
+  void materialise(Z80Registers &r) {
+    switch (kind) {
+    case NONE:
+      return;
+    case ADD:
+      r.F = Flags::add8(a, b, result);
+      break;
+    case SUB:
+      r.F = Flags::sub8(a, b, result);
+      break;
+    case CP:
+      r.F = Flags::cp8(a, b, result);
+      break;
+    case AND:
+      r.F = H_FLAG | Flags::sz53p[result & 0xFF];
+      break;
+    case OR:
+      r.F = Flags::sz53p[result & 0xFF];
+      break;
+    case INC:
+      r.F = carry | Flags::inc8[result & 0xFF];
+      break;
+    case DEC:
+      r.F = carry | Flags::dec8[result & 0xFF];
+      break;
+    }
+    kind = NONE;
+  }
+};
+
+#endif // ZXEMULATOR_LAZYFLAGS_H
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_MACHINEMODEL_H
+#define ZXEMULATOR_MACHINEMODEL_H
+
+#include "../utils/BaseTypes.h"
+
+/**
+ * The Spectrums the emulator runs, each described by a struct of constants:
+ * frame and line timing, how long /INT is held, the memory contention
+ * pattern, the ROM set and the paging ports of its memory map.
+ *
+ * The frame loop is a template over the model, instantiated once for each,
+ * so the timings are constants in the code that runs the machine and
+ * choosing one costs a switch a frame rather than a branch an instruction.
+ *
+ * Banks are numbered as Memory holds them: a 48K maps RAM banks 5, 2 and 0.
+ */
+enum class Machine { SPECTRUM_48K, SPECTRUM_128K, PLUS_2A };
+
+struct Spectrum48K {
+  static constexpr Machine MACHINE = Machine::SPECTRUM_48K;
+
+  // 312 lines of 224 T-states at 3.5MHz
+  static constexpr int FRAME_TSTATES = 69888;
+  static constexpr int LINE_TSTATES = 224;
+  static constexpr int INTERRUPT_TSTATES = 32;
+  // The beam reaches the first display line 64 lines into the frame
+  static constexpr int FIRST_DISPLAY_TSTATES = 64 * LINE_TSTATES;
+
+  // The ULA holds off the CPU from contended banks for the first 128
+  // T-states of each display line, by this much at each T-state of 8
+  static constexpr int CONTENTION_TSTATES = 14335;
+  static constexpr emulator_types::byte CONTENTION_PATTERN[8] = {6, 5, 4, 3,
+                                                                 2, 1, 0, 0};
+  static constexpr unsigned CONTENDED_BANKS = 1u << 5;
+
+  static constexpr int ROMS = 1;
+  static constexpr bool PAGING = false;
+  static constexpr bool PLUS_PAGING = false;
+};
+
+struct Spectrum128K {
+  static constexpr Machine MACHINE = Machine::SPECTRUM_128K;
+
+  // 311 lines of 228 T-states at 3.5469MHz
+  static constexpr int FRAME_TSTATES = 70908;
+  static constexpr int LINE_TSTATES = 228;
+  static constexpr int INTERRUPT_TSTATES = 36;
+  static constexpr int FIRST_DISPLAY_TSTATES = 63 * LINE_TSTATES;
+
+  static constexpr int CONTENTION_TSTATES = 14361;
+  static constexpr emulator_types::byte CONTENTION_PATTERN[8] = {6, 5, 4, 3,
+                                                                 2, 1, 0, 0};
+  static constexpr unsigned CONTENDED_BANKS = 0xAA; // Odd banks
+
+  // 128K editor then 48K BASIC, paged through 0x7FFD (A15 and A1 low)
+  static constexpr int ROMS = 2;
+  static constexpr bool PAGING = true;
+  static constexpr emulator_types::word PAGING_MASK = 0x8002;
+  static constexpr emulator_types::word PAGING_MATCH = 0x0000;
+  static constexpr bool PLUS_PAGING = false;
+};
+
+struct Plus2A {
+  static constexpr Machine MACHINE = Machine::PLUS_2A;
+
+  static constexpr int FRAME_TSTATES = 70908;
+  static constexpr int LINE_TSTATES = 228;
+  static constexpr int INTERRUPT_TSTATES = 32;
+  static constexpr int FIRST_DISPLAY_TSTATES = 63 * LINE_TSTATES;
+
+  // The gate array contends differently and no longer contends I/O
+  static constexpr int CONTENTION_TSTATES = 14365;
+  static constexpr emulator_types::byte CONTENTION_PATTERN[8] = {1, 0, 7, 6,
+                                                                 5, 4, 3, 2};
+  static constexpr unsigned CONTENDED_BANKS = 0xF0; // Banks 4 to 7
+
+  // Four ROMs. 0x7FFD and 0x1FFD decode more address lines than on the
+  // 128K; 0x1FFD picks the upper two ROMs or an all RAM map.
+  static constexpr int ROMS = 4;
+  static constexpr bool PAGING = true;
+  static constexpr emulator_types::word PAGING_MASK = 0xC002;
+  static constexpr emulator_types::word PAGING_MATCH = 0x4000;
+  static constexpr bool PLUS_PAGING = true;
+  static constexpr emulator_types::word PLUS_PAGING_MASK = 0xF002;
+  static constexpr emulator_types::word PLUS_PAGING_MATCH = 0x1000;
+};
+
+// The machine a ROM set of 1, 2 or 4 16K ROMs belongs to
+inline Machine machineForRoms(int roms) {
+  return roms >= Plus2A::ROMS         ? Machine::PLUS_2A
+         : roms >= Spectrum128K::ROMS ? Machine::SPECTRUM_128K
+                                      : Machine::SPECTRUM_48K;
+}
+
+// T-states an access to a contended bank waits at a frame time
+template <class Model> constexpr int contentionDelay(long tStates) {
+  long offset = tStates - Model::CONTENTION_TSTATES;
+  if (offset < 0 || offset >= 192L * Model::LINE_TSTATES)
+    return 0;
+  int column = (int)(offset % Model::LINE_TSTATES);
+  return column < 128 ? Model::CONTENTION_PATTERN[column & 7] : 0;
+}
+
+template <class Model> constexpr bool isContended(int bank) {
+  return (Model::CONTENDED_BANKS >> bank) & 1;
+}
+
+#endif // ZXEMULATOR_MACHINEMODEL_H
@@ -15,21 +15,20 @@
  */
 
 #include "Memory.h"
-#include "../exceptions/MemoryException.h"
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
 /**
  * Constructor
- * Allocate the memory
- */
-/**
- * Constructor
- * Allocate the memory
+ * Allocate the memory and map it as a 48K machine
  */
 Memory::Memory() {
-  m_memory = (byte *)calloc(1, m_totalMemory);
-  m_videoBuffer = new VideoBuffer(m_memory);
+  m_memory = (byte *)calloc(ROM_BANKS + RAM_BANKS + 1, BANK_SIZE);
+  std::fill(m_readPages, m_readPages + 4, nullptr);
+  m_videoBuffer = new VideoBuffer(getBank(5));
+  mapPages();
+  m_lateCells.clear();
 }
 
 /**
@@ -53,41 +52,161 @@ Memory::~Memory() {
  * @param data  The data to load
  */
 void Memory::loadIntoMemory(long start, long length, byte *data) {
-  memcpy(m_memory + start, data, length);
+  for (long done = 0; done < length;) {
+    long address = start + done;
+    long chunk = std::min(length - done, BANK_SIZE - (address & BANK_MASK));
+    memcpy(m_writePages[address >> BANK_SHIFT] + (address & BANK_MASK),
+           data + done, chunk);
+    done += chunk;
+  }
+  m_decodeCache.clear();
+  m_dirtyCells.setAll();
 }
 
 /**
- * LoadOpcodes a preloaded ROM into memory
- * @param start start address to load the ROM
+ * LoadOpcodes a preloaded ROM into memory. A 32K ROM holds the two ROMs of
+ * a 128K machine, which then pages through port 0x7FFD, and a 64K one the
+ * four of a +2A.
  * @param rom The ROM to load
  */
 void Memory::loadIntoMemory(Rom &rom) {
-  loadIntoMemory(ROM_LOCATION, rom.getSize(), rom.getData());
+  long size = std::min(rom.getSize(), (long)(ROM_BANKS * BANK_SIZE));
+  memcpy(romBank(0), rom.getData(), size);
+  m_roms = size > 2 * BANK_SIZE ? 4 : size > BANK_SIZE ? 2 : 1;
+  m_plusPagingRegister = 0;
+  setPagingRegister(0);
+  m_decodeCache.clear();
 
   // Clear Video RAM explicitly to ensure clean start
   // Pixels: 0x4000, length 6144 (0x1800)
-  memset(m_memory + 0x4000, 0, 6144);
+  memset(getBank(5), 0, VIDEO_BITMAP_DATA);
   // Attributes: 0x5800, length 768 (0x300) -> 0x38 (White Paper, Black Ink)
-  memset(m_memory + 0x5800, 0x38, 768);
+  memset(getBank(5) + VIDEO_BITMAP_DATA, 0x38, VIDEO_ATTR_DATA);
+  m_dirtyCells.setAll();
 }
 
 /**
- * Override the [] operator to allow direct byte access to memory
- * @param i index of the byte to read
- * @return The byte value or throw a <code>MemoryExceptom</code>
+ * Map the banks the paging register selects. Only pointers move; cached
+ * code is dropped from a slot whose bank changed.
+ * @param value the paging register
  */
-emulator_types::byte &Memory::operator[](long i) {
-  if (i >= m_totalMemory)
-    throw MemoryException(i);
-
-  // ROM Protection (0x0000 - 0x3FFF)
-  if (i < ROM_SIZE) {
-    m_romScratch = m_memory[i]; // Load current ROM value into scratch
-    return m_romScratch; // Return ref to scratch. Writes affect scratch, Reads
-                         // get real value.
+void Memory::setPagingRegister(byte value) {
+  m_pagingRegister = isPageable() ? value : 0;
+  mapPages();
+}
+
+void Memory::setPlusPagingRegister(byte value) {
+  m_plusPagingRegister = m_roms == ROM_BANKS ? value : 0;
+  mapPages();
+}
+
+void Memory::mapPages() {
+  // The +2A's all RAM maps, by bits 1 and 2 of 0x1FFD
+  static const int special[4][4] = {
+      {0, 1, 2, 3}, {4, 5, 6, 7}, {4, 5, 6, 3}, {4, 7, 6, 3}};
+  int banks[4] = {-1, 5, 2, m_pagingRegister & PAGING_RAM_BANK};
+  if (m_plusPagingRegister & PLUS_PAGING_SPECIAL)
+    std::copy(special[(m_plusPagingRegister >> 1) & 3],
+              special[(m_plusPagingRegister >> 1) & 3] + 4, banks);
+
+  // A 16K ROM is mapped whichever ROM is asked for
+  int rom = ((m_pagingRegister & PAGING_ROM) ? 1 : 0) |
+            ((m_plusPagingRegister & PLUS_PAGING_ROM) ? 2 : 0);
+  if (banks[0] < 0)
+    mapSlot(0, romBank(rom & (m_roms - 1)), false);
+
+  int screen = (m_pagingRegister & PAGING_SHADOW) ? 7 : 5;
+  m_screenSlots = 0;
+  for (int slot = 0; slot < 4; slot++) {
+    if (banks[slot] < 0)
+      continue;
+    mapSlot(slot, getBank(banks[slot]));
+    if (banks[slot] == screen)
+      m_screenSlots |= 1u << slot;
+  }
+
+  // A 128K machine can map bank 5 or 2 at 0xC000 too
+  for (int slot = 0; slot < 4; slot++) {
+    m_aliasSlots[slot] = 0;
+    for (int other = 0; other < 4; other++)
+      if (other != slot && m_writePages[slot] == m_readPages[other])
+        m_aliasSlots[slot] |= 1u << other;
   }
 
-  return *(this->m_memory + i);
+  if (m_videoBuffer->getBuffer() != getBank(screen)) {
+    m_videoBuffer->setScreen(getBank(screen));
+    m_dirtyCells.setAll();
+  }
+}
+
+void Memory::mapSlot(int slot, byte *bank, bool writable) {
+  // Only RAM is written
+  m_writePages[slot] = writable ? bank : discardBank();
+  if (m_readPages[slot] == bank)
+    return;
+  m_readPages[slot] = bank;
+  m_decodeCache.invalidateSlot(slot);
+}
+
+/**
+ * Check two ranges of the address space for bytes in common
+ * @param written first byte of the range written
+ * @param writtenLength its length
+ * @param read first byte of the range read
+ * @param readLength its length
+ * @return true if a write to the first range could be read in the second
+ */
+bool Memory::overlaps(long written, int writtenLength, long read,
+                      int readLength) const {
+  if (written < 0 || read < 0 || written + writtenLength > 0x10000 ||
+      read + readLength > 0x10000)
+    return true;
+  // Compare offsets a slot at a time where the two slots share a bank
+  for (long to = written; to < written + writtenLength;) {
+    long toBase = to & ~(long)BANK_MASK;
+    long toEnd = std::min(written + writtenLength, toBase + BANK_SIZE);
+    for (long from = read; from < read + readLength;) {
+      long fromBase = from & ~(long)BANK_MASK;
+      long fromEnd = std::min(read + readLength, fromBase + BANK_SIZE);
+      if (m_writePages[toBase >> BANK_SHIFT] ==
+              m_readPages[fromBase >> BANK_SHIFT] &&
+          to - toBase < fromEnd - fromBase && from - fromBase < toEnd - toBase)
+        return true;
+      from = fromEnd;
+    }
+    to = toEnd;
+  }
+  return false;
+}
+
+/**
+ * Bulk copy used by the block transfer instructions
+ * @param destination first byte written, must be RAM
+ * @param source first byte read
+ * @param length number of bytes to copy
+ */
+void Memory::fastCopy(word destination, word source, int length) {
+  // A run at a time that stays within one bank at each end
+  for (int done = 0; done < length;) {
+    word to = destination + done;
+    word from = source + done;
+    int slot = to >> BANK_SHIFT;
+    int offset = to & BANK_MASK;
+    int chunk = std::min({length - done, BANK_SIZE - offset,
+                          BANK_SIZE - (from & BANK_MASK)});
+    done += chunk;
+    // Nothing changes where the ROM is mapped, including its decoded code
+    if (m_writePages[slot] == discardBank())
+      continue;
+    memmove(m_writePages[slot] + offset,
+            m_readPages[from >> BANK_SHIFT] + (from & BANK_MASK), chunk);
+    m_changes += chunk;
+    if (m_screenSlots & (1u << slot))
+      for (int i = offset; i < offset + chunk && i < VIDEO_DATA; i++)
+        markScreen(VIDEO_PIXEL_START + i);
+    for (int i = offset; i < offset + chunk; i++)
+      invalidateCode(slot, i);
+  }
 }
 
 /**
@@ -100,22 +219,11 @@ void Memory::dump(long start, long size) {
     long address = start + i;
     if (i % 8 == 0)
       printf("\n%04ld ", address);
-    printf("%hhx ", this->m_memory[address]);
+    printf("%hhx ", fastRead(address));
   }
   printf("\n");
 }
 
-/**
- * Get a word from the specified address
- * @param address
- * @return The word at the specified address
- */
-word Memory::getWord(long address) {
-  // Avoid reinterpret_cast for safety and endianness independence (Z80 is
-  // Little Endian)
-  return m_memory[address] | (m_memory[address + 1] << 8);
-}
-
 /**
  *
  * @return
@@ -18,6 +18,7 @@
 #define ZXEMULATOR_MEMORY_H
 
 #include "../utils/BaseTypes.h"
+#include "DecodeCache.h"
 #include "Rom.h"
 #include "video/VideoBuffer.h"
 
@@ -27,6 +28,23 @@
 #define ROM_SIZE 0x4000 // 16K ROM
 #define RAM_SIZE 0xC000 // 48K RAM
 
+// The address space is 4 slots of 16K, each mapping a bank
+#define BANK_SIZE 0x4000
+#define BANK_SHIFT 14
+#define BANK_MASK (BANK_SIZE - 1)
+#define ROM_BANKS 4 // The most any machine has, the +2A's
+#define RAM_BANKS 8
+
+// 128K paging register, port 0x7FFD
+#define PAGING_RAM_BANK 0x07    // Bank mapped at 0xC000
+#define PAGING_SHADOW 0x08      // Show the screen in bank 7
+#define PAGING_ROM 0x10         // Map the 48K BASIC ROM
+#define PAGING_LOCKED 0x20      // Ignore writes until reset
+
+// +2A paging register, port 0x1FFD
+#define PLUS_PAGING_SPECIAL 0x01 // All RAM, in the map bits 1 and 2 pick
+#define PLUS_PAGING_ROM 0x04     // Upper ROM bit, when not all RAM
+
 using namespace emulator_types;
 
 /**
@@ -40,13 +58,57 @@ using namespace emulator_types;
  *  &5CC0 to &5CCA Reserved
  *  &5CCB to &FF57 Available memory (between PROG and RAMTOP)
  *  &FF58 to &FFFF Reserved
+ *
+ *  Memory is held as ROM and RAM banks of 16K and each slot of the address
+ *  space reads and writes through a pointer to the bank mapped there:
+ *  ROM, RAM bank 5 (the screen), bank 2 and bank 0 as a 48K machine sees
+ *  them. A 128K machine pages the ROM and the bank at 0xC000 through port
+ *  0x7FFD, which only moves pointers. A +2A also has 0x1FFD, choosing from
+ *  four ROMs or mapping RAM over the whole address space.
+ *
+ *  Reads and writes have a table each. The ROM slot writes to a discard
+ *  bank, so every access is a table load and a byte access with no bounds
+ *  checks; addresses wrap at 64K as on the Z80. Writes only compare the
+ *  page with the discard bank, so a ROM poke isn't counted as a change.
  */
 class Memory {
 private:
-  const long m_totalMemory = RAM_SIZE + ROM_SIZE;
-  byte *m_memory;
+  byte *m_memory; // ROM banks, RAM banks, then the discard bank
+  byte *m_readPages[4];
+  byte *m_writePages[4];
   VideoBuffer *m_videoBuffer = nullptr;
-  byte m_romScratch = 0; // Scratch byte for ROM write protection
+  int m_roms = 1;            // ROMs in the loaded set, 1, 2 or 4
+  byte m_pagingRegister = 0; // Last value written to port 0x7FFD
+  byte m_plusPagingRegister = 0; // And to 0x1FFD
+  unsigned m_screenSlots = 1u << 1; // Slots mapping the bank on screen
+  unsigned m_aliasSlots[4] = {};    // Other slots showing what each writes
+  DecodeCache m_decodeCache;
+  unsigned long m_changes = 0; // RAM writes that changed a byte
+  DirtyCells m_dirtyCells;     // Screen cells changed since last taken
+  DirtyCells m_lateCells; // Changed after the beam drew them, so next frame
+
+  void markScreen(long address) {
+    m_dirtyCells.mark(address);
+    if (m_videoBuffer->isLatched(address))
+      m_lateCells.mark(address);
+  }
+
+  // Decoded code is keyed by address, so a write must drop it at every
+  // address the bank is mapped
+  void invalidateCode(int slot, int offset) {
+    m_decodeCache.invalidate((word)((slot << BANK_SHIFT) | offset));
+    for (int other = 0; m_aliasSlots[slot] >> other; other++)
+      if (m_aliasSlots[slot] & (1u << other))
+        m_decodeCache.invalidate((word)((other << BANK_SHIFT) | offset));
+  }
+
+  byte *romBank(int bank) const { return m_memory + bank * BANK_SIZE; }
+  byte *discardBank() const {
+    return m_memory + (ROM_BANKS + RAM_BANKS) * BANK_SIZE;
+  }
+
+  void mapPages();
+  void mapSlot(int slot, byte *bank, bool writable = true);
 
 public:
   Memory();
@@ -61,27 +123,97 @@ public:
   void loadIntoMemory(Rom &rom);
 
   // Get a word from the specified address
-  word getWord(long address);
+  word getWord(word address) const {
+    return fastRead(address) | (fastRead((word)(address + 1)) << 8);
+  }
+
+  // 16K ROMs loaded: a 32K image is the two 128K ROMs and a 64K one the
+  // four of a +2A. Set by loading a ROM.
+  int getRomCount() const { return m_roms; }
+  // Page through port 0x7FFD
+  bool isPageable() const { return m_roms > 1; }
+  // A write to port 0x7FFD, ignored once paging is locked
+  void writePagingPort(byte value) {
+    if (isPageable() && !(m_pagingRegister & PAGING_LOCKED))
+      setPagingRegister(value);
+  }
+  // A write to the +2A's port 0x1FFD, locked along with 0x7FFD
+  void writePlusPagingPort(byte value) {
+    if (m_roms == ROM_BANKS && !(m_pagingRegister & PAGING_LOCKED))
+      setPlusPagingRegister(value);
+  }
+  // Set the paging registers whatever the lock, e.g. on reset or from a
+  // snapshot
+  void setPagingRegister(byte value);
+  void setPlusPagingRegister(byte value);
+  byte getPagingRegister() const { return m_pagingRegister; }
+  byte getPlusPagingRegister() const { return m_plusPagingRegister; }
+
+  // The 16K RAM banks, 0 to 7, wherever they are mapped
+  byte *getBank(int bank) const {
+    return m_memory + (ROM_BANKS + bank) * BANK_SIZE;
+  }
+  // Where an address is held, good for the rest of its 16K slot
+  const byte *getPointer(word address) const {
+    return m_readPages[address >> BANK_SHIFT] + (address & BANK_MASK);
+  }
 
   // Get an instance of the video videoBuffer configured to point at the correct
   // location in this memory map
   VideoBuffer *getVideoBuffer();
 
-  // Override operators
-  emulator_types::byte &operator[](long i);
-
-  byte *getRawMemory() const { return m_memory; }
+  // Instructions decoded from this memory. Writes through fastWrite keep it
+  // up to date; anything writing through a bank pointer must
+  // clear it afterwards.
+  DecodeCache &getDecodeCache() { return m_decodeCache; }
+
+  // Counts fastWrite calls that changed RAM, so the processor can tell a
+  // loop that only reads memory (or writes back what was there)
+  unsigned long getChanges() const { return m_changes; }
+
+  // Screen cells changed since the last frame was taken. Writes through
+  // fastWrite and fastCopy mark them; anything writing the screen another
+  // way must call markScreenDirty() afterwards. Cells changed after the
+  // beam passed them stay dirty for the frame that shows the change.
+  const DirtyCells &getDirtyCells() const { return m_dirtyCells; }
+  void clearDirtyCells() {
+    m_dirtyCells = m_lateCells;
+    m_lateCells.clear();
+  }
+  void markScreenDirty() { m_dirtyCells.setAll(); }
 
   // Fast inline accessors for the processor
-  inline byte fastRead(long address) const { return m_memory[address]; }
+  inline byte fastRead(word address) const {
+    return m_readPages[address >> BANK_SHIFT][address & BANK_MASK];
+  }
 
-  inline void fastWrite(long address, byte value) {
-    if (address >= ROM_SIZE) {
-      m_memory[address] = value;
-    }
+  inline void fastWrite(word address, byte value) {
+    int slot = address >> BANK_SHIFT;
+    int offset = address & BANK_MASK;
+    // ROM writes go nowhere and leave ROM code decoded
+    if (m_writePages[slot] == discardBank())
+      return;
+    byte &target = m_writePages[slot][offset];
+    bool changed = target != value;
+    m_changes += changed;
+    if (changed && (m_screenSlots & (1u << slot)) && offset < VIDEO_DATA)
+      markScreen(VIDEO_PIXEL_START + offset);
+    target = value;
+    invalidateCode(slot, offset);
     // Note: detailed screen/contention logic would go here if/when added
   }
 
+  // Whether writing the first range could change a byte of the second,
+  // comparing the banks behind them, as one bank can be mapped at two
+  // addresses. Ranges that wrap at 64K are taken to overlap.
+  bool overlaps(long written, int writtenLength, long read,
+                int readLength) const;
+
+  // Copy length bytes as LDIR/LDDR would. The caller makes sure neither
+  // range wraps, the destination is RAM and the two don't overlap in
+  // memory, not only in the address space (see overlaps()).
+  void fastCopy(word destination, word source, int length);
+
   void dump(long start, long size);
 };
 
@@ -0,0 +1,398 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_OPCODETABLES_H
+#define ZXEMULATOR_OPCODETABLES_H
+
+#include "../utils/BaseTypes.h"
+#include "DecodeCache.h"
+#include "ProcessorMacros.h"
+#include "ProcessorState.h"
+#include "Z80State.h"
+#include "instructions/ArithmeticInstructions.h"
+#include "instructions/BitInstructions.h"
+#include "instructions/LogicInstructions.h"
+#include <array>
+#include <cstdint>
+#include <utility>
+
+/**
+ * Table driven opcode dispatch.
+ *
+ * Every opcode in every prefix group has its own handler, generated at compile
+ * time from a template parameterised on the opcode byte. The x/y/z/p/q fields
+ * of the opcode are decoded with constexpr so the register operands are baked
+ * into each handler and the main loop is a single indirect call per opcode.
+ *
+ * Handlers are entered with PC pointing just past the opcode byte and return
+ * the total T-states for the instruction (including any prefix bytes).
+ *
+ *   main        - unprefixed opcodes   (Processor_Ops.cpp)
+ *   lazyMain    - unprefixed opcodes using deferred flags. ALU results
+ *                 are recorded in state.lazyFlags and F is only built
+ *                 before an instruction that needs it. Prefixed opcodes
+ *                 build F and then run from the eager tables.
+ *   cb          - CB prefixed opcodes  (Processor_Extended.cpp)
+ *   ed          - ED prefixed opcodes  (Processor_Extended.cpp)
+ *   dd          - DD (IX) opcodes      (Processor_Index.cpp)
+ *   fd          - FD (IY) opcodes      (Processor_Index.cpp)
+ *   indexCb     - DD CB d / FD CB d opcodes. The effective address is
+ *                 resolved before dispatch so one table serves both prefixes.
+ *
+ * There is a set of tables per Bus (see Z80State.h), instantiated for each
+ * bus at the end of those files.
+ *
+ * decode() walks the prefix bytes once and the result is kept in the
+ * DecodeCache, so the run loop normally goes straight to the final handler.
+ * It also flags the instructions a recorded block has to stop at.
+ */
+namespace Opcodes {
+
+template <class Bus> using Handler = int (*)(Bus &state);
+template <class Bus>
+using IndexedHandler = int (*)(Bus &state, emulator_types::word address);
+
+template <class Bus> struct Tables {
+  static const std::array<Handler<Bus>, 256> main;
+  static const std::array<Handler<Bus>, 256> lazyMain;
+  static const std::array<Handler<Bus>, 256> cb;
+  static const std::array<Handler<Bus>, 256> ed;
+  static const std::array<Handler<Bus>, 256> dd;
+  static const std::array<Handler<Bus>, 256> fd;
+  static const std::array<IndexedHandler<Bus>, 256> indexCb;
+};
+
+// Opcode field decoding
+//   x = bits 7-6, y = bits 5-3, z = bits 2-0, p = bits 5-4, q = bit 3
+constexpr int opX(emulator_types::byte op) { return (op >> 6) & 3; }
+constexpr int opY(emulator_types::byte op) { return (op >> 3) & 7; }
+constexpr int opZ(emulator_types::byte op) { return op & 7; }
+constexpr int opP(emulator_types::byte op) { return (op >> 4) & 3; }
+constexpr int opQ(emulator_types::byte op) { return (op >> 3) & 1; }
+
+// Operands at PC, left for the instruction to step past
+template <class Bus> inline emulator_types::byte operandByte(Bus &state) {
+  return state.read(state.registers.PC);
+}
+
+template <class Bus> inline emulator_types::word operandWord(Bus &state) {
+  return state.read(state.registers.PC) |
+         (state.read((emulator_types::word)(state.registers.PC + 1)) << 8);
+}
+
+// Read the byte at PC and step past it
+template <class Bus> inline emulator_types::byte fetchByte(Bus &state) {
+  emulator_types::byte value = operandByte(state);
+  state.registers.PC++;
+  return value;
+}
+
+// Read the word at PC and step past it
+template <class Bus> inline emulator_types::word fetchWord(Bus &state) {
+  emulator_types::word value = operandWord(state);
+  state.registers.PC += 2;
+  return value;
+}
+
+// 8-bit register from the 3 bit register field
+// 0=B, 1=C, 2=D, 3=E, 4=H, 5=L, 7=A  (6 is (HL) and handled by the caller)
+template <int R> inline emulator_types::byte &reg8(Z80Registers &r) {
+  static_assert(R >= 0 && R <= 7 && R != 6, "invalid register field");
+  if constexpr (R == 0)
+    return r.B;
+  else if constexpr (R == 1)
+    return r.C;
+  else if constexpr (R == 2)
+    return r.D;
+  else if constexpr (R == 3)
+    return r.E;
+  else if constexpr (R == 4)
+    return r.H;
+  else if constexpr (R == 5)
+    return r.L;
+  else
+    return r.A;
+}
+
+// 16-bit register pair from the 2 bit 'p' field (0=BC, 1=DE, 2=HL, 3=SP)
+template <int P> inline emulator_types::word &rp(Z80Registers &r) {
+  if constexpr (P == 0)
+    return r.BC;
+  else if constexpr (P == 1)
+    return r.DE;
+  else if constexpr (P == 2)
+    return r.HL;
+  else
+    return r.SP;
+}
+
+// Condition codes from the 3 bit 'y' field (NZ, Z, NC, C, PO, PE, P, M)
+template <int Cc> inline bool condition(const Z80Registers &r) {
+  if constexpr (Cc == 0)
+    return !GET_FLAG(Z_FLAG, r);
+  else if constexpr (Cc == 1)
+    return GET_FLAG(Z_FLAG, r);
+  else if constexpr (Cc == 2)
+    return !GET_FLAG(C_FLAG, r);
+  else if constexpr (Cc == 3)
+    return GET_FLAG(C_FLAG, r);
+  else if constexpr (Cc == 4)
+    return !GET_FLAG(P_FLAG, r);
+  else if constexpr (Cc == 5)
+    return GET_FLAG(P_FLAG, r);
+  else if constexpr (Cc == 6)
+    return !GET_FLAG(S_FLAG, r);
+  else
+    return GET_FLAG(S_FLAG, r);
+}
+
+// 8-bit ALU operation on A from the 3 bit 'y' field
+// ADD, ADC, SUB, SBC, AND, XOR, OR, CP
+template <int Op>
+inline void alu(Z80State &state, emulator_types::byte value) {
+  if constexpr (Op == 0)
+    Arithmetic::add8(state, value);
+  else if constexpr (Op == 1)
+    Arithmetic::adc8(state, value);
+  else if constexpr (Op == 2)
+    Arithmetic::sub8(state, value);
+  else if constexpr (Op == 3)
+    Arithmetic::sbc8(state, value);
+  else if constexpr (Op == 4)
+    Logic::and8(state, value);
+  else if constexpr (Op == 5)
+    Logic::xor8(state, value);
+  else if constexpr (Op == 6)
+    Logic::or8(state, value);
+  else
+    Arithmetic::cp8(state, value);
+}
+
+// CB rotate/shift operation from the 3 bit 'y' field
+// RLC, RRC, RL, RR, SLA, SRA, SLL (undocumented), SRL
+template <int Op>
+inline void rotate(Z80State &state, emulator_types::byte &value) {
+  if constexpr (Op == 0)
+    Bit::rlc(state, value);
+  else if constexpr (Op == 1)
+    Bit::rrc(state, value);
+  else if constexpr (Op == 2)
+    Bit::rl(state, value);
+  else if constexpr (Op == 3)
+    Bit::rr(state, value);
+  else if constexpr (Op == 4)
+    Bit::sla(state, value);
+  else if constexpr (Op == 5)
+    Bit::sra(state, value);
+  else if constexpr (Op == 6)
+    Bit::sll(state, value);
+  else
+    Bit::srl(state, value);
+}
+
+// Lazy flag variants of the above. F is left stale and the operation is
+// recorded in state.lazyFlags instead.
+template <int Cc> inline bool lazyCondition(Z80State &state) {
+  LazyFlags &lazy = state.lazyFlags;
+  const Z80Registers &r = state.registers;
+  if constexpr (Cc == 0)
+    return !lazy.zeroSet(r);
+  else if constexpr (Cc == 1)
+    return lazy.zeroSet(r);
+  else if constexpr (Cc == 2)
+    return !lazy.carrySet(r);
+  else if constexpr (Cc == 3)
+    return lazy.carrySet(r);
+  else if constexpr (Cc == 6)
+    return !lazy.signSet(r);
+  else if constexpr (Cc == 7)
+    return lazy.signSet(r);
+  else {
+    // P/V needs the full flag calculation
+    lazy.materialise(state.registers);
+    return condition<Cc>(state.registers);
+  }
+}
+
+template <int Op>
+inline void lazyAlu(Z80State &state, emulator_types::byte value) {
+  LazyFlags &lazy = state.lazyFlags;
+  emulator_types::byte &a = state.registers.A;
+  int res;
+  if constexpr (Op == 0) {
+    res = a + value;
+    lazy.record(LazyFlags::ADD, a, value, res);
+  } else if constexpr (Op == 1) {
+    res = a + value + lazy.carrySet(state.registers);
+    lazy.record(LazyFlags::ADD, a, value, res);
+  } else if constexpr (Op == 2) {
+    res = a - value;
+    lazy.record(LazyFlags::SUB, a, value, res);
+  } else if constexpr (Op == 3) {
+    res = a - value - lazy.carrySet(state.registers);
+    lazy.record(LazyFlags::SUB, a, value, res);
+  } else if constexpr (Op == 4) {
+    res = a & value;
+    lazy.record(LazyFlags::AND, a, value, res);
+  } else if constexpr (Op == 5) {
+    res = a ^ value;
+    lazy.record(LazyFlags::OR, a, value, res);
+  } else if constexpr (Op == 6) {
+    res = a | value;
+    lazy.record(LazyFlags::OR, a, value, res);
+  } else {
+    // CP leaves A unchanged
+    lazy.record(LazyFlags::CP, a, value, a - value);
+    return;
+  }
+  a = (emulator_types::byte)res;
+}
+
+// INC r / DEC r. The carry is captured as it is preserved by the operation.
+template <bool Increment>
+inline void lazyIncDec(Z80State &state, emulator_types::byte &value) {
+  LazyFlags &lazy = state.lazyFlags;
+  lazy.carry = lazy.carrySet(state.registers) ? C_FLAG : 0;
+  if constexpr (Increment) {
+    value++;
+    lazy.record(LazyFlags::INC, value, 1, value);
+  } else {
+    value--;
+    lazy.record(LazyFlags::DEC, value, 1, value);
+  }
+}
+
+// Block boundaries for block replay. Flags for an unprefixed opcode:
+// anything that can jump, HALT, or touch a port.
+constexpr emulator_types::byte mainFlags(emulator_types::byte op) {
+  const int x = opX(op), y = opY(op), z = opZ(op), p = opP(op), q = opQ(op);
+  bool ends = false;
+  if (x == 0)
+    ends = z == 0 && y >= 2; // DJNZ, JR, JR cc
+  else if (x == 1)
+    ends = op == 0x76; // HALT
+  else if (x == 3) {
+    if (z == 3 && (y == 2 || y == 3)) // OUT (n), A / IN A, (n)
+      return DecodeCache::ENDS_BLOCK | DecodeCache::PORT_IO;
+    ends = z == 0 || z == 2 || z == 4 || z == 7 ||  // RET cc, JP/CALL cc, RST
+           (z == 1 && q == 1 && (p == 0 || p == 2)) || // RET, JP (HL)
+           (z == 3 && y == 0) ||                      // JP nn
+           (z == 5 && q == 1 && p == 0);              // CALL nn
+  }
+  return ends ? DecodeCache::ENDS_BLOCK : 0;
+}
+
+// ED: port I/O, RETN/RETI and the block instructions
+constexpr emulator_types::byte edFlags(emulator_types::byte op) {
+  const int x = opX(op), y = opY(op), z = opZ(op);
+  if (x == 1 && (z == 0 || z == 1))
+    return DecodeCache::ENDS_BLOCK | DecodeCache::PORT_IO;
+  if (x == 2) {
+    emulator_types::byte flags = DecodeCache::ENDS_BLOCK;
+    if (y >= 4 && (z == 2 || z == 3)) // INI, OUTI and friends
+      flags |= DecodeCache::PORT_IO;
+    if (y >= 6 && z <= 3) // LDIR, CPIR, INIR, OTIR and the D forms
+      flags |= DecodeCache::REPEATS;
+    return flags;
+  }
+  if (x == 1 && z == 5)
+    return DecodeCache::ENDS_BLOCK;
+  return 0;
+}
+
+// DD / FD: JP (IX) plus anything that falls back to the unprefixed table
+constexpr emulator_types::byte indexFlags(emulator_types::byte op) {
+  if (op == 0xCB)
+    return 0;
+  if (op == 0xE9)
+    return DecodeCache::ENDS_BLOCK;
+  return mainFlags(op);
+}
+
+// Resolve the instruction at address to the handler that executes it.
+// CB, ED, DD and FD prefixes are followed to their second table. The lazy
+// core keeps going through its prefix handlers, which build F first.
+template <class Bus>
+inline DecodedInstruction<Bus> decode(Bus &bus, emulator_types::word address,
+                                      bool lazy) {
+  emulator_types::byte op = bus.fetch(address);
+  emulator_types::byte next = bus.fetch((emulator_types::word)(address + 1));
+
+  const std::array<Handler<Bus>, 256> *prefixed = nullptr;
+  emulator_types::byte flags;
+  switch (op) {
+  case 0xCB:
+    prefixed = &Tables<Bus>::cb;
+    flags = 0;
+    break;
+  case 0xED:
+    prefixed = &Tables<Bus>::ed;
+    flags = edFlags(next);
+    break;
+  case 0xDD:
+    prefixed = &Tables<Bus>::dd;
+    flags = indexFlags(next);
+    break;
+  case 0xFD:
+    prefixed = &Tables<Bus>::fd;
+    flags = indexFlags(next);
+    break;
+  default:
+    flags = mainFlags(op);
+  }
+
+  if (prefixed && !lazy)
+    return {(*prefixed)[next], 2, flags};
+  return {(lazy ? Tables<Bus>::lazyMain : Tables<Bus>::main)[op], 1, flags};
+}
+
+// The cached entry for address, decoding it on first use. The cache lives
+// in the Spectrum's Memory, so this is for that bus only.
+inline DecodeCache::Entry lookup(ProcessorState &state,
+                                 emulator_types::word address, bool lazy) {
+  DecodeCache &cache = state.memory.getDecodeCache();
+  DecodeCache::Entry entry = cache[address];
+  if (!entry.handler) {
+    entry = decode(state, address, lazy);
+    cache.store(address, entry);
+  }
+  return entry;
+}
+
+// Execute one instruction on any bus, without the decode cache: what a
+// test harness or a machine without the Spectrum's run loop calls. A
+// halted CPU runs a NOP. Returns the T-states used.
+template <class Bus> inline int step(Bus &bus) {
+  Z80Registers &r = bus.registers;
+  // R counts M1 cycles, once per instruction here as in Processor
+  r.R = (r.R & 0x80) | ((r.R + 1) & 0x7F);
+  if (bus.isHalted())
+    return 4;
+  emulator_types::byte op = bus.fetch(r.PC);
+  r.PC++;
+  return Tables<Bus>::main[op](bus);
+}
+
+// Build a 256 entry table from a handler template instantiated per opcode
+template <typename H, template <emulator_types::byte> class Gen,
+          std::size_t... Op>
+constexpr std::array<H, 256> buildTable(std::index_sequence<Op...>) {
+  return {{Gen<(emulator_types::byte)Op>::handler...}};
+}
+
+} // namespace Opcodes
+
+#endif // ZXEMULATOR_OPCODETABLES_H
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PortMap.h"
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * Add a device at every port where (port & mask) == match
+ * @param device the device, which must outlive the map or a clear()
+ * @param mask the address lines the device decodes
+ * @param match the value of those lines that selects it
+ * @param reads the device answers IN
+ * @param writes the device takes OUT
+ */
+void PortMap::attach(PortDevice &device, emulator_types::word mask,
+                     emulator_types::word match, bool reads, bool writes) {
+  if (m_count == MAX_DEVICES)
+    throw std::runtime_error("Too many port devices");
+
+  emulator_types::byte bit = 1 << m_count;
+  m_devices[m_count++] = &device;
+  for (int port = 0; port < 0x10000; port++) {
+    if ((port & mask) != match)
+      continue;
+    if (reads)
+      m_readers[port] |= bit;
+    if (writes)
+      m_writers[port] |= bit;
+  }
+}
+
+void PortMap::clear() {
+  std::fill(m_readers.begin(), m_readers.end(), 0);
+  std::fill(m_writers.begin(), m_writers.end(), 0);
+  std::fill(m_devices, m_devices + MAX_DEVICES, nullptr);
+  m_count = 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_PORTMAP_H
+#define ZXEMULATOR_PORTMAP_H
+
+#include "../utils/BaseTypes.h"
+#include <vector>
+
+/**
+ * Something on the Z80's I/O ports. Devices only see the accesses their
+ * address decoding matches.
+ */
+class PortDevice {
+public:
+  virtual ~PortDevice() = default;
+
+  virtual emulator_types::byte read(emulator_types::word) { return 0xFF; }
+  virtual void write(emulator_types::word, emulator_types::byte) {}
+};
+
+/**
+ * The devices on a bus and the ports each answers.
+ *
+ * A device is attached with the address lines it decodes: it sees a port
+ * when (port & mask) == match, the way the hardware only looks at a few
+ * address lines. Attaching fills a table with the devices at every port,
+ * so an IN or OUT is one lookup rather than a chain of tests.
+ *
+ * More than one device can answer a port (on a 128K, an OUT to 0x7FFC
+ * reaches both the ULA and the paging register). Writes go to all of them
+ * and reads are ANDed, as devices pull data lines low. Nothing answering
+ * reads 0xFF, the floating bus.
+ */
+class PortMap {
+public:
+  static constexpr int MAX_DEVICES = 8;
+
+  PortMap() : m_readers(0x10000), m_writers(0x10000) {}
+
+  // Add a device at the ports it decodes, for reads, writes or both
+  void attach(PortDevice &device, emulator_types::word mask,
+              emulator_types::word match, bool reads = true,
+              bool writes = true);
+
+  // Remove every device
+  void clear();
+
+  emulator_types::byte read(emulator_types::word port) {
+    emulator_types::byte value = 0xFF;
+    for (unsigned devices = m_readers[port], i = 0; devices; devices >>= 1, i++)
+      if (devices & 1)
+        value &= m_devices[i]->read(port);
+    return value;
+  }
+
+  void write(emulator_types::word port, emulator_types::byte value) {
+    for (unsigned devices = m_writers[port], i = 0; devices; devices >>= 1, i++)
+      if (devices & 1)
+        m_devices[i]->write(port, value);
+  }
+
+private:
+  // A bit per device at each port
+  std::vector<emulator_types::byte> m_readers;
+  std::vector<emulator_types::byte> m_writers;
+  PortDevice *m_devices[MAX_DEVICES] = {};
+  int m_count = 0;
+};
+
+#endif // ZXEMULATOR_PORTMAP_H
@@ -17,23 +17,19 @@
 #include "Processor.h"
 #include "../utils/Logger.h"
 #include "../utils/debug.h"
+#include "OpcodeTables.h"
 // #include "ALUHelpers.h" // Removed
+#include "DebugBus.h"
 #include "ProcessorMacros.h"
 #include "SnapshotLoader.h"
-#include "instructions/ArithmeticInstructions.h"
-#include "instructions/BitInstructions.h"
 #include "instructions/ControlInstructions.h"
-#include "instructions/IOInstructions.h"
-#include "instructions/LoadInstructions.h"
-#include "instructions/LogicInstructions.h"
-#include <chrono>
-#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <memory>
 
-Processor::Processor() : state(), audio() {
+Processor::Processor() : state(), audio(nullAudioSink) {
   // Set up the default state of the registers
   reset();
-  audio.start();
-  m_memory = state.memory.getRawMemory();
 }
 
 /**
@@ -47,7 +43,16 @@ void Processor::init(const char *romFile) {
         ("Error: Failed to load ROM file: " + std::string(romFile)).c_str());
     throw std::runtime_error("Failed to load ROM file");
   }
-  state.memory.loadIntoMemory(theROM);
+  init(theROM);
+}
+
+/**
+ * initialise the processor with a ROM already loaded, which may be shared
+ * between processors as it is only read
+ */
+void Processor::init(Rom &rom) {
+  state.memory.loadIntoMemory(rom);
+  selectMachine(machineForRoms(state.memory.getRomCount()));
 
   // set up the start point
   state.registers.PC = ROM_LOCATION;
@@ -68,6 +73,45 @@ void Processor::loadSnapshot(const char *filename) {
   SnapshotLoader::load(filename, state);
 }
 
+/**
+ * Set up the ports, beam and audio for a machine model
+ */
+template <class Model> void Processor::configure() {
+  state.attachPorts<Model>();
+  state.memory.getVideoBuffer()->setTiming<Model>();
+  audio.setFrameTStates(Model::FRAME_TSTATES);
+}
+
+/**
+ * Run as a machine model from the next frame
+ * @param value the machine
+ */
+void Processor::selectMachine(Machine value) {
+  machine = value;
+  switch (machine) {
+  case Machine::SPECTRUM_48K:
+    configure<Spectrum48K>();
+    break;
+  case Machine::SPECTRUM_128K:
+    configure<Spectrum128K>();
+    break;
+  case Machine::PLUS_2A:
+    configure<Plus2A>();
+    break;
+  }
+}
+
+int Processor::getFrameLength() const {
+  switch (machine) {
+  case Machine::SPECTRUM_128K:
+    return Spectrum128K::FRAME_TSTATES;
+  case Machine::PLUS_2A:
+    return Plus2A::FRAME_TSTATES;
+  default:
+    return Spectrum48K::FRAME_TSTATES;
+  }
+}
+
 void Processor::run() {
   running = true;
   while (running) {
@@ -76,48 +120,14 @@ void Processor::run() {
 }
 
 bool Processor::handleInterrupts(int &tStates) {
-  if (!paused && state.areInterruptsEnabled()) {
-    // If we were halted, we are no longer halted
-    if (state.isHalted()) {
-      state.setHalted(false);
-      // PC already points to next instruction (instruction following HALT)
-    }
-
-    // Push PC
-    state.registers.SP -= 2;
-    word pc = state.registers.PC;
-    state.memory[state.registers.SP] = (byte)(pc & 0xFF);
-    state.memory[state.registers.SP + 1] = (byte)((pc >> 8) & 0xFF);
-
-    // Interrupt Mode Logic
-    int mode = state.getInterruptMode();
-    if (mode == 2) {
-      // IM 2: Vector form (I << 8) | bus_value. Bus usually 0xFF
-      word vector = (state.registers.I << 8) | 0xFF;
-      word dest = state.memory.getWord(vector);
-      state.registers.PC = dest;
-      // Cycles: 19
-      tStates += 19;
-      state.addFrameTStates(19);
-    } else {
-      // IM 0/1: RST 38 (0x0038)
-      // Note: IM 0 executes instruction on bus. Spectrum bus usually 0xFF (RST
-      // 38).
-      state.registers.PC = 0x0038;
-      // Cycles: 13
-      tStates += 13;
-      state.addFrameTStates(13);
-    }
-
-    // Disable interrupts (standard Z80 behavior on accept)
-    state.setInterrupts(false);
-    return true;
-  }
-  return false;
+  int cycles = Control::interrupt(state);
+  tStates += cycles;
+  state.addFrameTStates(cycles);
+  return cycles > 0;
 }
 
 bool Processor::handleFastLoad() {
-  if (state.isFastLoad() && state.registers.PC == 0x0556) {
+  if (state.isFastLoad() && state.registers.PC == FAST_LOAD_TRAP) {
     // 0x0556 is LD_BYTES.
     // inputs: IX=Dest, DE=Length, A=Flag(00=Header, FF=Data), Carry set=Load
     // outputs: Carry set=Success.
@@ -125,6 +135,7 @@ bool Processor::handleFastLoad() {
     // We delegate to Tape to see if it can satisfy this request from current
     // block Note: We ignore the 'Verify' case (Carry clear on entry usually
     // means Verify, but ROM routine handles both) We assume Load.
+    state.lazyFlags.materialise(state.registers);
     bool success =
         state.tape.fastLoadBlock(state.registers.A, state.registers.DE,
                                  state.registers.IX, state.memory);
@@ -138,8 +149,8 @@ bool Processor::handleFastLoad() {
     }
 
     // Execute RET (Pop PC)
-    byte low = state.memory[state.registers.SP];
-    byte high = state.memory[state.registers.SP + 1];
+    byte low = state.memory.fastRead(state.registers.SP);
+    byte high = state.memory.fastRead(state.registers.SP + 1);
     state.registers.PC = (high << 8) | low;
     state.registers.SP += 2;
 
@@ -149,812 +160,122 @@ bool Processor::handleFastLoad() {
   return false;
 }
 
-void Processor::executeFrame() {
-  // 3.5MHz * 0.02s (50Hz) ~= 69888 T-states per frame
-  int tStates = 0;
-  const int frameCycles = 69888;
-
-  state.setFrameTStates(0);
-  if (state.memory.getVideoBuffer()) {
-    state.memory.getVideoBuffer()->newFrame();
+/**
+ * Run a frame of a machine model, from the interrupt at its start to the
+ * frame end. The debug loop can stop partway, and then carries on from
+ * there the next time.
+ */
+template <class Model, class Run> void Processor::frameLoop() {
+  constexpr int frameCycles = Model::FRAME_TSTATES;
+  int tStates;
+
+  // Nothing runs while paused, not even the start of the next frame
+  if (Run::HOOKS && paused)
+    return;
+
+  if (Run::HOOKS && midFrame) {
+    tStates = stoppedTStates;
+  } else {
+    // Start the frame as far in as the previous one overran, so frames are
+    // exactly frameCycles long on average
+    tStates = tStateCarry;
+    tStateCarry = 0;
+    peripheralTStates = tStates;
+
+    state.setFrameTStates(tStates);
+    if (state.memory.getVideoBuffer()) {
+      state.memory.getVideoBuffer()->newFrame();
+    }
+
+    // /INT is held low for the interrupt length, so an EI just after the
+    // frame starts still takes it. None is taken straight after an EI.
+    bool interrupted = handleInterrupts(tStates);
+    while (!interrupted && tStates < Model::INTERRUPT_TSTATES &&
+           !(Run::HOOKS && paused)) {
+      word pc = state.registers.PC;
+      if constexpr (Run::HOOKS)
+        tStates = debugUntil(tStates, tStates + 1);
+      else
+        tStates = runUntil(tStates, tStates + 1);
+      syncPeripherals(tStates);
+      if (state.memory.fastRead(pc) != 0xFB)
+        interrupted = handleInterrupts(tStates);
+    }
   }
 
-  // Fire an interrupt
-  // Fire an interrupt
-  if (handleInterrupts(tStates)) {
-    // Interrupt fired
+  scheduler.schedule(EventScheduler::FRAME_END, frameCycles);
+
+  while (tStates < frameCycles && !(Run::HOOKS && paused)) {
+    if (state.tape.isPlaying())
+      scheduler.schedule(EventScheduler::TAPE_EDGE,
+                         peripheralTStates +
+                             (int)state.tape.tStatesToNextEdge());
+    else
+      scheduler.cancel(EventScheduler::TAPE_EDGE);
+
+    int lineTime;
+    if (beamRacing && state.memory.getVideoBuffer()->nextLineTime(lineTime))
+      scheduler.schedule(EventScheduler::SCANLINE, lineTime);
+    else
+      scheduler.cancel(EventScheduler::SCANLINE);
+
+    if constexpr (Run::HOOKS)
+      tStates = debugUntil(tStates, scheduler.nextTime());
+    else
+      tStates = runUntil(tStates, scheduler.nextTime());
+    syncPeripherals(tStates);
   }
 
-  while (tStates < frameCycles && running) {
-    if (paused) {
-      if (stepRequest) {
-        stepRequest = false;
-      } else {
-        break;
-      }
-    }
-
-    if (state.isHalted()) {
-      // CPU executes NOPs (4 T-states) while halted
-      tStates += 4;
-      state.addFrameTStates(4);
-      this->state.tape.update(4);
-      // R register is incremented during NOPs too (M1 cycles)
-      state.registers.R =
-          (state.registers.R & 0x80) | ((state.registers.R + 1) & 0x7F);
-      continue; // Skip fetch/execute
-    }
-
-    // Fast Load Trap
-    // Fast Load Trap
-    if (handleFastLoad()) {
-      continue;
-    }
-
-    // Fetch opcode
-    byte opcode = m_memory[state.registers.PC];
-
-    // Increment Refresh Register (Lower 7 bits) - happens on M1 cycle
-    state.registers.R =
-        (state.registers.R & 0x80) | ((state.registers.R + 1) & 0x7F);
-
-    // Increment PC past opcode
-    state.registers.PC++;
-
-    int cycles = 0;
-    bool handled = true;
-
-    // Hybrid dispatch: switch for common opcodes, catalogue for others
-    switch (opcode) {
-    case 0x00: // NOP
-      cycles = 4;
-      break;
-
-    case 0x07: // RLCA
-      Bit::rlca(state);
-      cycles = 4;
-      break;
-
-    case 0x08: // EX AF, AF'
-      Load::ex_af_af(state);
-      cycles = 4;
-      break;
-
-    case 0xD9: // EXX
-      Load::exx(state);
-      cycles = 4;
-      break;
-
-    case 0xDD: // IX
-      cycles = exec_index_opcode(0xDD);
-      break;
-
-    case 0xFD: // IY
-      cycles = exec_index_opcode(0xFD);
-      break;
-
-    case 0x0F: // RRCA
-      Bit::rrca(state);
-      cycles = 4;
-      break;
-
-    case 0x10: // DJNZ e
-      cycles = Control::djnz(state, (int8_t)state.getNextByteFromPC());
-      break;
-
-    // RST instructions
-    case 0xC7: // RST 00
-      cycles = Control::rst(state, 0x0000);
-      break;
-
-    case 0xCF: // RST 08
-      cycles = Control::rst(state, 0x0008);
-      break;
-
-    case 0xD7: // RST 10
-      cycles = Control::rst(state, 0x0010);
-      break;
-
-    case 0xDF: // RST 18
-      cycles = Control::rst(state, 0x0018);
-      break;
-
-    case 0xE7: // RST 20
-      cycles = Control::rst(state, 0x0020);
-      break;
-
-    case 0xEF: // RST 28
-      cycles = Control::rst(state, 0x0028);
-      break;
-
-    case 0xF7: // RST 30
-      cycles = Control::rst(state, 0x0030);
-      break;
-
-    case 0xFF: // RST 38
-      cycles = Control::rst(state, 0x0038);
-      break;
-
-    case 0x17: // RLA
-      Bit::rla(state);
-      cycles = 4;
-      break;
-
-    case 0x18: // JR e
-      cycles = Control::jr(state, (int8_t)state.getNextByteFromPC());
-      break;
-
-    case 0x1F: // RRA
-      Bit::rra(state);
-      cycles = 4;
-      break;
-
-    case 0x20: // JR NZ, e
-      cycles = Control::jr_cond(state, !GET_FLAG(Z_FLAG, state.registers),
-                                (int8_t)state.getNextByteFromPC());
-      break;
-
-    case 0x28: // JR Z, e
-      cycles = Control::jr_cond(state, GET_FLAG(Z_FLAG, state.registers),
-                                (int8_t)state.getNextByteFromPC());
-      break;
-
-    case 0x30: // JR NC, e
-      cycles = Control::jr_cond(state, !GET_FLAG(C_FLAG, state.registers),
-                                (int8_t)state.getNextByteFromPC());
-      break;
-
-    case 0x38: // JR C, e
-      cycles = Control::jr_cond(state, GET_FLAG(C_FLAG, state.registers),
-                                (int8_t)state.getNextByteFromPC());
-      break;
-
-    case 0x76: // HALT
-      state.setHalted(true);
-      cycles = 4;
-      break;
-
-    case 0x3E: { // LD A, n
-      byte value = m_memory[state.registers.PC++];
-      state.registers.A = value;
-      cycles = 7;
-      break;
-    }
-
-    case 0x06: { // LD B, n
-      byte value = m_memory[state.registers.PC++];
-      state.registers.B = value;
-      cycles = 7;
-      break;
-    }
-
-    case 0x0E: { // LD C, n
-      byte value = m_memory[state.registers.PC++];
-      state.registers.C = value;
-      cycles = 7;
-      break;
-    }
-
-    case 0x16: { // LD D, n
-      byte value = m_memory[state.registers.PC++];
-      state.registers.D = value;
-      cycles = 7;
-      break;
-    }
-
-    case 0x1E: { // LD E, n
-      byte value = m_memory[state.registers.PC++];
-      state.registers.E = value;
-      cycles = 7;
-      break;
-    }
-
-    case 0x26: { // LD H, n
-      byte value = m_memory[state.registers.PC++];
-      state.registers.H = value;
-      cycles = 7;
-      break;
-    }
-
-    case 0x2E: { // LD L, n
-      byte value = m_memory[state.registers.PC++];
-      state.registers.L = value;
-      cycles = 7;
-      break;
-    }
-
-    // 16-bit Load
-    case 0x21: { // LD HL, nn
-      word nn = state.getNextWordFromPC();
-      state.registers.PC += 2;
-      state.registers.HL = nn;
-      cycles = 10;
-      break;
-    }
-
-    case 0x22: { // LD (nn), HL
-      word addr = state.getNextWordFromPC();
-      state.registers.PC += 2;
-      writeMem(addr, state.registers.L);
-      writeMem(addr + 1, state.registers.H);
-      cycles = 16;
-      break;
-    }
-
-    case 0x2A: { // LD HL, (nn)
-      word addr = state.getNextWordFromPC();
-      state.registers.PC += 2;
-      state.registers.L = m_memory[addr];
-      state.registers.H = m_memory[addr + 1];
-      cycles = 16;
-      break;
-    }
-
-    // ------------------------------------------------------------------------
-    // 16-bit Arithmetic
-    // ------------------------------------------------------------------------
-    case 0x09: // ADD HL, BC
-      Arithmetic::add16(state, state.registers.HL, state.registers.BC);
-      cycles = 11;
-      break;
-    case 0x19: // ADD HL, DE
-      Arithmetic::add16(state, state.registers.HL, state.registers.DE);
-      cycles = 11;
-      break;
-    case 0x29: // ADD HL, HL
-      Arithmetic::add16(state, state.registers.HL, state.registers.HL);
-      cycles = 11;
-      break;
-    case 0x39: // ADD HL, SP
-      Arithmetic::add16(state, state.registers.HL, state.registers.SP);
-      cycles = 11;
-      break;
-
-    case 0xC3: // JP nn
-      cycles = Control::jp(state, state.getNextWordFromPC());
-      break;
-
-    case 0xE9: // JP (HL)
-      cycles = Control::jp_hl(state);
-      break;
-
-    // Conditional Jumps
-    case 0xC2: // JP NZ, nn
-      cycles = Control::jp_cond(state, !GET_FLAG(Z_FLAG, state.registers),
-                                state.getNextWordFromPC());
-      break;
-
-    case 0xCA: // JP Z, nn
-      cycles = Control::jp_cond(state, GET_FLAG(Z_FLAG, state.registers),
-                                state.getNextWordFromPC());
-      break;
-
-    case 0xD2: // JP NC, nn
-      cycles = Control::jp_cond(state, !GET_FLAG(C_FLAG, state.registers),
-                                state.getNextWordFromPC());
-      break;
-
-    case 0xD3: { // OUT (n), A
-      byte port = state.getNextByteFromPC();
-      state.registers.PC++;
-      cycles = IO::out_n_a(state, port);
-      break;
-    }
-
-    case 0xDA: // JP C, nn
-      cycles = Control::jp_cond(state, GET_FLAG(C_FLAG, state.registers),
-                                state.getNextWordFromPC());
-      break;
-
-    case 0xE2: // JP PO, nn
-      cycles = Control::jp_cond(state, !GET_FLAG(P_FLAG, state.registers),
-                                state.getNextWordFromPC());
-      break;
-
-    case 0xEA: // JP PE, nn
-      cycles = Control::jp_cond(state, GET_FLAG(P_FLAG, state.registers),
-                                state.getNextWordFromPC());
-      break;
-
-    case 0xF2: // JP P, nn
-      cycles = Control::jp_cond(state, !GET_FLAG(S_FLAG, state.registers),
-                                state.getNextWordFromPC());
-      break;
-
-    case 0xFA: // JP M, nn
-      cycles = Control::jp_cond(state, GET_FLAG(S_FLAG, state.registers),
-                                state.getNextWordFromPC());
-      break;
-
-    // Conditional Returns
-    case 0xC0: // RET NZ
-      cycles = Control::ret_cond(state, !GET_FLAG(Z_FLAG, state.registers));
-      break;
-
-    case 0xC8: // RET Z
-      cycles = Control::ret_cond(state, GET_FLAG(Z_FLAG, state.registers));
-      break;
-
-    case 0xD0: // RET NC
-      cycles = Control::ret_cond(state, !GET_FLAG(C_FLAG, state.registers));
-      break;
-
-    case 0xD8: // RET C
-      cycles = Control::ret_cond(state, GET_FLAG(C_FLAG, state.registers));
-      break;
-
-    case 0xE0: // RET PO
-      cycles = Control::ret_cond(state, !GET_FLAG(P_FLAG, state.registers));
-      break;
-
-    case 0xE8: // RET PE
-      cycles = Control::ret_cond(state, GET_FLAG(P_FLAG, state.registers));
-      break;
-
-    case 0xF0: // RET P
-      cycles = Control::ret_cond(state, !GET_FLAG(S_FLAG, state.registers));
-      break;
-
-    case 0xF8: // RET M
-      cycles = Control::ret_cond(state, GET_FLAG(S_FLAG, state.registers));
-      break;
-
-    case 0xC9: // RET
-      cycles = Control::ret(state);
-      break;
-
-    case 0xCD: // CALL nn
-      cycles = Control::call(state, state.getNextWordFromPC());
-      break;
-
-    // Conditional CALLs
-    case 0xC4: // CALL NZ, nn
-      cycles = Control::call_cond(state, !GET_FLAG(Z_FLAG, state.registers),
-                                  state.getNextWordFromPC());
-      break;
-
-    case 0xCB: // Prefix CB
-      cycles = exec_cb_opcode();
-      break;
-
-    case 0xED: // Extended
-      cycles = exec_ed_opcode();
-      break;
-
-    case 0xCC: // CALL Z, nn
-      cycles = Control::call_cond(state, GET_FLAG(Z_FLAG, state.registers),
-                                  state.getNextWordFromPC());
-      break;
-
-    case 0xD4: // CALL NC, nn
-      cycles = Control::call_cond(state, !GET_FLAG(C_FLAG, state.registers),
-                                  state.getNextWordFromPC());
-      break;
-
-    case 0xDB: { // IN A, (n)
-      byte port = state.getNextByteFromPC();
-      state.registers.PC++;
-      cycles = IO::in_a_n(state, port);
-      break;
-    }
-
-    case 0xDC: // CALL C, nn
-      cycles = Control::call_cond(state, GET_FLAG(C_FLAG, state.registers),
-                                  state.getNextWordFromPC());
-      break;
-
-    case 0xE4: // CALL PO, nn
-      cycles = Control::call_cond(state, !GET_FLAG(P_FLAG, state.registers),
-                                  state.getNextWordFromPC());
-      break;
-
-    case 0xEC: // CALL PE, nn
-      cycles = Control::call_cond(state, GET_FLAG(P_FLAG, state.registers),
-                                  state.getNextWordFromPC());
-      break;
-
-    case 0xF4: // CALL P, nn
-      cycles = Control::call_cond(state, !GET_FLAG(S_FLAG, state.registers),
-                                  state.getNextWordFromPC());
-      break;
-
-    case 0xFC: // CALL M, nn
-      cycles = Control::call_cond(state, GET_FLAG(S_FLAG, state.registers),
-                                  state.getNextWordFromPC());
-      break;
-
-    case 0xE3: // EX (SP), HL
-      Load::ex_sp_hl(state);
-      cycles = 19;
-      break;
-
-    case 0xEB: // EX DE, HL
-      Load::ex_de_hl(state);
-      cycles = 4;
-      break;
-
-    case 0xF9: // LD SP, HL
-      Load::ld_sp_hl(state);
-      cycles = 6;
-      break;
-
-    // ------------------------------------------------------------------------
-    // Immediate Arithmetic (0xC6, 0xCE, 0xD6, 0xDE, 0xE6, 0xEE, 0xF6, 0xFE)
-    // ------------------------------------------------------------------------
-    case 0xC6: { // ADD A, n
-      byte n = m_memory[state.registers.PC++];
-      Arithmetic::add8(state, n);
-      cycles = 7;
-      break;
-    }
-    case 0xCE: { // ADC A, n
-      byte n = m_memory[state.registers.PC++];
-      Arithmetic::adc8(state, n);
-      cycles = 7;
-      break;
-    }
-    case 0xD6: { // SUB n
-      byte n = m_memory[state.registers.PC++];
-      Arithmetic::sub8(state, n);
-      cycles = 7;
-      break;
-    }
-    case 0xDE: { // SBC A, n
-      byte n = m_memory[state.registers.PC++];
-      Arithmetic::sbc8(state, n);
-      cycles = 7;
-      break;
-    }
-    case 0xE6: { // AND n
-      byte n = m_memory[state.registers.PC++];
-      Logic::and8(state, n);
-      cycles = 7;
-      break;
-    }
-    case 0xEE: { // XOR n
-      byte n = m_memory[state.registers.PC++];
-      Logic::xor8(state, n);
-      cycles = 7;
-      break;
-    }
-    case 0xF6: { // OR n
-      byte n = m_memory[state.registers.PC++];
-      Logic::or8(state, n);
-      cycles = 7;
-      break;
-    }
-    case 0xFE: { // CP n
-      byte n = m_memory[state.registers.PC++];
-      Arithmetic::cp8(state, n);
-      cycles = 7;
-      break;
-    }
-
-    // ------------------------------------------------------------------------
-    // INC/DEC 8-bit
-    // ------------------------------------------------------------------------
-    case 0x04:
-      Arithmetic::inc8(state, state.registers.B);
-      cycles = 4;
-      break;
-    case 0x05:
-      Arithmetic::dec8(state, state.registers.B);
-      cycles = 4;
-      break;
-    case 0x0C:
-      Arithmetic::inc8(state, state.registers.C);
-      cycles = 4;
-      break;
-    case 0x0D:
-      Arithmetic::dec8(state, state.registers.C);
-      cycles = 4;
-      break;
-    case 0x14:
-      Arithmetic::inc8(state, state.registers.D);
-      cycles = 4;
-      break;
-    case 0x15:
-      Arithmetic::dec8(state, state.registers.D);
-      cycles = 4;
-      break;
-    case 0x1C:
-      Arithmetic::inc8(state, state.registers.E);
-      cycles = 4;
-      break;
-    case 0x1D:
-      Arithmetic::dec8(state, state.registers.E);
-      cycles = 4;
-      break;
-    case 0x24:
-      Arithmetic::inc8(state, state.registers.H);
-      cycles = 4;
-      break;
-    case 0x25:
-      Arithmetic::dec8(state, state.registers.H);
-      cycles = 4;
-      break;
-    case 0x2C:
-      Arithmetic::inc8(state, state.registers.L);
-      cycles = 4;
-      break;
-    case 0x2D:
-      Arithmetic::dec8(state, state.registers.L);
-      cycles = 4;
-      break;
-
-    case 0x3C:
-      Arithmetic::inc8(state, state.registers.A);
-      cycles = 4;
-      break;
-    case 0x3D:
-      Arithmetic::dec8(state, state.registers.A);
-      cycles = 4;
-      break;
-
-    case 0x34: { // INC (HL)
-      byte val = m_memory[state.registers.HL];
-      Arithmetic::inc8(state, val);
-      writeMem(state.registers.HL, val);
-      cycles = 11;
-      break;
-    }
-    case 0x35: { // DEC (HL)
-      byte val = m_memory[state.registers.HL];
-      Arithmetic::dec8(state, val);
-      writeMem(state.registers.HL, val);
-      cycles = 11;
-      break;
-    }
-
-      // ------------------------------------------------------------------------
-      // Misc
-      // ------------------------------------------------------------------------
-
-    case 0x3F: // CCF
-      Logic::ccf(state);
-      cycles = 4;
-      break;
-
-    case 0x27: // DAA
-      Arithmetic::daa(state);
-      cycles = 4;
-      break;
-
-    case 0x2F: // CPL
-      Logic::cpl(state);
-      cycles = 4;
-      break;
-
-    case 0x37: // SCF
-      Logic::scf(state);
-      cycles = 4;
-      break;
-
-    case 0xF3: // DI
-      cycles = Control::di(state);
-      break;
-
-    case 0xFB: // EI
-      cycles = Control::ei(state);
-      break;
-
-    // ------------------------------------------------------------------------
-    // INC/DEC 16-bit (BC, DE, HL, SP)
-    // ------------------------------------------------------------------------
-    case 0x03:
-      Arithmetic::inc16(state, state.registers.BC);
-      cycles = 6;
-      break;
-    case 0x0B:
-      Arithmetic::dec16(state, state.registers.BC);
-      cycles = 6;
-      break;
-    case 0x13:
-      Arithmetic::inc16(state, state.registers.DE);
-      cycles = 6;
-      break;
-    case 0x1B:
-      Arithmetic::dec16(state, state.registers.DE);
-      cycles = 6;
-      break;
-    case 0x23:
-      Arithmetic::inc16(state, state.registers.HL);
-      cycles = 6;
-      break;
-    case 0x2B:
-      Arithmetic::dec16(state, state.registers.HL);
-      cycles = 6;
-      break;
-    case 0x33:
-      Arithmetic::inc16(state, state.registers.SP);
-      cycles = 6;
-      break;
-    case 0x3B:
-      Arithmetic::dec16(state, state.registers.SP);
-      cycles = 6;
-      break;
-
-    // RESTORED CASES (Accidentally deleted)
-    // LD (BC), A and LD A, (BC)
-    case 0x02:
-      writeMem(state.registers.BC, state.registers.A);
-      cycles = 7;
-      break;
-    case 0x0A:
-      state.registers.A = m_memory[state.registers.BC];
-      cycles = 7;
-      break;
-
-    // LD (DE), A and LD A, (DE)
-    case 0x12:
-      writeMem(state.registers.DE, state.registers.A);
-      cycles = 7;
-      break;
-    case 0x1A:
-      state.registers.A = m_memory[state.registers.DE];
-      cycles = 7;
-      break;
-
-    // 16-bit loads with immediates
-    case 0x01: { // LD BC, nn
-      word value = m_memory[state.registers.PC] |
-                   (m_memory[state.registers.PC + 1] << 8);
-      state.registers.PC += 2;
-      state.registers.BC = value;
-      cycles = 10;
-      break;
-    }
-
-    case 0x11: { // LD DE, nn
-      word value = m_memory[state.registers.PC] |
-                   (m_memory[state.registers.PC + 1] << 8);
-      state.registers.PC += 2;
-      state.registers.DE = value;
-      cycles = 10;
-      break;
-    }
-
-    // Stack Operations (PUSH/POP)
-    case 0xC1: // POP BC
-      state.registers.C = m_memory[state.registers.SP];
-      state.registers.B = m_memory[state.registers.SP + 1];
-      state.registers.SP += 2;
-      cycles = 10;
-      break;
-    case 0xD1: // POP DE
-      state.registers.E = m_memory[state.registers.SP];
-      state.registers.D = m_memory[state.registers.SP + 1];
-      state.registers.SP += 2;
-      cycles = 10;
-      break;
-    case 0xE1: // POP HL
-      state.registers.L = m_memory[state.registers.SP];
-      state.registers.H = m_memory[state.registers.SP + 1];
-      state.registers.SP += 2;
-      cycles = 10;
-      break;
-    case 0xF1: // POP AF
-      state.registers.F = m_memory[state.registers.SP];
-      state.registers.A = m_memory[state.registers.SP + 1];
-      state.registers.SP += 2;
-      cycles = 10;
-      break;
-
-    case 0xC5: // PUSH BC
-      state.registers.SP -= 2;
-      writeMem(state.registers.SP, state.registers.C);
-      writeMem(state.registers.SP + 1, state.registers.B);
-      cycles = 11;
-      break;
-    case 0xD5: // PUSH DE
-      state.registers.SP -= 2;
-      writeMem(state.registers.SP, state.registers.E);
-      writeMem(state.registers.SP + 1, state.registers.D);
-      cycles = 11;
-      break;
-    case 0xE5: // PUSH HL
-      state.registers.SP -= 2;
-      writeMem(state.registers.SP, state.registers.L);
-      writeMem(state.registers.SP + 1, state.registers.H);
-      cycles = 11;
-      break;
-    case 0xF5: // PUSH AF
-      state.registers.SP -= 2;
-      writeMem(state.registers.SP, state.registers.F);
-      writeMem(state.registers.SP + 1, state.registers.A);
-      cycles = 11;
-      break;
-
-    case 0x31: { // LD SP, nn
-      word value = m_memory[state.registers.PC] |
-                   (m_memory[state.registers.PC + 1] << 8);
-      state.registers.PC += 2;
-      state.registers.SP = value;
-      cycles = 10;
-      break;
-    }
-
-    case 0x32: { // LD (nn), A
-      word address = m_memory[state.registers.PC] |
-                     (m_memory[state.registers.PC + 1] << 8);
-      state.registers.PC += 2;
-      writeMem(address, state.registers.A);
-      cycles = 13;
-      break;
-    }
+  // Stopped by the debugger, to carry on from here
+  midFrame = tStates < frameCycles;
+  if (midFrame) {
+    stoppedTStates = tStates;
+    state.lazyFlags.materialise(state.registers);
+    return;
+  }
+  tStateCarry = tStates - frameCycles;
 
-    case 0x3A: { // LD A, (nn)
-      word address = m_memory[state.registers.PC] |
-                     (m_memory[state.registers.PC + 1] << 8);
-      state.registers.PC += 2;
-      state.registers.A = m_memory[address];
-      cycles = 13;
-      break;
-    }
+  // The whole display is latched by the time the frame is handed over
+  if (beamRacing)
+    state.memory.getVideoBuffer()->latchUntil(frameCycles);
 
-    case 0x36: { // LD (HL), n
-      byte value = m_memory[state.registers.PC++];
-      writeMem(state.registers.HL, value);
-      cycles = 10;
-      break;
-    }
+  state.lazyFlags.materialise(state.registers);
+  if (audioWanted)
+    audio.renderFrame(state.getAudioEdges(), tStates);
+  else
+    state.getAudioEdges().clear();
 
-    default:
-      // Handle Grouped 8-bit Loads (0x40 - 0x7F)
-      // Note: 0x76 (HALT) is handled by specific case above, so it wont reach
-      // here.
-      if (opcode >= 0x40 && opcode <= 0x7F) {
-        cycles = exec_loads_8bit(opcode);
-        handled = true;
-        break;
-      }
-      // Handle Grouped 8-bit ALU (0x80 - 0xBF)
-      if (opcode >= 0x80 && opcode <= 0xBF) {
-        cycles = exec_alu_8bit(opcode);
-        handled = true;
-        break;
-      }
-
-      // Fall back to catalogue for opcodes not yet migrated
-      handled = false;
-      break;
-    }
+  // A real time sink holds the frame rate to the audio card clock
+  if (!turbo)
+    audio.getSink().throttle();
+}
 
-    if (handled) {
-      tStates += cycles;
-      state.addFrameTStates(cycles);
-      this->state.tape.update(cycles);
-      audio.update(cycles, state.getSpeakerBit(), state.tape.getEarBit());
-    } else {
-      // Fallback removed (Legacy OpCode classes removed)
-      // Any unhandled opcode acts as NOP or Error
-      /*
-      state.registers.PC--; // Rewind PC for catalogue lookup
-      OpCode *opCode = getNextInstruction();
-      if (opCode != nullptr) { ... }
-      */
-
-      byte unknownOpcode = state.memory[state.registers.PC];
-      char errorMsg[100];
-      snprintf(errorMsg, sizeof(errorMsg), "Unknown opcode %02X at address %d",
-               unknownOpcode, this->state.registers.PC);
-      lastError = std::string(errorMsg);
-
-      debug("Unknown opcode %02X at address %d\n", unknownOpcode,
-            this->state.registers.PC);
-      running = false;
-    }
+// Each machine has its own copy of the frame loop
+template <class Run> void Processor::runFrame() {
+  switch (machine) {
+  case Machine::SPECTRUM_48K:
+    frameLoop<Spectrum48K, Run>();
+    break;
+  case Machine::SPECTRUM_128K:
+    frameLoop<Spectrum128K, Run>();
+    break;
+  case Machine::PLUS_2A:
+    frameLoop<Plus2A, Run>();
+    break;
   }
-  // } // Extraneous brace removed
-  audio.flush();
-
-  // Audio Sync: Throttle execution to match audio consumption rate
-  // If buffer has > 3 frames of audio (approx 60ms), slow down.
-  // This locks emulation speed to the audio card clock (44.1kHz).
-  if (!turbo) {
-    while (audio.getBufferSize() > 2646) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
+}
+
+void Processor::executeFrame() {
+  if (!running)
+    return;
+
+  // The loop is chosen here, at the frame boundary, so the fast loop never
+  // looks for the debugger
+  if (debugMode || paused || midFrame || stepMode != StepMode::NONE) {
+    runFrame<DebugRun>();
+  } else {
+    leaveBreakpoint = false;
+    runFrame<FastRun>();
   }
 
   // Auto-Type Logic (Frame based)
@@ -1066,6 +387,7 @@ void Processor::shutdown() {}
 void Processor::reset() {
   state.registers.PC = 0x0;
   state.registers.AF = 0xFFFF;
+  state.lazyFlags.discard();
   state.registers.SP = 0xFFFF;
   state.registers.BC = 0;
   state.registers.DE = 0;
@@ -1077,12 +399,450 @@ void Processor::reset() {
   state.setHalted(false);
   state.setInterrupts(false);
   state.setInterruptMode(0); // Reset to IM 0
+  state.memory.setPagingRegister(0);
+  state.memory.setPlusPagingRegister(0);
+  state.ay.reset();
   lastError = "";
   running = true;
   paused = false;
+  midFrame = false;
+  stepMode = StepMode::NONE;
+  debugger.resetStop();
+  tStateCarry = 0;
+  state.resetAudio();
   audio.reset();
 }
 
+/**
+ * Choose where the audio goes. Without a sink no samples are generated.
+ * @param sink the sink, or nullptr for none
+ */
+void Processor::setAudioSink(AudioSink *sink) {
+  audio.setSink(sink ? *sink : nullAudioSink);
+  audioWanted = audio.getSink().wantsSamples();
+}
+
+/**
+ * Run instructions until the next scheduled event. Peripherals are only
+ * brought up to date before a port access.
+ * @param tStates the current frame time
+ * @param limit frame time of the next event
+ * @return the frame time reached
+ */
+int Processor::runUntil(int tStates, int limit) {
+  // Inputs may have changed at the event that got us here
+  for (IdleLoop &loop : idleLoops)
+    loop.armed = false;
+
+  do {
+    if (state.isHalted()) {
+      // CPU executes NOPs (4 T-states) while halted. Nothing but an event
+      // can end the HALT, so run every NOP up to the next one at once.
+      int nops = idleSkipping ? std::max(1, (limit - tStates + 3) / 4) : 1;
+      tStates += nops * 4;
+      // R register is incremented during NOPs too (M1 cycles)
+      state.registers.R =
+          (state.registers.R & 0x80) | ((state.registers.R + nops) & 0x7F);
+      continue; // Skip fetch/execute
+    }
+
+    // Fast Load Trap
+    if (handleFastLoad()) {
+      continue;
+    }
+
+    const word pc = state.registers.PC;
+    DecodeCache::Entry entry = Opcodes::lookup(state, pc, lazyFlags);
+    if (entry.flags & DecodeCache::PORT_IO)
+      syncPeripherals(tStates);
+
+    if (entry.flags & DecodeCache::REPEATS)
+      tStates += executeRepeat(entry, tStates, limit);
+    else if (blockReplay)
+      tStates += executeBlock(limit - tStates);
+    else
+      tStates += executeInstruction(entry);
+
+    // Jumped back to what may be the head of a spin loop
+    if (idleSkipping && (word)(pc - state.registers.PC) < IDLE_LOOP_SPAN)
+      tStates = skipIdleLoop(tStates, limit);
+  } while (tStates < limit);
+
+  return tStates;
+}
+
+/**
+ * The debug loop's runUntil: an instruction at a time on a DebugBus, with
+ * the peripherals brought up to date before each. Stops before a
+ * breakpoint or the end of a step over, and after an instruction that
+ * touched a watchpoint or ended a step. Nothing is run in bulk or skipped
+ * but a HALT.
+ * @param tStates the current frame time
+ * @param limit frame time of the next event
+ * @return the frame time reached
+ */
+int Processor::debugUntil(int tStates, int limit) {
+  Z80Registers &r = state.registers;
+  DebugBus bus(state, debugger);
+  // The debug bus runs the handlers that build F as they go
+  state.lazyFlags.materialise(r);
+
+  do {
+    if (!state.isHalted() && !leaveBreakpoint) {
+      if (debugger.isBreakpoint(r.PC))
+        debugger.stop(Debugger::StopReason::BREAKPOINT, r.PC);
+      else if (stepMode == StepMode::OVER && r.PC == stepTarget &&
+               r.SP >= stepSP)
+        debugger.stop(Debugger::StopReason::STEP, r.PC);
+      if (debugger.isStopping()) {
+        stopDebugging();
+        break;
+      }
+    }
+    leaveBreakpoint = false;
+    syncPeripherals(tStates);
+
+    if (state.isHalted() && stepMode != StepMode::INSTRUCTION) {
+      int nops = idleSkipping ? std::max(1, (limit - tStates + 3) / 4) : 1;
+      tStates += nops * 4;
+      r.R = (r.R & 0x80) | ((r.R + nops) & 0x7F);
+      continue;
+    }
+
+    // Returns are RET, RET cc, RETI and RETN
+    const word pc = r.PC;
+    byte op = state.memory.fastRead(pc);
+    bool returns = op == 0xC9 || (op & 0xC7) == 0xC0 ||
+                   (op == 0xED &&
+                    (state.memory.fastRead((word)(pc + 1)) & 0xC7) == 0x45);
+
+    if (!handleFastLoad()) {
+      bus.load();
+      tStates += Opcodes::step(bus);
+      bus.store();
+    }
+
+    if (stepMode == StepMode::INSTRUCTION ||
+        (stepMode == StepMode::OUT && returns && r.SP > stepSP))
+      debugger.stop(Debugger::StopReason::STEP, r.PC);
+    if (debugger.isStopping()) {
+      stopDebugging();
+      break;
+    }
+  } while (tStates < limit);
+
+  return tStates;
+}
+
+/**
+ * Run from a pause with a step of some kind, stopping as it ends
+ * @param mode what to run
+ */
+void Processor::startStep(StepMode mode) {
+  if (!paused)
+    return;
+  resume();
+  stepMode = mode;
+  stepSP = state.registers.SP;
+}
+
+void Processor::stepOver() {
+  const word pc = state.registers.PC;
+  byte op = state.memory.fastRead(pc);
+  byte next = state.memory.fastRead((word)(pc + 1));
+  int length = 0;
+  if (op == 0xCD || (op & 0xC7) == 0xC4) // CALL, CALL cc
+    length = 3;
+  else if ((op & 0xC7) == 0xC7) // RST
+    length = 1;
+  else if (op == 0xED && (next & 0xF4) == 0xB0) // LDIR, CPIR, INIR, OTIR...
+    length = 2;
+
+  if (!length) {
+    step();
+    return;
+  }
+  startStep(StepMode::OVER);
+  stepTarget = pc + length;
+}
+
+void Processor::resume() {
+  // The instruction at a breakpoint runs when carrying on from it
+  leaveBreakpoint = paused;
+  paused = false;
+  stepMode = StepMode::NONE;
+  debugger.resetStop();
+}
+
+/**
+ * Pause where the debug loop has got to; the reason is the debugger's stop
+ */
+void Processor::stopDebugging() {
+  paused = true;
+  stepMode = StepMode::NONE;
+}
+
+/**
+ * Fast-forward a loop that can't change anything before the next event.
+ * Called at the target of each backward jump. A DJNZ to itself is counted
+ * down directly. Otherwise the state here is compared with the last visit
+ * to the same head: if no register changed, nothing was written to RAM or
+ * a port, and inputs only change at events, every pass from here to the
+ * limit repeats the last one. Whole passes are skipped while the limit is
+ * still ahead, leaving the final partial pass to run as normal.
+ * @param tStates the current frame time, at the loop head
+ * @param limit the frame time of the next event
+ * @return the frame time after any passes skipped
+ */
+int Processor::skipIdleLoop(int tStates, int limit) {
+  Z80Registers &r = state.registers;
+  Memory &memory = state.memory;
+
+  if (memory.fastRead(r.PC) == 0x10 &&
+      memory.fastRead((word)(r.PC + 1)) == 0xFE) {
+    // DJNZ $ takes 13 T-states a pass and 8 for the last
+    int passes = std::min((r.B ? r.B : 256) - 1, (limit - tStates - 1) / 13);
+    if (passes > 0) {
+      r.B -= passes;
+      r.R = (r.R & 0x80) | ((r.R + passes) & 0x7F);
+      tStates += passes * 13;
+      stats.idleLoopsSkipped++;
+      stats.idleTStatesSkipped += passes * 13;
+    }
+    return tStates;
+  }
+
+  IdleLoop *loop = nullptr;
+  for (IdleLoop &candidate : idleLoops) {
+    if (candidate.used && candidate.head == r.PC)
+      loop = &candidate;
+  }
+
+  if (!loop) {
+    loop = &idleLoops[nextIdleLoop];
+    nextIdleLoop = (nextIdleLoop + 1) % IDLE_LOOP_HEADS;
+    *loop = IdleLoop();
+    loop->used = true;
+    loop->head = r.PC;
+  } else if (loop->wait > 0) {
+    // Most backward jumps are busy loops; look at them less and less often
+    loop->wait--;
+    return tStates;
+  }
+
+  // Registers are compared and saved with F up to date
+  state.lazyFlags.materialise(r);
+
+  if (loop->armed) {
+    Z80Registers now = r;
+    now.R = loop->registers.R;
+    if (loop->changes != memory.getChanges() ||
+        loop->portWrites != state.getPortWrites() ||
+        memcmp(&now, &loop->registers, sizeof(now)) != 0) {
+      loop->backoff = std::min(loop->backoff * 2 + 1, IDLE_LOOP_BACKOFF);
+      loop->wait = loop->backoff;
+      loop->armed = false;
+      return tStates;
+    }
+
+    int period = tStates - loop->tStates;
+    int passes = period > 0 ? (limit - tStates - 1) / period : 0;
+    if (passes > 0) {
+      int instructions = (r.R - loop->registers.R) & 0x7F;
+      r.R = (r.R & 0x80) | ((r.R + passes * instructions) & 0x7F);
+      tStates += passes * period;
+      stats.idleLoopsSkipped++;
+      stats.idleTStatesSkipped += passes * period;
+    }
+    loop->backoff = 0;
+  }
+
+  loop->armed = true;
+  loop->tStates = tStates;
+  loop->changes = memory.getChanges();
+  loop->portWrites = state.getPortWrites();
+  loop->registers = r;
+  return tStates;
+}
+
+/**
+ * Bring the frame clock, tape and audio up to the given frame time
+ * @param tStates the current frame time
+ */
+void Processor::syncPeripherals(int tStates) {
+  int elapsed = tStates - peripheralTStates;
+  peripheralTStates = tStates;
+  state.setFrameTStates(tStates);
+
+  // A tape edge lands here, as the scheduler stops on each one
+  if (state.tape.isPlaying()) {
+    state.tape.update(elapsed);
+    state.noteAudioLevel();
+  }
+
+  // As does the start of each display line
+  if (beamRacing)
+    state.memory.getVideoBuffer()->latchUntil(tStates);
+}
+
+/**
+ * Execute a decoded instruction at PC
+ * @param entry the decoded instruction
+ * @return T-states used
+ */
+int Processor::executeInstruction(const DecodeCache::Entry &entry) {
+  // Increment Refresh Register (Lower 7 bits) - happens on M1 cycle
+  state.registers.R =
+      (state.registers.R & 0x80) | ((state.registers.R + 1) & 0x7F);
+
+  // Step PC past the opcode (and any prefix) and run the handler
+  state.registers.PC += entry.skip;
+  return entry.handler(state);
+}
+
+/**
+ * Run a repeating block instruction (LDIR, CPIR, INIR...) for every pass
+ * the iterative path would run before the limit, without going back
+ * through the run loop. LDIR/LDDR/CPIR/CPDR use bulk kernels when they
+ * can; everything else repeats the handler here.
+ * @param entry the decoded instruction at PC
+ * @param tStates the current frame time
+ * @param limit the frame time of the next event
+ * @return T-states used
+ */
+int Processor::executeRepeat(const DecodeCache::Entry &entry, int tStates,
+                             int limit) {
+  Z80Registers &r = state.registers;
+  const word start = r.PC;
+
+  // A pass repeats at 21 T-states and the last one takes 16, so the
+  // iterative path runs until 21 per pass reaches the limit
+  int iterations = std::max(1, (limit - tStates + 20) / 21);
+
+  // The kernels write F directly
+  state.lazyFlags.materialise(r);
+
+  int passes = 0;
+  r.PC = start + 2;
+  switch (state.memory.fastRead((word)(start + 1))) {
+  case 0xB0:
+    passes = Load::ldirBulk(state, iterations);
+    break;
+  case 0xB8:
+    passes = Load::lddrBulk(state, iterations);
+    break;
+  case 0xB1:
+    passes = Control::cpirBulk(state, iterations);
+    break;
+  case 0xB9:
+    passes = Control::cpdrBulk(state, iterations);
+    break;
+  }
+
+  if (passes) {
+    r.R = (r.R & 0x80) | ((r.R + passes) & 0x7F);
+    return passes * 21 - (r.PC == start ? 0 : 5);
+  }
+
+  // One pass at a time, stopping if a write lands on cached code in case
+  // it was this instruction
+  r.PC = start;
+  unsigned long generation = state.memory.getDecodeCache().getGeneration();
+  int cycles = 0;
+  do {
+    if (entry.flags & DecodeCache::PORT_IO)
+      syncPeripherals(tStates + cycles);
+    cycles += executeInstruction(entry);
+  } while (r.PC == start && tStates + cycles < limit &&
+           state.memory.getDecodeCache().getGeneration() == generation);
+  return cycles;
+}
+
+/**
+ * Replay the recorded block at PC, recording it first if there isn't one.
+ * Stops early once the budget is used or if the code is written to.
+ * @param budget T-states left in the frame
+ * @return T-states used
+ */
+int Processor::executeBlock(int budget) {
+  DecodeCache &decoded = state.memory.getDecodeCache();
+  const DecodeCache::Block *block = decoded.block(state.registers.PC);
+  if (!block)
+    return recordBlock(budget);
+
+  unsigned long generation = decoded.getGeneration();
+  int cycles = 0;
+  for (const DecodeCache::Entry &op : block->ops) {
+    state.registers.R =
+        (state.registers.R & 0x80) | ((state.registers.R + 1) & 0x7F);
+    state.registers.PC += op.skip;
+    cycles += op.handler(state);
+    // The block may have been freed if it wrote to itself
+    if (cycles >= budget || decoded.getGeneration() != generation)
+      break;
+  }
+  return cycles;
+}
+
+/**
+ * Execute instructions from PC one at a time, recording them as a block.
+ * The block ends at the first instruction that can jump, before any port
+ * access that isn't its first instruction (so the beeper level only changes
+ * at the start of a block), or when it reaches the fast load trap.
+ * @param budget T-states left in the frame
+ * @return T-states used
+ */
+int Processor::recordBlock(int budget) {
+  DecodeCache &decoded = state.memory.getDecodeCache();
+  unsigned long generation = decoded.getGeneration();
+
+  auto block = std::make_unique<DecodeCache::Block>();
+  block->start = state.registers.PC;
+  word pc = state.registers.PC;
+  int cycles = 0;
+  bool complete = false;
+
+  while (true) {
+    DecodeCache::Entry entry = Opcodes::lookup(state, pc, lazyFlags);
+    if ((entry.flags & DecodeCache::PORT_IO) && !block->ops.empty()) {
+      complete = true;
+      break;
+    }
+
+    state.registers.R =
+        (state.registers.R & 0x80) | ((state.registers.R + 1) & 0x7F);
+    state.registers.PC += entry.skip;
+    cycles += entry.handler(state);
+    block->ops.push_back(entry);
+
+    word next = state.registers.PC;
+    if ((entry.flags & DecodeCache::ENDS_BLOCK) || next == FAST_LOAD_TRAP ||
+        next < pc ||
+        next - block->start > DecodeCache::MAX_BLOCK_SPAN -
+                                  DecodeCache::MAX_INSTRUCTION_LENGTH) {
+      complete = true;
+      break;
+    }
+    if (cycles >= budget || decoded.getGeneration() != generation)
+      break;
+    pc = next;
+  }
+
+  // Only keep blocks that ran to a natural end over code that didn't change
+  if (complete && decoded.getGeneration() == generation) {
+    block->span = pc - block->start + DecodeCache::MAX_INSTRUCTION_LENGTH;
+    decoded.storeBlock(std::move(block));
+  }
+  return cycles;
+}
+
+void Processor::setLazyFlags(bool value) {
+  state.lazyFlags.materialise(state.registers);
+  lazyFlags = value;
+  // Prefixed entries are decoded differently by the two cores
+  state.memory.getDecodeCache().clear();
+}
+
 void Processor::writeMem(word address, byte value) {
   state.memory.fastWrite(address, value);
 }
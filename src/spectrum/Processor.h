@@ -19,6 +19,8 @@
 
 // #include "Opcodes/OpCodeCatalogue.h" // Removed
 #include "../utils/BaseTypes.h"
+#include "Debugger.h"
+#include "EventScheduler.h"
 #include "ProcessorState.h"
 
 #include "Audio.h"
@@ -26,16 +28,70 @@
 class Processor {
   friend class InstructionTest;
 
+public:
+  // Run loop counters, for the debugger
+  struct Stats {
+    long idleLoopsSkipped = 0; // times a spin loop was fast-forwarded
+    long idleTStatesSkipped = 0;
+  };
+
 private:
   // State variables
   ProcessorState state;
+  NullAudioSink nullAudioSink;
   Audio audio;
+  bool audioWanted = false; // Sink takes samples, so generate them
+  EventScheduler scheduler;
+  Machine machine = Machine::SPECTRUM_48K; // Chosen by the ROM set loaded
   // OpCodeCatalogue catalogue = OpCodeCatalogue(); // Removed
 
   bool running = false;
   bool paused = false;
-  bool stepRequest = false;
   bool turbo = false; // Bypass audio sync for benchmarking
+  bool lazyFlags = false; // Use the deferred flag core
+  bool blockReplay = false; // Replay recorded blocks
+  bool idleSkipping = true; // Fast-forward HALT and spin loops
+  bool beamRacing = false; // Latch display lines as the beam reaches them
+
+  // Frame timing
+  int tStateCarry = 0;       // Overrun of the last instruction of a frame
+  int peripheralTStates = 0; // Frame time the tape and audio have reached
+
+  // Debugging. The debug loop runs whole frames, from the next frame
+  // boundary on, while debugMode is set or the processor is paused or
+  // stepping; a frame it stops partway through is picked up where it
+  // stopped.
+  enum class StepMode { NONE, INSTRUCTION, OVER, OUT };
+  Debugger debugger;
+  bool debugMode = false;
+  bool midFrame = false;        // Stopped partway through a frame
+  int stoppedTStates = 0;       // Frame time it stopped at
+  bool leaveBreakpoint = false; // Run the instruction at PC, breakpoint or not
+  StepMode stepMode = StepMode::NONE;
+  word stepTarget = 0; // Step over: the instruction after the call
+  word stepSP = 0;     // Step over and out: SP as the step started
+
+  // Idle loop detection. State at the last few backward jump targets; a
+  // second visit to the same head with nothing changed means the loop
+  // will repeat exactly until the next event. A loop calling a routine
+  // returns backwards as well, hence more than one head.
+  static constexpr int IDLE_LOOP_SPAN = 256; // furthest backward jump
+  static constexpr int IDLE_LOOP_HEADS = 4;
+  static constexpr int IDLE_LOOP_BACKOFF = 63; // most visits left unchecked
+  struct IdleLoop {
+    bool used = false;  // tracking head
+    bool armed = false; // registers etc. hold the state at the last visit
+    word head = 0;
+    int backoff = 0; // visits to skip after the next mismatch
+    int wait = 0;    // visits still to skip
+    int tStates = 0;
+    unsigned long changes = 0;
+    unsigned long portWrites = 0;
+    Z80Registers registers;
+  };
+  IdleLoop idleLoops[IDLE_LOOP_HEADS];
+  int nextIdleLoop = 0; // slot replaced by the next new head
+  Stats stats;
 
   // Auto-Load
   bool autoLoadTape = false;
@@ -46,12 +102,30 @@ private:
   // Internal methods
   // OpCode *getNextInstruction(); // Removed
 
-  // Fast direct memory access
-  byte *m_memory = nullptr;
-
   // Write with ROM protection
   void writeMem(word address, byte value);
 
+  // ROM LD-BYTES entry point, trapped for fast loading
+  static constexpr word FAST_LOAD_TRAP = 0x0556;
+
+  // Machine models, see MachineModel.h
+  void selectMachine(Machine value);
+  template <class Model> void configure();
+
+  // Run loop policies. The fast loop has no debugger hooks at all; the
+  // debug loop runs an instruction at a time on a DebugBus.
+  struct FastRun {
+    static constexpr bool HOOKS = false;
+  };
+  struct DebugRun {
+    static constexpr bool HOOKS = true;
+  };
+  template <class Run> void runFrame();
+  template <class Model, class Run> void frameLoop();
+
+  void startStep(StepMode mode);
+  void stopDebugging();
+
   // Core helpers
   bool handleInterrupts(int &tStates);
   bool
@@ -60,25 +134,15 @@ private:
   // Stack helpers with safe memory access
   // Stack helpers moved to instructions/LoadInstructions.h
 
-  // Block execution helpers
-  int exec_loads_8bit(byte opcode); // 0x40 - 0x7F
-  int exec_alu_8bit(byte opcode);   // 0x80 - 0xBF
-
-  // Helper methods for instruction groups
-  void op_load(byte opcode);
-  void op_arithmetic(byte opcode);
-  void op_logic(byte opcode);
-  void op_rotate_shift(byte opcode);
-  void op_bit(byte opcode);
-  void op_jump(byte opcode);
-  void op_stack(byte opcode);
-  void op_io(byte opcode);
-  void op_misc(byte opcode);
-
-  // Extended instruction handlers
-  int exec_ed_opcode();
-  int exec_cb_opcode();
-  int exec_index_opcode(emulator_types::byte prefix); // DD or FD
+  // Opcode execution is table driven, see OpcodeTables.h
+  int runUntil(int tStates, int limit);
+  int debugUntil(int tStates, int limit);
+  void syncPeripherals(int tStates);
+  int executeInstruction(const DecodeCache::Entry &entry);
+  int executeRepeat(const DecodeCache::Entry &entry, int tStates, int limit);
+  int executeBlock(int budget);
+  int recordBlock(int budget);
+  int skipIdleLoop(int tStates, int limit);
 
   // ALU Helpers
   // ALU Helpers moved to instructions/ArithmeticInstructions.h and
@@ -90,12 +154,17 @@ public:
   // OpCode *getOpCode(byte b) { return catalogue.lookupOpcode(b); } // Removed
 
   void init(const char *romFile);
+  void init(Rom &rom);
   void loadTape(Tape tape);
   void loadSnapshot(const char *filename);
 
   void run();
   void executeFrame();
 
+  Machine getMachine() const { return machine; }
+  // T-states in a frame of the machine
+  int getFrameLength() const;
+
   std::string lastError = "";
 
   std::vector<byte> fetchOperands(int count);
@@ -114,21 +183,58 @@ public:
 
   VideoBuffer *getVideoBuffer();
   ProcessorState &getState() { return state; } // Expose for debugger
+  void setAudioSink(AudioSink *sink); // nullptr for no audio
   bool isRunning() const { return running; }
   const std::string &getLastError() const { return lastError; }
 
   void shutdown();
 
-  // Debug control
+  // Debug control. Pausing takes effect at the end of the frame.
   void reset();
   void pause() { paused = true; }
-  void resume() { paused = false; }
-  void step() {
-    if (paused)
-      stepRequest = true;
-  }
+  void resume();
+  // Run one instruction, once paused
+  void step() { startStep(StepMode::INSTRUCTION); }
+  // Run a call, RST or repeating block instruction through to the
+  // instruction after it, or step any other instruction
+  void stepOver();
+  // Run until the current routine returns
+  void stepOut() { startStep(StepMode::OUT); }
   bool isPaused() const { return paused; }
+
+  // Run the debug loop, with breakpoints and watchpoints, from the next
+  // frame. Pausing and stepping use it whatever this is set to.
+  void setDebugMode(bool value) { debugMode = value; }
+  bool isDebugMode() const { return debugMode; }
+  Debugger &getDebugger() { return debugger; }
+
   void setTurbo(bool t) { turbo = t; }
+  const Stats &getStats() const { return stats; }
+  void resetStats() { stats = Stats(); }
+
+  // Select the lazy flag core. F is only built when an instruction needs it
+  // and is always up to date between frames.
+  void setLazyFlags(bool value);
+  bool isLazyFlags() const { return lazyFlags; }
+
+  // Run straight-line code by replaying blocks of recorded handler calls
+  // rather than looking each instruction up. This is threaded dispatch on
+  // top of the decode cache, not native code generation, so it only saves
+  // the per-instruction lookup and loop checks. Results are identical to
+  // the interpreter.
+  void setBlockReplay(bool value) { blockReplay = value; }
+  bool isBlockReplay() const { return blockReplay; }
+
+  // Fast-forward a HALT, and spin loops that only wait for an event, to
+  // the next event. Off, every pass is run, as benchmarks want.
+  void setIdleSkipping(bool value) { idleSkipping = value; }
+  bool isIdleSkipping() const { return idleSkipping; }
+
+  // Stop at the start of each display line to latch it, so writes the
+  // beam has already passed only show next frame (multicolour, racing the
+  // beam). Off, the display is read when the frame is taken.
+  void setBeamRacing(bool value) { beamRacing = value; }
+  bool isBeamRacing() const { return beamRacing; }
 };
 
 #endif // ZXEMULATOR_PROCESSOR_H
@@ -16,40 +16,21 @@
 
 #include "ProcessorState.h"
 
-void ProcessorState::setInterrupts(bool value) {
-  this->interruptsEnabled = value;
-  this->registers.IFF1 = value ? 1 : 0;
-  this->registers.IFF2 = value ? 1 : 0;
+ProcessorState::ProcessorState() { attachPorts<Spectrum48K>(); }
+
+void ProcessorState::noteAudioLevel() {
+  std::int16_t level = Audio::levelFor(speakerBit, tape.getEarBit());
+  if (level != audioLevel) {
+    audioLevel = level;
+    audioEdges.push_back({(int)frameTStates, level});
+  }
 }
 
 /**
- * Get the next word at the current program counter
- * @return
+ * Forget the recorded edges and start again from silence
  */
-word ProcessorState::getNextWordFromPC() {
-  return this->memory.getWord(this->registers.PC);
-}
-
-/**
- * Get the next byte at the current program counter
- * @return
- */
-byte ProcessorState::getNextByteFromPC() {
-  return this->memory[this->registers.PC];
-}
-
-long ProcessorState::incPC(int value) {
-  this->registers.PC += value;
-  return this->registers.PC;
-}
-
-long ProcessorState::decPC(int value) {
-  this->registers.PC -= value;
-  return this->registers.PC;
-}
-
-long ProcessorState::incPC() { return incPC(1); }
-
-long ProcessorState::setPC(long address) {
-  return (this->registers.PC = address);
+void ProcessorState::resetAudio() {
+  audioEdges.clear();
+  audioLevel = 0;
+  speakerBit = false;
 }
@@ -17,36 +17,63 @@
 #ifndef ZXEMULATOR_PROCESSORSTATE_H
 #define ZXEMULATOR_PROCESSORSTATE_H
 
+#include "Audio.h"
 #include "Keyboard.h"
+#include "MachineModel.h"
 #include "Memory.h"
-#include "ProcessorTypes.h"
+#include "PortMap.h"
+#include "SpectrumPorts.h"
 #include "Tape.h"
+#include "Z80State.h"
+#include <vector>
 
-class ProcessorState {
+/**
+ * The Z80 wired into a Spectrum: the bus the emulator's core runs on. The
+ * ULA, Kempston joystick and, on a 128K or +2A, the paging registers and
+ * AY sit on its ports, and memory is paged as Memory maps it.
+ */
+class ProcessorState : public Z80State {
 private:
-  bool interruptsEnabled = false;
-  int interruptMode = 0; // Default IM 0 on reset
-  bool halted = false;
   bool speakerBit = false;
   bool micBit = false;
   long frameTStates = 0;
   bool fastLoad = false;
+  unsigned long portWrites = 0;
+
+  // Speaker and EAR level changes this frame, rendered at the frame end
+  std::int16_t audioLevel = 0;
+  std::vector<AudioEdge> audioEdges;
 
 public:
-  Z80Registers registers;
   Memory memory;
   Keyboard keyboard;
   Tape tape;
+  AyPort ay;
+  PortMap ports;
+
+  ProcessorState();
+  ProcessorState(const ProcessorState &) = delete;
+  ProcessorState &operator=(const ProcessorState &) = delete;
+
+  // Put the devices of a machine model on the ports
+  template <class Model> void attachPorts();
 
-  // Supporting routines
-  void setInterrupts(bool value);
-  bool areInterruptsEnabled() const { return interruptsEnabled; }
-  void setInterruptMode(int mode) { interruptMode = mode; }
-  int getInterruptMode() const { return interruptMode; }
-  void setHalted(bool value) { halted = value; }
-  bool isHalted() const { return halted; }
+  // Bus accesses, see Z80State
+  byte fetch(word address) const { return memory.fastRead(address); }
+  byte read(word address) const { return memory.fastRead(address); }
+  void write(word address, byte value) { memory.fastWrite(address, value); }
+  byte in(word port) { return ports.read(port); }
+  void out(word port, byte value) {
+    notePortWrite();
+    ports.write(port, value);
+  }
 
-  void setSpeakerBit(bool value) { speakerBit = value; }
+  void setSpeakerBit(bool value) {
+    if (value != speakerBit) {
+      speakerBit = value;
+      noteAudioLevel();
+    }
+  }
   bool getSpeakerBit() const { return speakerBit; }
   void setMicBit(bool value) { micBit = value; }
   bool getMicBit() const { return micBit; }
@@ -58,14 +85,37 @@ public:
   void setFastLoad(bool value) { fastLoad = value; }
   bool isFastLoad() const { return fastLoad; }
 
-  word getNextWordFromPC();
-  byte getNextByteFromPC();
+  // Record an edge at the current frame time if the level has changed
+  void noteAudioLevel();
+  std::vector<AudioEdge> &getAudioEdges() { return audioEdges; }
+  void resetAudio();
 
-  // Program counter util functions
-  long incPC();
-  long incPC(int value);
-  long decPC(int value);
-  long setPC(long address);
+  // Every OUT counts, so idle loops driving the beeper aren't skipped
+  void notePortWrite() { portWrites++; }
+  unsigned long getPortWrites() const { return portWrites; }
+
+private:
+  // Devices on the ports, see attachPorts()
+  UlaPort ula{*this};
+  KempstonPort kempston{keyboard};
+  PagingPort paging{memory};
+  PlusPagingPort plusPaging{memory};
 };
 
+template <class Model> void ProcessorState::attachPorts() {
+  ports.clear();
+  ports.attach(ula, UlaPort::MASK, UlaPort::MATCH);
+  ports.attach(kempston, KempstonPort::MASK, KempstonPort::MATCH, true,
+               false);
+  if constexpr (Model::PAGING) {
+    ports.attach(paging, Model::PAGING_MASK, Model::PAGING_MATCH, false,
+                 true);
+    ports.attach(ay, AyPort::READ_MASK, AyPort::READ_MATCH, true, false);
+    ports.attach(ay, AyPort::WRITE_MASK, AyPort::WRITE_MATCH, false, true);
+  }
+  if constexpr (Model::PLUS_PAGING)
+    ports.attach(plusPaging, Model::PLUS_PAGING_MASK,
+                 Model::PLUS_PAGING_MATCH, false, true);
+}
+
 #endif // ZXEMULATOR_PROCESSORSTATE_H
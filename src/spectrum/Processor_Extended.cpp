@@ -1,4 +1,6 @@
-#include "Processor.h"
+#include "OpcodeTables.h"
+#include "DebugBus.h"
+#include "FlatBus.h"
 #include "instructions/ArithmeticInstructions.h"
 #include "instructions/BitInstructions.h"
 #include "instructions/ControlInstructions.h"
@@ -6,376 +8,209 @@
 #include "instructions/LoadInstructions.h"
 #include "instructions/LogicInstructions.h"
 
+namespace Opcodes {
+namespace {
+
+// LD A, I / LD A, R
+// S, Z from the result, H=0, N=0, P/V=IFF2, C preserved
+inline void setIRFlags(Z80Registers &r) {
+  byte f = r.F & C_FLAG;
+  if (r.A == 0)
+    f |= Z_FLAG;
+  if (r.A & 0x80)
+    f |= S_FLAG;
+  if (r.IFF2)
+    f |= P_FLAG;
+  r.F = f;
+}
+
 // ============================================================================
-// Extended (ED) Opcode Handler
+// Extended (ED) opcodes
 // ============================================================================
-int Processor::exec_ed_opcode() {
-  byte extOpcode = state.getNextByteFromPC();
-  state.registers.PC++; // Increment past the extended opcode
-
-  int cycles = 0;
-
-  switch (extOpcode) {
-  // LDS
-  case 0x47:
-    state.registers.I = state.registers.A;
-    cycles = 9;
-    break;
-  case 0x57:
-    state.registers.A = state.registers.I;
-    cycles = 9;
-    {
-      byte f = state.registers.F & C_FLAG;
-      if (state.registers.A == 0)
-        f |= Z_FLAG;
-      if (state.registers.A & 0x80)
-        f |= S_FLAG;
-      if (state.registers.IFF2)
-        f |= P_FLAG;
-      state.registers.F = f;
-    }
-    break;
-
-  // LD A, R / LD R, A
-  case 0x4F:
-    state.registers.R = state.registers.A;
-    cycles = 9;
-    break;
-  case 0x5F:
-    // Preserves bit 7 of R? R is 7 bits refresh.
-    // Actually Z80 R register is 8 bits (top bit changes roughly).
-    // Emulator often keeps R as 8 bits.
-    state.registers.A = state.registers.R;
-    cycles = 9;
-    {
-      byte f = state.registers.F & C_FLAG;
-      if (state.registers.A == 0)
-        f |= Z_FLAG;
-      if (state.registers.A & 0x80)
-        f |= S_FLAG;
-      if (state.registers.IFF2)
-        f |= P_FLAG;
-      CLEAR_FLAG(N_FLAG, state.registers);
-      CLEAR_FLAG(H_FLAG, state.registers);
-      // Merge with existing flags (C preserved)
-      // wait, I constructed 'f' based on C_FLAG + new flags.
-      // existing code did: byte f = state.registers.F & C_FLAG; ...
-      // state.registers.F = f; This CLEARED other flags (like H/N). LD A, I
-      // documentation: S, Z, H=0, P/V=IFF2, N=0, C preserved. So code is
-      // correct.
-      state.registers.F = f;
+template <class Bus, byte Op> struct EdOp {
+  static constexpr int x = opX(Op);
+  static constexpr int y = opY(Op);
+  static constexpr int z = opZ(Op);
+  static constexpr int p = opP(Op);
+  static constexpr int q = opQ(Op);
+
+  static int handler(Bus &state) {
+    Z80Registers &r = state.registers;
+
+    if constexpr (x == 1) {
+      if constexpr (z == 0) { // IN r, (C)
+        if constexpr (y == 6) { // IN (C): flags only (undocumented)
+          byte discarded;
+          IO::in_r_c(state, discarded);
+        } else {
+          IO::in_r_c(state, reg8<y>(r));
+        }
+        return 12;
+      } else if constexpr (z == 1) { // OUT (C), r
+        if constexpr (y == 6) // OUT (C), 0 (undocumented)
+          IO::out_c_r(state, 0);
+        else
+          IO::out_c_r(state, reg8<y>(r));
+        return 12;
+      } else if constexpr (z == 2) {
+        if constexpr (q == 0) // SBC HL, rr
+          Arithmetic::sbc16(state, r.HL, rp<p>(r));
+        else // ADC HL, rr
+          Arithmetic::adc16(state, r.HL, rp<p>(r));
+        return 15;
+      } else if constexpr (z == 3) {
+        if constexpr (q == 0) // LD (nn), rr
+          Load::ld_nn_rr(state, operandWord(state), rp<p>(r));
+        else // LD rr, (nn)
+          Load::ld_rr_nn(state, rp<p>(r), operandWord(state));
+        r.PC += 2;
+        return 20;
+      } else if constexpr (Op == 0x44) { // NEG
+        Arithmetic::neg8(state);
+        return 8;
+      } else if constexpr (Op == 0x45) { // RETN
+        return Control::retn(state);
+      } else if constexpr (Op == 0x4D) { // RETI
+        return Control::reti(state);
+      } else if constexpr (Op == 0x46 || Op == 0x56 || Op == 0x5E) { // IM
+        state.setInterruptMode(Op == 0x46 ? 0 : (Op == 0x56 ? 1 : 2));
+        return 8;
+      } else if constexpr (Op == 0x47) { // LD I, A
+        r.I = r.A;
+        return 9;
+      } else if constexpr (Op == 0x4F) { // LD R, A
+        r.R = r.A;
+        return 9;
+      } else if constexpr (Op == 0x57) { // LD A, I
+        r.A = r.I;
+        setIRFlags(r);
+        return 9;
+      } else if constexpr (Op == 0x5F) { // LD A, R
+        r.A = r.R;
+        setIRFlags(r);
+        return 9;
+      } else if constexpr (Op == 0x67) { // RRD
+        Bit::rrd(state);
+        return 18;
+      } else if constexpr (Op == 0x6F) { // RLD
+        Bit::rld(state);
+        return 18;
+      } else {
+        return 8;
+      }
+    } else if constexpr (x == 2 && y >= 4 && z <= 3) {
+      // Block transfer, compare and I/O
+      if constexpr (Op == 0xA0)
+        return Load::ldi(state);
+      else if constexpr (Op == 0xA8)
+        return Load::ldd(state);
+      else if constexpr (Op == 0xB0)
+        return Load::ldir(state);
+      else if constexpr (Op == 0xB8)
+        return Load::lddr(state);
+      else if constexpr (Op == 0xA1)
+        return Control::cpi(state);
+      else if constexpr (Op == 0xA9)
+        return Control::cpd(state);
+      else if constexpr (Op == 0xB1)
+        return Control::cpir(state);
+      else if constexpr (Op == 0xB9)
+        return Control::cpdr(state);
+      else if constexpr (Op == 0xA2)
+        return IO::ini(state);
+      else if constexpr (Op == 0xAA)
+        return IO::ind(state);
+      else if constexpr (Op == 0xB2)
+        return IO::inir(state);
+      else if constexpr (Op == 0xBA)
+        return IO::indr(state);
+      else if constexpr (Op == 0xA3)
+        return IO::outi(state);
+      else if constexpr (Op == 0xAB)
+        return IO::outd(state);
+      else if constexpr (Op == 0xB3)
+        return IO::otir(state);
+      else
+        return IO::otdr(state);
+    } else {
+      // NOP (approx) for unknown ED to prevent infinite loops
+      return 8;
     }
-    break;
-
-  // RRD / RLD
-  case 0x67:
-    Bit::rrd(state);
-    cycles = 18;
-    break;
-  case 0x6F:
-    Bit::rld(state);
-    cycles = 18;
-    break;
-
-  // RETI
-  case 0x4D:
-    cycles = Control::reti(state);
-    break;
-
-  // RETN
-  case 0x45:
-    cycles = Control::retn(state);
-    break;
-  // IN r, (C)
-  case 0x40:
-    IO::in_r_c(state, state.registers.B);
-    cycles = 12;
-    break;
-  case 0x48:
-    IO::in_r_c(state, state.registers.C);
-    cycles = 12;
-    break;
-  case 0x50:
-    IO::in_r_c(state, state.registers.D);
-    cycles = 12;
-    break;
-  case 0x58:
-    IO::in_r_c(state, state.registers.E);
-    cycles = 12;
-    break;
-  case 0x60:
-    IO::in_r_c(state, state.registers.H);
-    cycles = 12;
-    break;
-  case 0x68:
-    IO::in_r_c(state, state.registers.L);
-    cycles = 12;
-    break;
-  case 0x78:
-    IO::in_r_c(state, state.registers.A);
-    cycles = 12;
-    break;
-
-  // SBC HL, rr
-  case 0x42:
-    Arithmetic::sbc16(state, state.registers.HL, state.registers.BC);
-    cycles = 15;
-    break;
-  case 0x52:
-    Arithmetic::sbc16(state, state.registers.HL, state.registers.DE);
-    cycles = 15;
-    break;
-  case 0x62:
-    Arithmetic::sbc16(state, state.registers.HL, state.registers.HL);
-    cycles = 15;
-    break;
-  case 0x72:
-    Arithmetic::sbc16(state, state.registers.HL, state.registers.SP);
-    cycles = 15;
-    break;
-
-  // ADC HL, rr
-  case 0x4A:
-    Arithmetic::adc16(state, state.registers.HL, state.registers.BC);
-    cycles = 15;
-    break;
-  case 0x5A:
-    Arithmetic::adc16(state, state.registers.HL, state.registers.DE);
-    cycles = 15;
-    break;
-  case 0x6A:
-    Arithmetic::adc16(state, state.registers.HL, state.registers.HL);
-    cycles = 15;
-    break;
-  case 0x7A:
-    Arithmetic::adc16(state, state.registers.HL, state.registers.SP);
-    cycles = 15;
-    break;
-
-  // LD (nn), rr - Consumes 2 byte operand (nn)
-  case 0x43:
-    Load::ld_nn_rr(state, state.getNextWordFromPC(), state.registers.BC);
-    state.registers.PC += 2;
-    cycles = 20;
-    break;
-  case 0x53:
-    Load::ld_nn_rr(state, state.getNextWordFromPC(), state.registers.DE);
-    state.registers.PC += 2;
-    cycles = 20;
-    break;
-  case 0x63:
-    Load::ld_nn_rr(state, state.getNextWordFromPC(), state.registers.HL);
-    state.registers.PC += 2;
-    cycles = 20;
-    break;
-  case 0x73:
-    Load::ld_nn_rr(state, state.getNextWordFromPC(), state.registers.SP);
-    state.registers.PC += 2;
-    cycles = 20;
-    break;
-
-  // LD rr, (nn) - Consumes 2 byte operand (nn)
-  case 0x4B:
-    Load::ld_rr_nn(state, state.registers.BC, state.getNextWordFromPC());
-    state.registers.PC += 2;
-    cycles = 20;
-    break;
-  case 0x5B:
-    Load::ld_rr_nn(state, state.registers.DE, state.getNextWordFromPC());
-    state.registers.PC += 2;
-    cycles = 20;
-    break;
-  case 0x6B:
-    Load::ld_rr_nn(state, state.registers.HL, state.getNextWordFromPC());
-    state.registers.PC += 2;
-    cycles = 20;
-    break;
-  case 0x7B:
-    Load::ld_rr_nn(state, state.registers.SP, state.getNextWordFromPC());
-    state.registers.PC += 2;
-    cycles = 20;
-    break;
-
-  case 0x44: // NEG
-    Arithmetic::neg8(state);
-    cycles = 8;
-    break;
-
-  // IM
-  case 0x46:
-    state.setInterruptMode(0);
-    cycles = 8;
-    break;
-  case 0x56:
-    state.setInterruptMode(1);
-    cycles = 8;
-    break;
-  case 0x5E:
-    state.setInterruptMode(2);
-    cycles = 8;
-    break;
-
-  // Block Ops
-  case 0xA0:
-    cycles = Load::ldi(state);
-    break;
-  case 0xA8:
-    cycles = Load::ldd(state);
-    break;
-  case 0xB0:
-    cycles = Load::ldir(state);
-    break;
-  case 0xB8:
-    cycles = Load::lddr(state);
-    break;
-  case 0xA1:
-    cycles = Control::cpi(state);
-    break;
-  case 0xA9:
-    cycles = Control::cpd(state);
-    break;
-  case 0xB1:
-    cycles = Control::cpir(state);
-    break;
-  case 0xB9:
-    cycles = Control::cpdr(state);
-    break;
-
-  // Block I/O
-  case 0xA2:
-    cycles = cycles = IO::ini(state);
-    break;
-  case 0xB2:
-    cycles = cycles = IO::inir(state);
-    break;
-  case 0xAA:
-    cycles = cycles = IO::ind(state);
-    break;
-  case 0xBA:
-    cycles = cycles = IO::indr(state);
-    break;
-  case 0xA3:
-    cycles = cycles = IO::outi(state);
-    break;
-  case 0xB3:
-    cycles = cycles = IO::otir(state);
-    break;
-  case 0xAB:
-    cycles = cycles = IO::outd(state);
-    break;
-  case 0xBB:
-    cycles = cycles = IO::otdr(state);
-    break;
-
-  default:
-    cycles = 8; // NOP (approx) for unknown ED to prevent infinite loops
-    break;
   }
-  return cycles;
-}
+};
 
 // ============================================================================
-// Bit (CB) Opcode Handler
+// Bit (CB) opcodes
 // ============================================================================
-int Processor::exec_cb_opcode() {
-  byte cbOpcode = state.getNextByteFromPC();
-  state.registers.PC++;
-
-  int x = (cbOpcode >> 6) & 3;
-  int y = (cbOpcode >> 3) & 7;
-  int z = cbOpcode & 7;
-
-  byte *regPtr = nullptr;
-  byte memVal = 0;
-  bool isMem = false;
-  word hlAddr = state.registers.HL;
-
-  // Decode register
-  switch (z) {
-  case 0:
-    regPtr = &state.registers.B;
-    break;
-  case 1:
-    regPtr = &state.registers.C;
-    break;
-  case 2:
-    regPtr = &state.registers.D;
-    break;
-  case 3:
-    regPtr = &state.registers.E;
-    break;
-  case 4:
-    regPtr = &state.registers.H;
-    break;
-  case 5:
-    regPtr = &state.registers.L;
-    break;
-  case 6: // (HL)
-    isMem = true;
-    memVal = state.memory[hlAddr];
-    regPtr = &memVal;
-    break;
-  case 7:
-    regPtr = &state.registers.A;
-    break;
-  }
-
-  int cycles = 8;
-  if (isMem)
-    cycles = (x == 1) ? 12 : 15; // BIT (HL)=12, others=15
-  else
-    cycles = 8;
-
-  if (x == 0) { // Rotate/Shift
-    switch (y) {
-    case 0:
-      Bit::rlc(state, *regPtr);
-      break;
-    case 1:
-      Bit::rrc(state, *regPtr);
-      break;
-    case 2:
-      Bit::rl(state, *regPtr);
-      break;
-    case 3:
-      Bit::rr(state, *regPtr);
-      break;
-    case 4:
-      Bit::sla(state, *regPtr);
-      break;
-    case 5:
-      Bit::sra(state, *regPtr);
-      break;
-    case 6:
-      Bit::sll(state, *regPtr);
-      break; // SLL (undocumented)
-    case 7:
-      Bit::srl(state, *regPtr);
-      break;
-    }
-  } else if (x == 1) { // BIT
-    if (isMem) {
-      // Z80 Undocumented: BIT n, (HL) sets X/Y from internal register (MEMPTR
-      // high byte), which is H (High byte of HL) Here, MEMPTR = HL. So pass
-      // (hlAddr >> 8) as the source for X/Y flags, but 'val' for Z flag test.
-      // We need to modify Bit::bit signature or handle it here.
-      // Let's modify Bit::bit to take an optional 'undocSource'
-      // OR: handle flags manually here.
-      Bit::bitMem(state, y, *regPtr, (hlAddr >> 8));
-      return cycles;
+template <class Bus, byte Op> struct CbOp {
+  static constexpr int x = opX(Op);
+  static constexpr int y = opY(Op);
+  static constexpr int z = opZ(Op);
+
+  static int handler(Bus &state) {
+    Z80Registers &r = state.registers;
+
+    if constexpr (z == 6) {
+      word hlAddr = r.HL;
+      byte value = state.read(hlAddr);
+      if constexpr (x == 1) {
+        // BIT n, (HL) takes the undocumented X/Y flags from MEMPTR high
+        // byte, which is H here
+        Bit::bitMem(state, y, value, (hlAddr >> 8));
+        return 12;
+      } else {
+        apply(state, value);
+        state.write(hlAddr, value);
+        return 15;
+      }
     } else {
-      Bit::bit(state, y, *regPtr);
+      if constexpr (x == 1)
+        Bit::bit(state, y, reg8<z>(r));
+      else
+        apply(state, reg8<z>(r));
+      return 8;
     }
-  } else if (x == 2) { // RES
-    Bit::res(state, y, *regPtr);
-  } else if (x == 3) { // SET
-    Bit::set(state, y, *regPtr);
   }
 
-  // Write back if memory and NOT BIT (BIT doesn't modify)
-  if (isMem && x != 1) {
-    writeMem(hlAddr, *regPtr);
+  // Rotate/shift, RES or SET (x != 1)
+  static void apply(Bus &state, byte &value) {
+    if constexpr (x == 0)
+      rotate<y>(state, value);
+    else if constexpr (x == 2)
+      Bit::res(state, y, value);
+    else
+      Bit::set(state, y, value);
   }
-
-  return cycles;
-}
+};
+
+template <class Bus> struct CbOps {
+  template <byte Op> using Opcode = CbOp<Bus, Op>;
+};
+
+template <class Bus> struct EdOps {
+  template <byte Op> using Opcode = EdOp<Bus, Op>;
+};
+
+} // namespace
+
+template <class Bus>
+const std::array<Handler<Bus>, 256> Tables<Bus>::cb =
+    buildTable<Handler<Bus>, CbOps<Bus>::template Opcode>(
+        std::make_index_sequence<256>{});
+
+template <class Bus>
+const std::array<Handler<Bus>, 256> Tables<Bus>::ed =
+    buildTable<Handler<Bus>, EdOps<Bus>::template Opcode>(
+        std::make_index_sequence<256>{});
+
+// Handlers for each bus
+template const std::array<Handler<ProcessorState>, 256>
+    Tables<ProcessorState>::cb;
+template const std::array<Handler<ProcessorState>, 256>
+    Tables<ProcessorState>::ed;
+template const std::array<Handler<FlatBus>, 256> Tables<FlatBus>::cb;
+template const std::array<Handler<FlatBus>, 256> Tables<FlatBus>::ed;
+template const std::array<Handler<DebugBus>, 256> Tables<DebugBus>::cb;
+template const std::array<Handler<DebugBus>, 256> Tables<DebugBus>::ed;
+
+} // namespace Opcodes
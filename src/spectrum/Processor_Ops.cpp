@@ -1,160 +1,295 @@
-#include "Processor.h"
+#include "OpcodeTables.h"
+#include "DebugBus.h"
+#include "FlatBus.h"
 #include "instructions/ArithmeticInstructions.h"
+#include "instructions/BitInstructions.h"
+#include "instructions/ControlInstructions.h"
+#include "instructions/IOInstructions.h"
+#include "instructions/LoadInstructions.h"
 #include "instructions/LogicInstructions.h"
 
-int Processor::exec_loads_8bit(byte opcode) {
-  // 0x40 - 0x7F: LD r, r'
-  // Binary: 01 ddd sss
-  // 000=B, 001=C, 010=D, 011=E, 100=H, 101=L, 110=(HL), 111=A
-  // EXCEPTION: 0x76 (01 110 110) is HALT. Caller should handle HALT before
-  // calling this, OR we handle it here.
-  // We will assume caller handles HALT (0x76) because it's distinct.
-
-  if (opcode == 0x76) {
-    return 0; // Should not happen if caller filters, or treat as NOP here?
-              // The main loop handles HALT state specifically.
-  }
-
-  int destIndex = (opcode >> 3) & 7;
-  int srcIndex = opcode & 7;
-
-  byte value = 0;
-  int cycles = 4;
-
-  // READ SOURCE
-  switch (srcIndex) {
-  case 0:
-    value = state.registers.B;
-    break;
-  case 1:
-    value = state.registers.C;
-    break;
-  case 2:
-    value = state.registers.D;
-    break;
-  case 3:
-    value = state.registers.E;
-    break;
-  case 4:
-    value = state.registers.H;
-    break;
-  case 5:
-    value = state.registers.L;
-    break;
-  case 6: // (HL)
-    value = state.memory[state.registers.HL];
-    cycles = 7;
-    break;
-  case 7:
-    value = state.registers.A;
-    break;
-  }
-
-  // WRITE DEST
-  if (destIndex == 6) { // LD (HL), r
-    state.memory.fastWrite(state.registers.HL, value);
-    cycles = 7; // LD (HL), r is 7 cycles
-  } else {
-    // LD r, (HL) is 7 cycles, LD r, r is 4.
-    // usage of 'cycles' variable handles the src=(HL) case => 7.
-    // If dest=(HL), we set cycles=7 above.
-    // If BOTH are (HL)? 0x76 HALT. Handled.
-
-    switch (destIndex) {
-    case 0:
-      state.registers.B = value;
-      break;
-    case 1:
-      state.registers.C = value;
-      break;
-    case 2:
-      state.registers.D = value;
-      break;
-    case 3:
-      state.registers.E = value;
-      break;
-    case 4:
-      state.registers.H = value;
-      break;
-    case 5:
-      state.registers.L = value;
-      break;
-    case 7:
-      state.registers.A = value;
-      break;
+namespace Opcodes {
+namespace {
+
+// ============================================================================
+// Unprefixed opcodes
+// ============================================================================
+template <class Bus, bool Lazy> struct MainOps {
+  template <byte Op> struct Opcode {
+    static constexpr int x = opX(Op);
+    static constexpr int y = opY(Op);
+    static constexpr int z = opZ(Op);
+    static constexpr int p = opP(Op);
+    static constexpr int q = opQ(Op);
+
+    // Opcodes that read or partially update F, so need it built first in the
+    // lazy core. ALU ops, INC/DEC r and conditionals handle deferred flags
+    // themselves.
+    static constexpr bool readsFlags =
+        (x == 0 && z == 0 && y == 1) ||           // EX AF, AF'
+        (x == 0 && z == 1 && q == 1) ||           // ADD HL, rr
+        (x == 0 && z == 7) ||                     // Rotates, DAA, CPL, SCF, CCF
+        (x == 3 && z == 3 && y == 1) ||           // CB prefix
+        (x == 3 && z == 5 && q == 0 && p == 3) || // PUSH AF
+        (x == 3 && z == 5 && q == 1 && p != 0);   // DD, ED and FD prefixes
+
+    template <int Cc> static bool test(Bus &state) {
+      if constexpr (Lazy)
+        return lazyCondition<Cc>(state);
+      else
+        return condition<Cc>(state.registers);
+    }
+
+    static void aluOp(Bus &state, byte value) {
+      if constexpr (Lazy)
+        lazyAlu<y>(state, value);
+      else
+        alu<y>(state, value);
+    }
+
+    static void incDecOp(Bus &state, byte &value) {
+      if constexpr (Lazy)
+        lazyIncDec<z == 4>(state, value);
+      else if constexpr (z == 4)
+        Arithmetic::inc8(state, value);
+      else
+        Arithmetic::dec8(state, value);
+    }
+
+    static int handler(Bus &state) {
+      Z80Registers &r = state.registers;
+
+      if constexpr (Lazy && readsFlags)
+        state.lazyFlags.materialise(r);
+
+      if constexpr (x == 1) {
+        // 0x40 - 0x7F: LD r, r' (0x76 is HALT)
+        if constexpr (Op == 0x76) {
+          state.setHalted(true);
+          return 4;
+        } else if constexpr (z == 6) { // LD r, (HL)
+          reg8<y>(r) = state.read(r.HL);
+          return 7;
+        } else if constexpr (y == 6) { // LD (HL), r
+          state.write(r.HL, reg8<z>(r));
+          return 7;
+        } else {
+          reg8<y>(r) = reg8<z>(r);
+          return 4;
+        }
+      } else if constexpr (x == 2) {
+        // 0x80 - 0xBF: ALU A, r
+        if constexpr (z == 6) {
+          aluOp(state, state.read(r.HL));
+          return 7;
+        } else {
+          aluOp(state, reg8<z>(r));
+          return 4;
+        }
+      } else if constexpr (x == 0) {
+        return blockZero(state, r);
+      } else {
+        return blockThree(state, r);
+      }
+    }
+
+    // 0x00 - 0x3F
+    static int blockZero(Bus &state, Z80Registers &r) {
+      if constexpr (z == 0) {
+        if constexpr (y == 0) { // NOP
+          return 4;
+        } else if constexpr (y == 1) { // EX AF, AF'
+          Load::ex_af_af(state);
+          return 4;
+        } else if constexpr (y == 2) { // DJNZ e
+          return Control::djnz(state, (int8_t)operandByte(state));
+        } else if constexpr (y == 3) { // JR e
+          return Control::jr(state, (int8_t)operandByte(state));
+        } else { // JR cc, e
+          return Control::jr_cond(state, test<y - 4>(state),
+                                  (int8_t)operandByte(state));
+        }
+      } else if constexpr (z == 1) {
+        if constexpr (q == 0) { // LD rr, nn
+          rp<p>(r) = fetchWord(state);
+          return 10;
+        } else { // ADD HL, rr
+          Arithmetic::add16(state, r.HL, rp<p>(r));
+          return 11;
+        }
+      } else if constexpr (z == 2) {
+        if constexpr (Op == 0x02) { // LD (BC), A
+          state.write(r.BC, r.A);
+          return 7;
+        } else if constexpr (Op == 0x0A) { // LD A, (BC)
+          r.A = state.read(r.BC);
+          return 7;
+        } else if constexpr (Op == 0x12) { // LD (DE), A
+          state.write(r.DE, r.A);
+          return 7;
+        } else if constexpr (Op == 0x1A) { // LD A, (DE)
+          r.A = state.read(r.DE);
+          return 7;
+        } else if constexpr (Op == 0x22) { // LD (nn), HL
+          word addr = fetchWord(state);
+          state.write(addr, r.L);
+          state.write((word)(addr + 1), r.H);
+          return 16;
+        } else if constexpr (Op == 0x2A) { // LD HL, (nn)
+          word addr = fetchWord(state);
+          r.L = state.read(addr);
+          r.H = state.read((word)(addr + 1));
+          return 16;
+        } else if constexpr (Op == 0x32) { // LD (nn), A
+          state.write(fetchWord(state), r.A);
+          return 13;
+        } else { // LD A, (nn)
+          r.A = state.read(fetchWord(state));
+          return 13;
+        }
+      } else if constexpr (z == 3) {
+        if constexpr (q == 0)
+          return Arithmetic::inc16(state, rp<p>(r));
+        else
+          return Arithmetic::dec16(state, rp<p>(r));
+      } else if constexpr (z == 4 || z == 5) {
+        // INC r / DEC r
+        if constexpr (y == 6) {
+          byte val = state.read(r.HL);
+          incDecOp(state, val);
+          state.write(r.HL, val);
+          return 11;
+        } else {
+          incDecOp(state, reg8<y>(r));
+          return 4;
+        }
+      } else if constexpr (z == 6) {
+        // LD r, n
+        if constexpr (y == 6) {
+          state.write(r.HL, fetchByte(state));
+          return 10;
+        } else {
+          reg8<y>(r) = fetchByte(state);
+          return 7;
+        }
+      } else {
+        // Accumulator and flag operations
+        if constexpr (y == 0)
+          Bit::rlca(state);
+        else if constexpr (y == 1)
+          Bit::rrca(state);
+        else if constexpr (y == 2)
+          Bit::rla(state);
+        else if constexpr (y == 3)
+          Bit::rra(state);
+        else if constexpr (y == 4)
+          Arithmetic::daa(state);
+        else if constexpr (y == 5)
+          Logic::cpl(state);
+        else if constexpr (y == 6)
+          Logic::scf(state);
+        else
+          Logic::ccf(state);
+        return 4;
+      }
+    }
+
+    // 0xC0 - 0xFF
+    static int blockThree(Bus &state, Z80Registers &r) {
+      if constexpr (z == 0) { // RET cc
+        return Control::ret_cond(state, test<y>(state));
+      } else if constexpr (z == 1) {
+        if constexpr (q == 0) { // POP rr
+          word value = Load::pop16(state);
+          if constexpr (p == 3) {
+            r.AF = value;
+            if constexpr (Lazy)
+              state.lazyFlags.discard();
+          } else
+            rp<p>(r) = value;
+          return 10;
+        } else if constexpr (p == 0) { // RET
+          return Control::ret(state);
+        } else if constexpr (p == 1) { // EXX
+          Load::exx(state);
+          return 4;
+        } else if constexpr (p == 2) { // JP (HL)
+          return Control::jp_hl(state);
+        } else { // LD SP, HL
+          Load::ld_sp_hl(state);
+          return 6;
+        }
+      } else if constexpr (z == 2) { // JP cc, nn
+        return Control::jp_cond(state, test<y>(state),
+                                operandWord(state));
+      } else if constexpr (z == 3) {
+        if constexpr (y == 0) { // JP nn
+          return Control::jp(state, operandWord(state));
+        } else if constexpr (y == 1) { // CB prefix
+          return Tables<Bus>::cb[fetchByte(state)](state);
+        } else if constexpr (y == 2) { // OUT (n), A
+          return IO::out_n_a(state, fetchByte(state));
+        } else if constexpr (y == 3) { // IN A, (n)
+          return IO::in_a_n(state, fetchByte(state));
+        } else if constexpr (y == 4) { // EX (SP), HL
+          Load::ex_sp_hl(state);
+          return 19;
+        } else if constexpr (y == 5) { // EX DE, HL
+          Load::ex_de_hl(state);
+          return 4;
+        } else if constexpr (y == 6) { // DI
+          return Control::di(state);
+        } else { // EI
+          return Control::ei(state);
+        }
+      } else if constexpr (z == 4) { // CALL cc, nn
+        return Control::call_cond(state, test<y>(state),
+                                  operandWord(state));
+      } else if constexpr (z == 5) {
+        if constexpr (q == 0) { // PUSH rr
+          if constexpr (p == 3)
+            Load::push16(state, r.AF);
+          else
+            Load::push16(state, rp<p>(r));
+          return 11;
+        } else if constexpr (p == 0) { // CALL nn
+          return Control::call(state, operandWord(state));
+        } else if constexpr (p == 1) { // DD prefix (IX)
+          return Tables<Bus>::dd[fetchByte(state)](state);
+        } else if constexpr (p == 2) { // ED prefix
+          return Tables<Bus>::ed[fetchByte(state)](state);
+        } else { // FD prefix (IY)
+          return Tables<Bus>::fd[fetchByte(state)](state);
+        }
+      } else if constexpr (z == 6) { // ALU A, n
+        aluOp(state, fetchByte(state));
+        return 7;
+      } else { // RST
+        return Control::rst(state, y * 8);
+      }
     }
-  }
-
-  return cycles;
-}
-
-int Processor::exec_alu_8bit(byte opcode) {
-  // 0x80 - 0xBF: ALU A, r
-  // Binary: 10 ooo sss
-  // Ops: 0=ADD, 1=ADC, 2=SUB, 3=SBC, 4=AND, 5=XOR, 6=OR, 7=CP
-
-  int opIndex = (opcode >> 3) & 7;
-  int srcIndex = opcode & 7;
-
-  byte value = 0;
-  int cycles = 4;
-
-  // READ SOURCE
-  switch (srcIndex) {
-  case 0:
-    value = state.registers.B;
-    break;
-  case 1:
-    value = state.registers.C;
-    break;
-  case 2:
-    value = state.registers.D;
-    break;
-  case 3:
-    value = state.registers.E;
-    break;
-  case 4:
-    value = state.registers.H;
-    break;
-  case 5:
-    value = state.registers.L;
-    break;
-  case 6: // (HL)
-    value = state.memory[state.registers.HL];
-    cycles = 7;
-    break;
-  case 7:
-    value = state.registers.A;
-    break;
-  }
-
-  // EXECUTE OP
-  switch (opIndex) {
-  case 0:
-    Arithmetic::add8(state, value);
-    break;
-  case 1:
-    Arithmetic::adc8(state, value);
-    break;
-  case 2:
-    Arithmetic::sub8(state, value);
-    break;
-  case 3:
-    Arithmetic::sbc8(state, value);
-    break;
-  case 4:
-    Logic::and8(state, value);
-    break;
-  case 5:
-    Logic::xor8(state, value);
-    break;
-  case 6:
-    Logic::or8(state, value);
-    break;
-  case 7:
-    Arithmetic::cp8(state, value);
-    break;
-  }
-
-  return cycles;
-}
+  };
+};
+
+} // namespace
+
+template <class Bus>
+const std::array<Handler<Bus>, 256> Tables<Bus>::main =
+    buildTable<Handler<Bus>, MainOps<Bus, false>::template Opcode>(
+        std::make_index_sequence<256>{});
+
+template <class Bus>
+const std::array<Handler<Bus>, 256> Tables<Bus>::lazyMain =
+    buildTable<Handler<Bus>, MainOps<Bus, true>::template Opcode>(
+        std::make_index_sequence<256>{});
+
+// Handlers for each bus
+template const std::array<Handler<ProcessorState>, 256>
+    Tables<ProcessorState>::main;
+template const std::array<Handler<ProcessorState>, 256>
+    Tables<ProcessorState>::lazyMain;
+template const std::array<Handler<FlatBus>, 256> Tables<FlatBus>::main;
+template const std::array<Handler<FlatBus>, 256> Tables<FlatBus>::lazyMain;
+template const std::array<Handler<DebugBus>, 256> Tables<DebugBus>::main;
+
+} // namespace Opcodes
@@ -31,12 +31,21 @@ void SnapshotLoader::load(const char *filename, ProcessorState &state) {
   for (auto &c : ext)
     c = tolower(c);
 
+  // Run as a 48K machine unless the snapshot pages itself: 48K BASIC is
+  // ROM 1 of a 128K set and ROM 3 of a +2A's
+  state.memory.setPagingRegister(PAGING_ROM | PAGING_LOCKED);
+  state.memory.setPlusPagingRegister(PLUS_PAGING_ROM);
+
   if (ext == "z80") {
     loadZ80(filename, state);
   } else {
     // Default to SNA
     loadSNA(filename, state);
   }
+
+  // Memory was replaced behind the decode cache and the screen
+  state.memory.getDecodeCache().clear();
+  state.memory.markScreenDirty();
 }
 
 void SnapshotLoader::loadSNA(const char *filename, ProcessorState &state) {
@@ -79,6 +88,7 @@ void SnapshotLoader::loadSNA(const char *filename, ProcessorState &state) {
   state.setInterrupts(iff2 != 0);
 
   state.registers.R = loader[20];
+  state.lazyFlags.discard();
   state.registers.F = loader[21];
   state.registers.A = loader[22];
 
@@ -92,13 +102,13 @@ void SnapshotLoader::loadSNA(const char *filename, ProcessorState &state) {
 
   // 2. Memory (starts at 16384)
   for (int i = 0; i < SNAPSHOT_RAM_SIZE; ++i) {
-    state.memory[16384 + i] = loader[SNA_HEADER_SIZE + i];
+    state.memory.fastWrite(16384 + i, loader[SNA_HEADER_SIZE + i]);
   }
 
   // 3. PC Retrieval (stored on stack)
   // Need to read word at SP, then increment SP
-  byte low = state.memory[state.registers.SP];
-  byte high = state.memory[state.registers.SP + 1];
+  byte low = state.memory.fastRead(state.registers.SP);
+  byte high = state.memory.fastRead(state.registers.SP + 1);
   state.registers.PC = (high << 8) | low;
   state.registers.SP += 2;
 
@@ -120,6 +130,7 @@ void SnapshotLoader::loadZ80(const char *filename, ProcessorState &state) {
 
   // Decode Header (bytes 0-29)
   state.registers.A = loader[0];
+  state.lazyFlags.discard();
   state.registers.F = loader[1];
   state.registers.C = loader[2];
   state.registers.B = loader[3];
@@ -129,6 +140,8 @@ void SnapshotLoader::loadZ80(const char *filename, ProcessorState &state) {
   // PC is bytes 6&7. If 0, it means V2/V3
   word pc = (loader[7] << 8) | loader[6];
   bool isVersion2 = (pc == 0);
+  bool is128K = false;
+  bool isPlus = false;
 
   state.registers.SP = (loader[9] << 8) | loader[8];
   state.registers.I = loader[10];
@@ -178,11 +191,22 @@ void SnapshotLoader::loadZ80(const char *filename, ProcessorState &state) {
     // PC is at offset 32.
     pc = (loader[33] << 8) | loader[32];
 
-    // Check for hardware mode (we only support 48k for now)
-    // Byte 34 is Hardware Mode.
-    // ... simplistic handling for now ...
-    utils::Logger::write(
-        "Warning: Z80 V2/V3 file detected. Basic support only.");
+    // Byte 34 is Hardware Mode. 128K is 3 or 4 in a version 2 header and
+    // 4 to 6 in version 3, where 12 is the +2. Byte 35 is then the last
+    // write to port 0x7FFD. The +3 (7 or 8) and +2A (13) have the last
+    // write to 0x1FFD at byte 86 of a version 3 header.
+    byte hardware = loader[34];
+    isPlus = extraHeaderLen != 23 &&
+             (hardware == 7 || hardware == 8 || hardware == 13);
+    is128K = extraHeaderLen == 23 ? hardware == 3 || hardware == 4
+                                  : (hardware >= 4 && hardware <= 6) ||
+                                        hardware == 12 || isPlus;
+    if (is128K && !state.memory.isPageable())
+      utils::Logger::write(
+          "Warning: 128K snapshot needs a 128K ROM to run correctly.");
+    else if (isPlus && state.memory.getRomCount() < 4)
+      utils::Logger::write(
+          "Warning: +2A snapshot needs a +2A ROM to run correctly.");
   }
 
   state.registers.PC = pc;
@@ -207,20 +231,26 @@ void SnapshotLoader::loadZ80(const char *filename, ProcessorState &state) {
       if (blockLen == 0)
         break; // End marker? usually just EOF.
 
-      int targetAddress = -1;
-      // 48K Page Mapping
-      switch (pageId) {
-      case 8:
-        targetAddress = 16384;
-        break; // 0x4000
-      case 4:
-        targetAddress = 32768;
-        break; // 0x8000
-      case 5:
-        targetAddress = 49152;
-        break; // 0xC000
-      default:
-        // Ignore other pages (128K banks) for 48K emulator
+      // 128K pages 3 to 10 are banks 0 to 7. A 48K snapshot only has the
+      // banks it maps at 0x4000, 0x8000 and 0xC000.
+      int bank = -1;
+      if (is128K) {
+        if (pageId >= 3 && pageId <= 10)
+          bank = pageId - 3;
+      } else {
+        switch (pageId) {
+        case 8:
+          bank = 5;
+          break; // 0x4000
+        case 4:
+          bank = 2;
+          break; // 0x8000
+        case 5:
+          bank = 0;
+          break; // 0xC000
+        }
+      }
+      if (bank < 0) {
         utils::Logger::write(
             ("Skipping Page " + std::to_string(pageId)).c_str());
         // Skip this block
@@ -232,20 +262,19 @@ void SnapshotLoader::loadZ80(const char *filename, ProcessorState &state) {
       long dataEnd = fileIndex + (isCompressed ? blockLen : 16384);
 
       // Decompress/Copy block
-      int currentRam = targetAddress;
-      while (fileIndex < dataEnd && currentRam < targetAddress + 16384) {
+      byte *target = state.memory.getBank(bank);
+      int offset = 0;
+      while (fileIndex < dataEnd && offset < BANK_SIZE) {
         byte b = loader[fileIndex];
         if (isCompressed && b == 0xED && fileIndex + 3 < dataEnd &&
             loader[fileIndex + 1] == 0xED) {
           byte count = loader[fileIndex + 2];
           byte val = loader[fileIndex + 3];
           fileIndex += 4;
-          for (int k = 0; k < count; k++) {
-            if (currentRam < 65536)
-              state.memory[currentRam++] = val;
-          }
+          for (int k = 0; k < count && offset < BANK_SIZE; k++)
+            target[offset++] = val;
         } else {
-          state.memory[currentRam++] = b;
+          target[offset++] = b;
           fileIndex++;
         }
       }
@@ -253,6 +282,17 @@ void SnapshotLoader::loadZ80(const char *filename, ProcessorState &state) {
       // logic correct)
       fileIndex = dataEnd;
     }
+    if (is128K) {
+      state.memory.setPagingRegister(loader[35]);
+      state.memory.setPlusPagingRegister(isPlus && dataStart > 86 ? loader[86]
+                                                                   : 0);
+      // Bytes 39 to 54 are the AY registers and 38 the one last selected
+      for (int i = 0; i < AyPort::REGISTERS; i++) {
+        state.ay.write(0xFFFD, i);
+        state.ay.write(0xBFFD, loader[39 + i]);
+      }
+      state.ay.write(0xFFFD, loader[38]);
+    }
   } else {
     // V1: Linear loading
     utils::Logger::write("Z80 V1 Detected.");
@@ -276,11 +316,11 @@ void SnapshotLoader::loadZ80(const char *filename, ProcessorState &state) {
 
           for (int k = 0; k < count; k++) {
             if (ramAddress < 65536) {
-              state.memory[ramAddress++] = val;
+              state.memory.fastWrite(ramAddress++, val);
             }
           }
         } else {
-          state.memory[ramAddress++] = b;
+          state.memory.fastWrite(ramAddress++, b);
           fileIndex++;
         }
 
@@ -290,7 +330,7 @@ void SnapshotLoader::loadZ80(const char *filename, ProcessorState &state) {
     } else {
       // Uncompressed 48K dump
       for (int i = 0; i < 49152 && (fileIndex + i) < fileSize; i++) {
-        state.memory[ramAddress + i] = loader[fileIndex + i];
+        state.memory.fastWrite(ramAddress + i, loader[fileIndex + i]);
       }
     }
   }
@@ -299,6 +339,9 @@ void SnapshotLoader::loadZ80(const char *filename, ProcessorState &state) {
 }
 
 void SnapshotLoader::exportSNA(const char *filename, ProcessorState &state) {
+  // Make sure F is current if the lazy flag core is in use
+  state.lazyFlags.materialise(state.registers);
+
   std::ofstream outFile(filename, std::ios::binary);
   if (!outFile) {
     utils::Logger::write("Error: Could not open file for writing.");
@@ -318,11 +361,11 @@ void SnapshotLoader::exportSNA(const char *filename, ProcessorState &state) {
 
   // Back up existing memory at stack location (to restore later if needed,
   // though we probably don't need to)
-  byte oldLow = state.memory[sp];
-  byte oldHigh = state.memory[sp + 1];
+  byte oldLow = state.memory.fastRead(sp);
+  byte oldHigh = state.memory.fastRead(sp + 1);
 
-  state.memory[sp] = pc & 0xFF;
-  state.memory[sp + 1] = (pc >> 8) & 0xFF;
+  state.memory.fastWrite(sp, pc & 0xFF);
+  state.memory.fastWrite(sp + 1, (pc >> 8) & 0xFF);
 
   // 2. Create Header
   byte header[27];
@@ -370,7 +413,7 @@ void SnapshotLoader::exportSNA(const char *filename, ProcessorState &state) {
 
   // Write RAM (16384 to 65535)
   for (int i = 16384; i < 65536; ++i) {
-    char byteVal = (char)state.memory[i];
+    char byteVal = (char)state.memory.fastRead(i);
     outFile.write(&byteVal, 1);
   }
 
@@ -378,8 +421,8 @@ void SnapshotLoader::exportSNA(const char *filename, ProcessorState &state) {
 
   // Restore memory (just in case the stack pointed to something critical
   // execution relies on, though typically it points to free stack space)
-  state.memory[sp] = oldLow;
-  state.memory[sp + 1] = oldHigh;
+  state.memory.fastWrite(sp, oldLow);
+  state.memory.fastWrite(sp + 1, oldHigh);
 
   utils::Logger::write(("Snapshot saved to " + std::string(filename)).c_str());
 }
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SpectrumPorts.h"
+#include "ProcessorState.h"
+#include <algorithm>
+
+byte UlaPort::read(word port) {
+  byte ear = state.tape.getEarBit() ? 0x40 : 0x00;
+  return state.keyboard.readPort(port >> 8) | ear;
+}
+
+void UlaPort::write(word, byte value) {
+  if (state.memory.getVideoBuffer())
+    state.memory.getVideoBuffer()->setBorderColor(value & 0x07,
+                                                  state.getFrameTStates());
+  state.setSpeakerBit((value & 0x10) != 0);
+  state.setMicBit((value & 0x08) != 0);
+}
+
+/**
+ * A register select at 0xFFFD or data at 0xBFFD. Registers keep only the
+ * bits the chip has.
+ */
+void AyPort::write(word port, byte value) {
+  static const byte widths[REGISTERS] = {0xFF, 0x0F, 0xFF, 0x0F, 0xFF, 0x0F,
+                                         0x1F, 0xFF, 0x1F, 0x1F, 0x1F, 0xFF,
+                                         0xFF, 0x0F, 0xFF, 0xFF};
+  if (port & 0x4000)
+    selected = value & (REGISTERS - 1);
+  else
+    registers[selected] = value & widths[selected];
+}
+
+void AyPort::reset() {
+  selected = 0;
+  std::fill(registers, registers + REGISTERS, 0);
+}
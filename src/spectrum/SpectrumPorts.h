@@ -0,0 +1,102 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_SPECTRUMPORTS_H
+#define ZXEMULATOR_SPECTRUMPORTS_H
+
+#include "../utils/BaseTypes.h"
+#include "Keyboard.h"
+#include "Memory.h"
+#include "PortMap.h"
+
+class ProcessorState;
+
+// The ULA, on every even port: the keyboard half rows selected by the high
+// byte and the EAR bit in; border, MIC and speaker out
+class UlaPort : public PortDevice {
+public:
+  static constexpr word MASK = 0x0001;
+  static constexpr word MATCH = 0x0000;
+
+  explicit UlaPort(ProcessorState &state) : state(state) {}
+  byte read(word port) override;
+  void write(word port, byte value) override;
+
+private:
+  ProcessorState &state;
+};
+
+// Kempston joystick interface, read at port 0x1F
+class KempstonPort : public PortDevice {
+public:
+  static constexpr word MASK = 0x001F;
+  static constexpr word MATCH = 0x001F;
+
+  explicit KempstonPort(Keyboard &keyboard) : keyboard(keyboard) {}
+  byte read(word) override { return keyboard.readKempstonPort(); }
+
+private:
+  Keyboard &keyboard;
+};
+
+// 128K paging register, written at 0x7FFD. The machine model has how much
+// of the port is decoded.
+class PagingPort : public PortDevice {
+public:
+  explicit PagingPort(Memory &memory) : memory(memory) {}
+  void write(word, byte value) override { memory.writePagingPort(value); }
+
+private:
+  Memory &memory;
+};
+
+// The +2A's second paging register, written at 0x1FFD
+class PlusPagingPort : public PortDevice {
+public:
+  explicit PlusPagingPort(Memory &memory) : memory(memory) {}
+  void write(word, byte value) override {
+    memory.writePlusPagingPort(value);
+  }
+
+private:
+  Memory &memory;
+};
+
+// The 128K's AY-3-8912 registers. 0xFFFD selects a register and reads it
+// back, 0xBFFD writes it. Nothing is played from them yet, but software
+// probing for the chip finds it.
+class AyPort : public PortDevice {
+public:
+  // Reads decode A15, A14 and A1; writes only A15 and A1, with A14
+  // telling a register select from data
+  static constexpr word READ_MASK = 0xC002;
+  static constexpr word READ_MATCH = 0xC000;
+  static constexpr word WRITE_MASK = 0x8002;
+  static constexpr word WRITE_MATCH = 0x8000;
+  static constexpr int REGISTERS = 16;
+
+  byte read(word) override { return registers[selected]; }
+  void write(word port, byte value) override;
+
+  byte getRegister(int index) const { return registers[index]; }
+  void reset();
+
+private:
+  byte selected = 0;
+  byte registers[REGISTERS] = {};
+};
+
+#endif // ZXEMULATOR_SPECTRUMPORTS_H
@@ -244,7 +244,7 @@ bool Tape::fastLoadBlock(byte expectedFlag, word length, word startAddress,
         const std::vector<byte> &data = blocks[scanIndex].data;
         for (size_t i = 0; i < length; i++) {
           if (i + 1 < data.size())
-            memory[(startAddress + i) & 0xFFFF] = data[i + 1];
+            memory.fastWrite((startAddress + i) & 0xFFFF, data[i + 1]);
         }
 
         // Advance Tape
@@ -53,6 +53,9 @@ public:
 
   void update(int tStates);
 
+  // T-states until update() will next change the EAR bit while playing
+  long tStatesToNextEdge() const { return nextEdgeTState - tStateCounter; }
+
   bool isPlaying() const { return playing; }
 
   // Fast Load Support
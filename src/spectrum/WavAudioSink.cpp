@@ -0,0 +1,81 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WavAudioSink.h"
+#include "Audio.h"
+#include <stdexcept>
+
+namespace {
+
+void put16(std::FILE *file, std::uint16_t value) {
+  std::fputc(value & 0xFF, file);
+  std::fputc(value >> 8, file);
+}
+
+void put32(std::FILE *file, std::uint32_t value) {
+  put16(file, value & 0xFFFF);
+  put16(file, value >> 16);
+}
+
+} // namespace
+
+WavAudioSink::WavAudioSink(const std::string &filename) {
+  file = std::fopen(filename.c_str(), "wb");
+  if (!file)
+    throw std::runtime_error("Can't create " + filename);
+  writeHeader();
+}
+
+WavAudioSink::~WavAudioSink() { close(); }
+
+/**
+ * Write the RIFF header for the samples written so far
+ */
+void WavAudioSink::writeHeader() {
+  const std::uint32_t dataBytes = sampleCount * 2;
+  std::fputs("RIFF", file);
+  put32(file, 36 + dataBytes);
+  std::fputs("WAVEfmt ", file);
+  put32(file, 16);                    // fmt chunk size
+  put16(file, 1);                     // PCM
+  put16(file, 1);                     // mono
+  put32(file, Audio::SAMPLE_RATE);    // sample rate
+  put32(file, Audio::SAMPLE_RATE * 2); // byte rate
+  put16(file, 2);                     // block align
+  put16(file, 16);                    // bits per sample
+  std::fputs("data", file);
+  put32(file, dataBytes);
+}
+
+void WavAudioSink::write(const std::int16_t *samples, std::size_t count) {
+  if (!file)
+    return;
+  for (std::size_t i = 0; i < count; i++)
+    put16(file, (std::uint16_t)samples[i]);
+  sampleCount += (std::uint32_t)count;
+}
+
+/**
+ * Fill in the header sizes and close the file. Further samples are dropped.
+ */
+void WavAudioSink::close() {
+  if (!file)
+    return;
+  std::fseek(file, 0, SEEK_SET);
+  writeHeader();
+  std::fclose(file);
+  file = nullptr;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_WAVAUDIOSINK_H
+#define ZXEMULATOR_WAVAUDIOSINK_H
+
+#include "AudioSink.h"
+#include <cstdio>
+#include <string>
+
+/**
+ * Streams audio to a 16-bit mono PCM WAV file. The header sizes are
+ * patched when the file is closed, so a crashed run leaves the samples
+ * readable with a zero-length header.
+ */
+class WavAudioSink : public AudioSink {
+private:
+  std::FILE *file = nullptr;
+  std::uint32_t sampleCount = 0;
+
+  void writeHeader();
+
+public:
+  // Throws std::runtime_error if the file can't be created
+  explicit WavAudioSink(const std::string &filename);
+  ~WavAudioSink() override;
+
+  WavAudioSink(const WavAudioSink &) = delete;
+  WavAudioSink &operator=(const WavAudioSink &) = delete;
+
+  void write(const std::int16_t *samples, std::size_t count) override;
+  void close();
+
+  std::uint32_t getSampleCount() const { return sampleCount; }
+};
+
+#endif // ZXEMULATOR_WAVAUDIOSINK_H
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_Z80STATE_H
+#define ZXEMULATOR_Z80STATE_H
+
+#include "LazyFlags.h"
+#include "ProcessorTypes.h"
+
+/**
+ * The Z80 itself: registers, deferred flags and the interrupt state, with
+ * nothing attached.
+ *
+ * The opcode handlers are templates over a Bus, a class derived from this
+ * one that adds what the CPU is wired to. Each bus gets its own copy of the
+ * handlers with its accesses inlined, so a machine only pays for its own
+ * memory map and port decoding. A Bus provides:
+ *
+ *   byte fetch(word address)            - opcode and prefix bytes (M1)
+ *   byte read(word address)             - operands and data
+ *   void write(word address, byte)
+ *   byte in(word port)                  - the full 16-bit port address
+ *   void out(word port, byte value)
+ *
+ * ProcessorState is the Spectrum, DebugBus the Spectrum with watchpoints
+ * and FlatBus a bare 64K machine for test harnesses. Instructions that
+ * only touch registers take a Z80State.
+ */
+class Z80State {
+private:
+  bool interruptsEnabled = false;
+  int interruptMode = 0; // Default IM 0 on reset
+  bool halted = false;
+
+public:
+  Z80Registers registers{}; // Zeroed, as reset() leaves the shadow set
+
+  // Deferred flags when running the lazy flag core
+  LazyFlags lazyFlags;
+
+  void setInterrupts(bool value) {
+    interruptsEnabled = value;
+    registers.IFF1 = value ? 1 : 0;
+    registers.IFF2 = value ? 1 : 0;
+  }
+  bool areInterruptsEnabled() const { return interruptsEnabled; }
+  void setInterruptMode(int mode) { interruptMode = mode; }
+  int getInterruptMode() const { return interruptMode; }
+  void setHalted(bool value) { halted = value; }
+  bool isHalted() const { return halted; }
+
+  // Program counter util functions
+  long incPC() { return incPC(1); }
+  long incPC(int value) { return registers.PC += value; }
+  long decPC(int value) { return registers.PC -= value; }
+  long setPC(long address) { return registers.PC = address; }
+};
+
+#endif // ZXEMULATOR_Z80STATE_H
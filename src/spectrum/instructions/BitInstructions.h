@@ -3,603 +3,149 @@
 
 #include "../../utils/BaseTypes.h"
 #include "../ProcessorMacros.h"
-#include "../ProcessorState.h"
+#include "../Z80State.h"
+#include "FlagTables.h"
 #include <cstdint>
 
 namespace Bit {
 
 // Accumulator Rotates (Preserve S, Z, P/V)
-inline void rlca(ProcessorState &state) {
-  emulator_types::byte val = state.registers.A;
-  int carry = (val & 0x80) ? 1 : 0;
-  val = (val << 1) | carry;
-  state.registers.A = val;
-
-  if (carry)
-    SET_FLAG(C_FLAG, state.registers);
-  else
-    CLEAR_FLAG(C_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-
-  if (val & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (val & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+// H=0, N=0, C from the bit shifted out, 5 and 3 from the result
+inline void setAccumulatorRotateFlags(Z80State &state, int carry) {
+  state.registers.F = (state.registers.F & (S_FLAG | Z_FLAG | P_FLAG)) |
+                      (state.registers.A & (X_FLAG | Y_FLAG)) | carry;
 }
 
-inline void rrca(ProcessorState &state) {
+inline void rlca(Z80State &state) {
   emulator_types::byte val = state.registers.A;
-  int carry = (val & 0x01) ? 1 : 0;
-  val = (val >> 1) | (carry << 7);
-  state.registers.A = val;
-
-  if (carry)
-    SET_FLAG(C_FLAG, state.registers);
-  else
-    CLEAR_FLAG(C_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-
-  if (val & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (val & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+  int carry = val >> 7;
+  state.registers.A = (val << 1) | carry;
+  setAccumulatorRotateFlags(state, carry);
 }
 
-inline void rla(ProcessorState &state) {
+inline void rrca(Z80State &state) {
   emulator_types::byte val = state.registers.A;
-  int carry = (val & 0x80) ? 1 : 0;
-  int oldCarry = GET_FLAG(C_FLAG, state.registers) ? 1 : 0;
-  val = (val << 1) | oldCarry;
-  state.registers.A = val;
-
-  if (carry)
-    SET_FLAG(C_FLAG, state.registers);
-  else
-    CLEAR_FLAG(C_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-
-  if (val & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (val & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+  int carry = val & 0x01;
+  state.registers.A = (val >> 1) | (carry << 7);
+  setAccumulatorRotateFlags(state, carry);
 }
 
-inline void rra(ProcessorState &state) {
+inline void rla(Z80State &state) {
   emulator_types::byte val = state.registers.A;
-  int carry = (val & 0x01) ? 1 : 0;
-  int oldCarry = GET_FLAG(C_FLAG, state.registers) ? 1 : 0;
-  val = (val >> 1) | (oldCarry << 7);
-  state.registers.A = val;
-
-  if (carry)
-    SET_FLAG(C_FLAG, state.registers);
-  else
-    CLEAR_FLAG(C_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
+  int carry = val >> 7;
+  state.registers.A = (val << 1) | (state.registers.F & C_FLAG);
+  setAccumulatorRotateFlags(state, carry);
+}
 
-  if (val & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (val & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+inline void rra(Z80State &state) {
+  emulator_types::byte val = state.registers.A;
+  int carry = val & 0x01;
+  state.registers.A = (val >> 1) | ((state.registers.F & C_FLAG) << 7);
+  setAccumulatorRotateFlags(state, carry);
 }
 
-inline void rlc(ProcessorState &state, emulator_types::byte &val) {
-  int carry = (val & 0x80) ? 1 : 0;
+// CB Rotates and Shifts
+// S, Z, 5, 3, P/V=Parity from the result, H=0, N=0, C from the bit shifted out
+inline void rlc(Z80State &state, emulator_types::byte &val) {
+  int carry = val >> 7;
   val = (val << 1) | carry;
-
-  if (carry)
-    SET_FLAG(C_FLAG, state.registers);
-  else
-    CLEAR_FLAG(C_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-  if (val == 0)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-  if (val & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-
-  // P/V Parity
-  int bits = 0;
-  for (int i = 0; i < 8; i++) {
-    if (val & (1 << i))
-      bits++;
-  }
-  if (bits % 2 == 0)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
-
-  if (val & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (val & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+  state.registers.F = Flags::sz53p[val] | carry;
 }
 
-inline void rrc(ProcessorState &state, emulator_types::byte &val) {
-  int carry = (val & 0x01) ? 1 : 0;
+inline void rrc(Z80State &state, emulator_types::byte &val) {
+  int carry = val & 0x01;
   val = (val >> 1) | (carry << 7);
-
-  if (carry)
-    SET_FLAG(C_FLAG, state.registers);
-  else
-    CLEAR_FLAG(C_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-  if (val == 0)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-  if (val & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-
-  // P/V Parity
-  int bits = 0;
-  for (int i = 0; i < 8; i++) {
-    if (val & (1 << i))
-      bits++;
-  }
-  if (bits % 2 == 0)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
-
-  if (val & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (val & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+  state.registers.F = Flags::sz53p[val] | carry;
 }
 
-inline void rl(ProcessorState &state, emulator_types::byte &val) {
-  int carry = (val & 0x80) ? 1 : 0;
-  int oldCarry = GET_FLAG(C_FLAG, state.registers) ? 1 : 0;
-  val = (val << 1) | oldCarry;
-
-  if (carry)
-    SET_FLAG(C_FLAG, state.registers);
-  else
-    CLEAR_FLAG(C_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-  if (val == 0)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-  if (val & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-
-  // P/V Parity
-  int bits = 0;
-  for (int i = 0; i < 8; i++) {
-    if (val & (1 << i))
-      bits++;
-  }
-  if (bits % 2 == 0)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
-
-  if (val & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (val & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+inline void rl(Z80State &state, emulator_types::byte &val) {
+  int carry = val >> 7;
+  val = (val << 1) | (state.registers.F & C_FLAG);
+  state.registers.F = Flags::sz53p[val] | carry;
 }
 
-inline void rr(ProcessorState &state, emulator_types::byte &val) {
-  int carry = (val & 0x01) ? 1 : 0;
-  int oldCarry = GET_FLAG(C_FLAG, state.registers) ? 1 : 0;
-  val = (val >> 1) | (oldCarry << 7);
-
-  if (carry)
-    SET_FLAG(C_FLAG, state.registers);
-  else
-    CLEAR_FLAG(C_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-  if (val == 0)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-  if (val & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-
-  // P/V Parity
-  int bits = 0;
-  for (int i = 0; i < 8; i++) {
-    if (val & (1 << i))
-      bits++;
-  }
-  if (bits % 2 == 0)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
-
-  if (val & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (val & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+inline void rr(Z80State &state, emulator_types::byte &val) {
+  int carry = val & 0x01;
+  val = (val >> 1) | ((state.registers.F & C_FLAG) << 7);
+  state.registers.F = Flags::sz53p[val] | carry;
 }
 
-inline void sla(ProcessorState &state, emulator_types::byte &val) {
-  int carry = (val & 0x80) ? 1 : 0;
+inline void sla(Z80State &state, emulator_types::byte &val) {
+  int carry = val >> 7;
   val = val << 1;
-
-  if (carry)
-    SET_FLAG(C_FLAG, state.registers);
-  else
-    CLEAR_FLAG(C_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-  if (val == 0)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-  if (val & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-
-  // P/V Parity
-  int bits = 0;
-  for (int i = 0; i < 8; i++) {
-    if (val & (1 << i))
-      bits++;
-  }
-  if (bits % 2 == 0)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
-
-  if (val & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (val & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+  state.registers.F = Flags::sz53p[val] | carry;
 }
 
-inline void sra(ProcessorState &state, emulator_types::byte &val) {
-  int carry = (val & 0x01) ? 1 : 0;
-  int msb = val & 0x80;
-  val = (val >> 1) | msb;
-
-  if (carry)
-    SET_FLAG(C_FLAG, state.registers);
-  else
-    CLEAR_FLAG(C_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-  if (val == 0)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-  if (val & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-
-  // P/V Parity
-  int bits = 0;
-  for (int i = 0; i < 8; i++) {
-    if (val & (1 << i))
-      bits++;
-  }
-  if (bits % 2 == 0)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
-
-  if (val & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (val & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+inline void sra(Z80State &state, emulator_types::byte &val) {
+  int carry = val & 0x01;
+  val = (val >> 1) | (val & 0x80);
+  state.registers.F = Flags::sz53p[val] | carry;
 }
 
-inline void sll(ProcessorState &state, emulator_types::byte &val) {
+inline void sll(Z80State &state, emulator_types::byte &val) {
   // SLL (Undocumented): Shift Left Logical, inserts 1 into bit 0
-  int carry = (val & 0x80) ? 1 : 0;
+  int carry = val >> 7;
   val = (val << 1) | 0x01;
-
-  if (carry)
-    SET_FLAG(C_FLAG, state.registers);
-  else
-    CLEAR_FLAG(C_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-  if (val == 0)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-  if (val & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-
-  // P/V Parity
-  int bits = 0;
-  for (int i = 0; i < 8; i++) {
-    if (val & (1 << i))
-      bits++;
-  }
-  if (bits % 2 == 0)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
-
-  if (val & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (val & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+  state.registers.F = Flags::sz53p[val] | carry;
 }
 
-inline void srl(ProcessorState &state, emulator_types::byte &val) {
-  int carry = (val & 0x01) ? 1 : 0;
+inline void srl(Z80State &state, emulator_types::byte &val) {
+  int carry = val & 0x01;
   val = val >> 1;
-
-  if (carry)
-    SET_FLAG(C_FLAG, state.registers);
-  else
-    CLEAR_FLAG(C_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-  if (val == 0)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-  if (val & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-
-  // P/V Parity
-  int bits = 0;
-  for (int i = 0; i < 8; i++) {
-    if (val & (1 << i))
-      bits++;
-  }
-  if (bits % 2 == 0)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
-
-  if (val & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (val & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+  state.registers.F = Flags::sz53p[val] | carry;
 }
 
-inline void bit(ProcessorState &state, int bit, emulator_types::byte val) {
-  bool z = !((val >> bit) & 1);
-  if (z)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-
-  SET_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-
-  // Undocumented Flags:
-  // S, 5 (Y), 3 (X) are copied from the high byte of the address... wait, for
-  // BIT it is the value tested? Z80 Manual: X and Y are copied from the tested
-  // byte? Or instruction? Actually, for BIT b, (HL) -> Top bits of address
-  // (MEMPTR). For BIT b, r -> r's bits. My previous fix in Processor.cpp for
-  // BIT handled this? No, wait. I fixed Processor.cpp or BitInstructions.h
-  // before? I edited BitInstructions.h before. The code here says: "S, 5 (Y), 3
-  // (X) are copied from the input value" This is correct for BIT b, r.
-
-  if (val & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-
-  if (val & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-
-  if (val & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
-
-  // P/V is set to the same state as Z
-  if (z)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
+// BIT b, r
+// Z and P/V are set if the bit is clear, H=1, N=0, C preserved.
+// Undocumented: S, 5 (Y) and 3 (X) are copied from the tested value.
+inline void bit(Z80State &state, int bit, emulator_types::byte val) {
+  emulator_types::byte z = ((val >> bit) & 1) ? 0 : (Z_FLAG | P_FLAG);
+  state.registers.F = (state.registers.F & C_FLAG) | H_FLAG | z |
+                      (val & (S_FLAG | Y_FLAG | X_FLAG));
 }
 
 // Helper for memory-based BIT instructions (HL or Index)
 // where X/Y flags come from the High Byte of the address (memptr)
-// not the value itself.
-inline void bitMem(ProcessorState &state, int bit, emulator_types::byte val,
+// not the value itself. S is still copied from the tested value.
+inline void bitMem(Z80State &state, int bit, emulator_types::byte val,
                    emulator_types::byte mem_high_byte) {
-  bool z = !((val >> bit) & 1);
-  if (z)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-
-  SET_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-
-  // Undocumented Flags:
-  // S copied from input value (?) - Usually documented as preserved/unknown or
-  // logic based. Actually Z80 says S is not affected? No, BIT affects Z, N, H.
-  // S, P/V, C are documented as unknown.
-  // But strict Z80 behavior:
-  // S is copied from bit 7 of the target.
-  // X and Y are copied from bit 3 and 5 of the address high byte (internal
-  // register).
-
-  if (val & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-
-  if (mem_high_byte & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-
-  if (mem_high_byte & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
-
-  // P/V is set to the same state as Z
-  if (z)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
+  emulator_types::byte z = ((val >> bit) & 1) ? 0 : (Z_FLAG | P_FLAG);
+  state.registers.F = (state.registers.F & C_FLAG) | H_FLAG | z |
+                      (val & S_FLAG) | (mem_high_byte & (Y_FLAG | X_FLAG));
 }
 
-inline void set(ProcessorState &state, int bit, emulator_types::byte &val) {
+inline void set(Z80State &state, int bit, emulator_types::byte &val) {
   val |= (1 << bit);
 }
 
-inline void res(ProcessorState &state, int bit, emulator_types::byte &val) {
+inline void res(Z80State &state, int bit, emulator_types::byte &val) {
   val &= ~(1 << bit);
 }
 
 // Rotate Decimal
-inline void rrd(ProcessorState &state) {
+// S, Z, 5, 3, P/V=Parity from A, H=0, N=0, C preserved
+template <class Bus> inline void rrd(Bus &state) {
   emulator_types::byte a = state.registers.A;
-  emulator_types::byte hl = state.memory[state.registers.HL];
+  emulator_types::byte hl = state.read(state.registers.HL);
 
   emulator_types::byte finalA = (a & 0xF0) | (hl & 0x0F);
   emulator_types::byte finalHL = ((a & 0x0F) << 4) | ((hl >> 4) & 0x0F);
 
   state.registers.A = finalA;
-  state.memory.fastWrite(state.registers.HL, finalHL);
-
-  if (finalA & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-  if (finalA == 0)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-
-  int p = 0;
-  for (int i = 0; i < 8; i++)
-    if (finalA & (1 << i))
-      p++;
-  if ((p % 2) == 0)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
-
-  if (finalA & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (finalA & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+  state.write(state.registers.HL, finalHL);
+  state.registers.F = (state.registers.F & C_FLAG) | Flags::sz53p[finalA];
 }
 
-inline void rld(ProcessorState &state) {
+template <class Bus> inline void rld(Bus &state) {
   emulator_types::byte a = state.registers.A;
-  emulator_types::byte hl = state.memory[state.registers.HL];
+  emulator_types::byte hl = state.read(state.registers.HL);
 
   emulator_types::byte finalA = (a & 0xF0) | ((hl >> 4) & 0x0F);
   emulator_types::byte finalHL = ((hl & 0x0F) << 4) | (a & 0x0F);
 
   state.registers.A = finalA;
-  state.memory.fastWrite(state.registers.HL, finalHL);
-
-  if (finalA & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-  if (finalA == 0)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-  CLEAR_FLAG(H_FLAG, state.registers);
-  CLEAR_FLAG(N_FLAG, state.registers);
-
-  int p = 0;
-  for (int i = 0; i < 8; i++)
-    if (finalA & (1 << i))
-      p++;
-  if ((p % 2) == 0)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
-
-  if (finalA & 0x20)
-    SET_FLAG(Y_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Y_FLAG, state.registers);
-  if (finalA & 0x08)
-    SET_FLAG(X_FLAG, state.registers);
-  else
-    CLEAR_FLAG(X_FLAG, state.registers);
+  state.write(state.registers.HL, finalHL);
+  state.registers.F = (state.registers.F & C_FLAG) | Flags::sz53p[finalA];
 }
 
 } // namespace Bit
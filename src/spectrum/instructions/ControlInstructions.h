@@ -6,6 +6,7 @@
 #include "../ProcessorState.h"
 #include "LoadInstructions.h"
 #include <cstdint>
+#include <cstring>
 
 namespace Control {
 
@@ -13,13 +14,13 @@ namespace Control {
 // JR e (2 bytes). PC points to e.
 // Logic: PC++. Return PC = Next Op. Taken: PC += e.
 // e is signed.
-inline int jr(ProcessorState &state, int8_t offset) {
+inline int jr(Z80State &state, int8_t offset) {
   state.registers.PC++;
   state.registers.PC += offset;
   return 12;
 }
 
-inline int jr_cond(ProcessorState &state, bool condition, int8_t offset) {
+inline int jr_cond(Z80State &state, bool condition, int8_t offset) {
   state.registers.PC++; // Advance past offset
   if (condition) {
     state.registers.PC += offset;
@@ -28,7 +29,7 @@ inline int jr_cond(ProcessorState &state, bool condition, int8_t offset) {
   return 7; // Not taken
 }
 
-inline int djnz(ProcessorState &state, int8_t offset) {
+inline int djnz(Z80State &state, int8_t offset) {
   state.registers.PC++; // Advance past offset
   state.registers.B--;
   if (state.registers.B != 0) {
@@ -40,13 +41,13 @@ inline int djnz(ProcessorState &state, int8_t offset) {
 
 // Absolute Jumps
 // JP nn (3 bytes). PC points to nn.
-inline int jp(ProcessorState &state, emulator_types::word nn) {
+inline int jp(Z80State &state, emulator_types::word nn) {
   // PC is overwritten, no need to advance.
   state.registers.PC = nn;
   return 10;
 }
 
-inline int jp_cond(ProcessorState &state, bool condition,
+inline int jp_cond(Z80State &state, bool condition,
                    emulator_types::word nn) {
   if (condition) {
     state.registers.PC = nn;
@@ -57,31 +58,32 @@ inline int jp_cond(ProcessorState &state, bool condition,
   return 10;
 }
 
-inline int jp_hl(ProcessorState &state) {
+inline int jp_hl(Z80State &state) {
   state.registers.PC = state.registers.HL;
   return 4;
 }
 
-inline int jp_ix(ProcessorState &state) {
+inline int jp_ix(Z80State &state) {
   state.registers.PC = state.registers.IX;
   return 8;
 }
 
-inline int jp_iy(ProcessorState &state) {
+inline int jp_iy(Z80State &state) {
   state.registers.PC = state.registers.IY;
   return 8;
 }
 
 // Call / Return
 // CALL nn (3 bytes). PC points to nn.
-inline int call(ProcessorState &state, emulator_types::word nn) {
+template <class Bus> inline int call(Bus &state, emulator_types::word nn) {
   state.registers.PC += 2; // Advance past operand (Return Address)
   Load::push16(state, state.registers.PC);
   state.registers.PC = nn;
   return 17;
 }
 
-inline int call_cond(ProcessorState &state, bool condition,
+template <class Bus>
+inline int call_cond(Bus &state, bool condition,
                      emulator_types::word nn) {
   state.registers.PC += 2; // Advance past operand
   if (condition) {
@@ -92,12 +94,12 @@ inline int call_cond(ProcessorState &state, bool condition,
   return 10;
 }
 
-inline int ret(ProcessorState &state) {
+template <class Bus> inline int ret(Bus &state) {
   state.registers.PC = Load::pop16(state);
   return 10;
 }
 
-inline int ret_cond(ProcessorState &state, bool condition) {
+template <class Bus> inline int ret_cond(Bus &state, bool condition) {
   if (condition) {
     state.registers.PC = Load::pop16(state);
     return 11;
@@ -105,16 +107,16 @@ inline int ret_cond(ProcessorState &state, bool condition) {
   return 5;
 }
 
-inline int rst(ProcessorState &state, emulator_types::word address) {
+template <class Bus> inline int rst(Bus &state, emulator_types::word address) {
   Load::push16(state, state.registers.PC); // PC is already next op
   state.registers.PC = address;
   return 11;
 }
 
 // Search (Block)
-inline int cpi(ProcessorState &state) {
+template <class Bus> inline int cpi(Bus &state) {
   // Compare A with (HL), HL++, BC--
-  emulator_types::byte value = state.memory[state.registers.HL];
+  emulator_types::byte value = state.read(state.registers.HL);
   int result = state.registers.A - value;
 
   bool z = (result == 0);
@@ -149,9 +151,9 @@ inline int cpi(ProcessorState &state) {
   return 16;
 }
 
-inline int cpd(ProcessorState &state) {
+template <class Bus> inline int cpd(Bus &state) {
   // Compare A with (HL), HL--, BC--
-  emulator_types::byte value = state.memory[state.registers.HL];
+  emulator_types::byte value = state.read(state.registers.HL);
   int result = state.registers.A - value;
 
   bool z = (result == 0);
@@ -186,9 +188,9 @@ inline int cpd(ProcessorState &state) {
   return 16;
 }
 
-inline int cpir(ProcessorState &state) {
+template <class Bus> inline int cpir(Bus &state) {
   // Compare A with (HL), HL++, BC--
-  emulator_types::byte value = state.memory[state.registers.HL];
+  emulator_types::byte value = state.read(state.registers.HL);
   int result = state.registers.A - value;
 
   bool z = (result == 0);
@@ -229,9 +231,9 @@ inline int cpir(ProcessorState &state) {
   }
 }
 
-inline int cpdr(ProcessorState &state) {
+template <class Bus> inline int cpdr(Bus &state) {
   // Compare A with (HL), HL--, BC--
-  emulator_types::byte value = state.memory[state.registers.HL];
+  emulator_types::byte value = state.read(state.registers.HL);
   int result = state.registers.A - value;
 
   bool z = (result == 0);
@@ -272,32 +274,97 @@ inline int cpdr(ProcessorState &state) {
   }
 }
 
-inline int reti(ProcessorState &state) {
+// Bulk CPIR/CPDR. Scan up to 'iterations' bytes for A at once; only the
+// last compare shows in the flags, so that one runs as a normal step.
+// Returns the passes run, or 0 when the caller must step instead.
+inline int cpirBulk(ProcessorState &state, int iterations) {
+  Z80Registers &r = state.registers;
+  int count = r.BC ? r.BC : 0x10000;
+  int n = iterations < count ? iterations : count;
+  // Scan no further than the end of HL's 16K slot
+  int left = BANK_SIZE - (r.HL & BANK_MASK);
+  n = n < left ? n : left;
+
+  const emulator_types::byte *start = state.memory.getPointer(r.HL);
+  const void *match = memchr(start, r.A, n);
+  int run =
+      match ? (int)(static_cast<const emulator_types::byte *>(match) - start) + 1
+            : n;
+
+  r.HL += run - 1;
+  r.BC -= run - 1;
+  cpir(state);
+  return run;
+}
+
+inline int cpdrBulk(ProcessorState &state, int iterations) {
+  Z80Registers &r = state.registers;
+  int count = r.BC ? r.BC : 0x10000;
+  int n = iterations < count ? iterations : count;
+  // Scan no further than the start of HL's 16K slot
+  int left = (r.HL & BANK_MASK) + 1;
+  n = n < left ? n : left;
+
+  const emulator_types::byte *end = state.memory.getPointer(r.HL);
+  int run = 0;
+  while (run < n && end[-run] != r.A)
+    run++;
+  run = run < n ? run + 1 : n;
+
+  r.HL -= run - 1;
+  r.BC -= run - 1;
+  cpdr(state);
+  return run;
+}
+
+template <class Bus> inline int reti(Bus &state) {
   state.registers.PC = Load::pop16(state);
   return 14;
 }
 
-inline int retn(ProcessorState &state) {
+template <class Bus> inline int retn(Bus &state) {
   state.registers.PC = Load::pop16(state);
   state.registers.IFF1 = state.registers.IFF2;
   state.setInterrupts(state.registers.IFF1);
   return 14;
 }
 
-inline int di(ProcessorState &state) {
+inline int di(Z80State &state) {
   state.setInterrupts(false);
   state.registers.IFF1 = 0;
   state.registers.IFF2 = 0;
   return 4;
 }
 
-inline int ei(ProcessorState &state) {
+inline int ei(Z80State &state) {
   state.setInterrupts(true);
   state.registers.IFF1 = 1;
   state.registers.IFF2 = 1;
   return 4;
 }
 
+// Accept a maskable interrupt if they are enabled, ending any HALT. The
+// data bus floats at 0xFF, so IM 0 runs RST 38 as IM 1 does and the IM 2
+// vector is read from (I << 8) | 0xFF.
+// Returns the T-states taken, or 0 if the interrupt was ignored.
+template <class Bus> inline int interrupt(Bus &state) {
+  if (!state.areInterruptsEnabled())
+    return 0;
+  // PC already points to the instruction following a HALT
+  state.setHalted(false);
+  Load::push16(state, state.registers.PC);
+  state.setInterrupts(false);
+  if (state.getInterruptMode() == 2) {
+    emulator_types::word vector = (state.registers.I << 8) | 0xFF;
+    emulator_types::byte low = state.read(vector);
+    emulator_types::byte high = state.read((emulator_types::word)(vector + 1));
+    state.registers.PC = (high << 8) | low;
+    return 19;
+  }
+  state.registers.PC = 0x0038;
+  return 13;
+}
+
 } // namespace Control
 
 #endif
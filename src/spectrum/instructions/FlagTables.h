@@ -0,0 +1,130 @@
+#ifndef ZXEMULATOR_FLAG_TABLES_H
+#define ZXEMULATOR_FLAG_TABLES_H
+
+#include "../../utils/BaseTypes.h"
+#include "../ProcessorMacros.h"
+#include <array>
+
+// Precomputed flag tables for the ALU helpers.
+//
+// All tables are generated at compile time. The 8-bit result tables are
+// indexed by the result byte; the half-carry and overflow tables are indexed
+// by a 3 bit lookup built from bit 3 (or bit 7) of the two operands and the
+// result:
+//
+//   lookup = ((a & 0x88) >> 3) | ((b & 0x88) >> 2) | ((result & 0x88) >> 1)
+//
+// which leaves the bit 3 combination in bits 0-2 (half carry) and the bit 7
+// combination in bits 4-6 (overflow).
+namespace Flags {
+
+using FlagTable = std::array<emulator_types::byte, 256>;
+
+namespace detail {
+
+constexpr bool evenParity(int value) {
+  int bits = 0;
+  for (int i = 0; i < 8; i++)
+    bits += (value >> i) & 1;
+  return (bits & 1) == 0;
+}
+
+// S and Z
+constexpr FlagTable makeSz() {
+  FlagTable table{};
+  for (int i = 0; i < 256; i++)
+    table[i] = (i & S_FLAG) | (i == 0 ? Z_FLAG : 0);
+  return table;
+}
+
+// S, Z and the undocumented 5 (Y) and 3 (X) bits
+constexpr FlagTable makeSz53() {
+  FlagTable table{};
+  for (int i = 0; i < 256; i++)
+    table[i] = (i & (S_FLAG | Y_FLAG | X_FLAG)) | (i == 0 ? Z_FLAG : 0);
+  return table;
+}
+
+// S, Z, 5, 3 and parity
+constexpr FlagTable makeSz53p() {
+  FlagTable table{};
+  for (int i = 0; i < 256; i++)
+    table[i] = (i & (S_FLAG | Y_FLAG | X_FLAG)) | (i == 0 ? Z_FLAG : 0) |
+               (evenParity(i) ? P_FLAG : 0);
+  return table;
+}
+
+// INC r: indexed by the result. C is preserved by the caller.
+constexpr FlagTable makeInc8() {
+  FlagTable table{};
+  for (int i = 0; i < 256; i++)
+    table[i] = (i & (S_FLAG | Y_FLAG | X_FLAG)) | (i == 0 ? Z_FLAG : 0) |
+               ((i & 0x0F) == 0x00 ? H_FLAG : 0) | (i == 0x80 ? P_FLAG : 0);
+  return table;
+}
+
+// DEC r: indexed by the result. C is preserved by the caller.
+constexpr FlagTable makeDec8() {
+  FlagTable table{};
+  for (int i = 0; i < 256; i++)
+    table[i] = (i & (S_FLAG | Y_FLAG | X_FLAG)) | (i == 0 ? Z_FLAG : 0) |
+               ((i & 0x0F) == 0x0F ? H_FLAG : 0) | (i == 0x7F ? P_FLAG : 0) |
+               N_FLAG;
+  return table;
+}
+
+} // namespace detail
+
+inline constexpr FlagTable sz = detail::makeSz();
+inline constexpr FlagTable sz53 = detail::makeSz53();
+inline constexpr FlagTable sz53p = detail::makeSz53p();
+inline constexpr FlagTable inc8 = detail::makeInc8();
+inline constexpr FlagTable dec8 = detail::makeDec8();
+
+// Half carry / overflow from the operand and result sign bits
+inline constexpr emulator_types::byte halfcarryAdd[8] = {
+    0, H_FLAG, H_FLAG, H_FLAG, 0, 0, 0, H_FLAG};
+inline constexpr emulator_types::byte halfcarrySub[8] = {
+    0, 0, H_FLAG, 0, H_FLAG, 0, H_FLAG, H_FLAG};
+inline constexpr emulator_types::byte overflowAdd[8] = {
+    0, 0, 0, P_FLAG, P_FLAG, 0, 0, 0};
+inline constexpr emulator_types::byte overflowSub[8] = {
+    0, P_FLAG, 0, 0, 0, 0, P_FLAG, 0};
+
+// Lookup index for 8-bit operations
+constexpr int lookup8(int a, int b, int result) {
+  return ((a & 0x88) >> 3) | ((b & 0x88) >> 2) | ((result & 0x88) >> 1);
+}
+
+// Lookup index for 16-bit operations (bits 11 and 15)
+constexpr int lookup16(int a, int b, int result) {
+  return ((a & 0x8800) >> 11) | ((b & 0x8800) >> 10) |
+         ((result & 0x8800) >> 9);
+}
+
+// Complete F for 8-bit ADD/ADC from the operands and the unmasked result
+constexpr emulator_types::byte add8(int a, int b, int result) {
+  int lookup = lookup8(a, b, result);
+  return ((result & 0x100) ? C_FLAG : 0) | halfcarryAdd[lookup & 0x07] |
+         overflowAdd[lookup >> 4] | sz53[result & 0xFF];
+}
+
+// Complete F for 8-bit SUB/SBC from the operands and the unmasked result
+constexpr emulator_types::byte sub8(int a, int b, int result) {
+  int lookup = lookup8(a, b, result);
+  return ((result & 0x100) ? C_FLAG : 0) | N_FLAG |
+         halfcarrySub[lookup & 0x07] | overflowSub[lookup >> 4] |
+         sz53[result & 0xFF];
+}
+
+// Complete F for CP. As SUB but 5 and 3 come from the operand
+constexpr emulator_types::byte cp8(int a, int b, int result) {
+  int lookup = lookup8(a, b, result);
+  return ((result & 0x100) ? C_FLAG : 0) | N_FLAG |
+         halfcarrySub[lookup & 0x07] | overflowSub[lookup >> 4] |
+         sz[result & 0xFF] | (b & (X_FLAG | Y_FLAG));
+}
+
+} // namespace Flags
+
+#endif
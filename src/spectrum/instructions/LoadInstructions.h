@@ -8,30 +8,33 @@
 namespace Load {
 
 // 16-bit PUSH/POP
-inline void push16(ProcessorState &state, emulator_types::word value) {
+template <class Bus>
+inline void push16(Bus &state, emulator_types::word value) {
   state.registers.SP -= 2;
-  state.memory.fastWrite(state.registers.SP + 1, (value >> 8) & 0xFF);
-  state.memory.fastWrite(state.registers.SP, value & 0xFF);
+  state.write(state.registers.SP + 1, (value >> 8) & 0xFF);
+  state.write(state.registers.SP, value & 0xFF);
 }
 
-inline emulator_types::word pop16(ProcessorState &state) {
-  emulator_types::byte low = state.memory[state.registers.SP];
-  emulator_types::byte high = state.memory[state.registers.SP + 1];
+template <class Bus> inline emulator_types::word pop16(Bus &state) {
+  emulator_types::byte low = state.read(state.registers.SP);
+  emulator_types::byte high = state.read(state.registers.SP + 1);
   state.registers.SP += 2;
   return (high << 8) | low;
 }
 
 // Extended Loads
-inline void ld_nn_rr(ProcessorState &state, emulator_types::word nn,
+template <class Bus>
+inline void ld_nn_rr(Bus &state, emulator_types::word nn,
                      emulator_types::word rr) {
-  state.memory.fastWrite(nn, (emulator_types::byte)(rr & 0xFF));
-  state.memory.fastWrite(nn + 1, (emulator_types::byte)((rr >> 8) & 0xFF));
+  state.write(nn, (emulator_types::byte)(rr & 0xFF));
+  state.write(nn + 1, (emulator_types::byte)((rr >> 8) & 0xFF));
 }
 
-inline void ld_rr_nn(ProcessorState &state, emulator_types::word &rr,
+template <class Bus>
+inline void ld_rr_nn(Bus &state, emulator_types::word &rr,
                      emulator_types::word nn) {
-  emulator_types::byte low = state.memory[nn];
-  emulator_types::byte high = state.memory[nn + 1];
+  emulator_types::byte low = state.read(nn);
+  emulator_types::byte high = state.read(nn + 1);
   rr = (emulator_types::word)(high << 8) | low;
 }
 
@@ -41,9 +44,9 @@ inline void ld_rr_nn(ProcessorState &state, emulator_types::word &rr,
 // cycle count. I should duplicate that logic: Return cycle count and manage PC?
 // Yes.
 
-inline int ldir(ProcessorState &state) {
-  emulator_types::byte value = state.memory[state.registers.HL];
-  state.memory.fastWrite(state.registers.DE, value);
+template <class Bus> inline int ldir(Bus &state) {
+  emulator_types::byte value = state.read(state.registers.HL);
+  state.write(state.registers.DE, value);
   state.registers.DE++;
   state.registers.HL++;
   state.registers.BC--;
@@ -60,9 +63,9 @@ inline int ldir(ProcessorState &state) {
   }
 }
 
-inline int lddr(ProcessorState &state) {
-  emulator_types::byte value = state.memory[state.registers.HL];
-  state.memory.fastWrite(state.registers.DE, value);
+template <class Bus> inline int lddr(Bus &state) {
+  emulator_types::byte value = state.read(state.registers.HL);
+  state.write(state.registers.DE, value);
   state.registers.DE--;
   state.registers.HL--;
   state.registers.BC--;
@@ -79,13 +82,71 @@ inline int lddr(ProcessorState &state) {
   }
 }
 
+// A block copy can be done in one go when neither range wraps, the
+// destination is RAM clear of the instruction and the two don't overlap.
+// An overlapping LDIR (the usual fill idiom) must go byte by byte, and
+// that includes two addresses of one bank on a 128K machine.
+inline bool blockCopyFits(const Memory &memory, long source,
+                          long destination, int length, long instruction) {
+  return destination >= ROM_SIZE &&
+         !memory.overlaps(destination, length, source, length) &&
+         !memory.overlaps(destination, length, instruction, 2);
+}
+
+// Bulk LDIR/LDDR. Run up to 'iterations' passes at once with a memmove
+// and leave registers, flags and PC as that many single steps would.
+// Returns the passes run, or 0 when the caller must step instead.
+inline int ldirBulk(ProcessorState &state, int iterations) {
+  Z80Registers &r = state.registers;
+  int count = r.BC ? r.BC : 0x10000;
+  int n = iterations < count ? iterations : count;
+  if (!blockCopyFits(state.memory, r.HL, r.DE, n,
+                     (emulator_types::word)(r.PC - 2)))
+    return 0;
+
+  state.memory.fastCopy(r.DE, r.HL, n);
+  r.DE += n;
+  r.HL += n;
+  r.BC -= n;
+
+  CLEAR_FLAG(H_FLAG, r);
+  CLEAR_FLAG(N_FLAG, r);
+  CLEAR_FLAG(P_FLAG, r);
+
+  if (r.BC != 0)
+    r.PC -= 2;
+  return n;
+}
+
+inline int lddrBulk(ProcessorState &state, int iterations) {
+  Z80Registers &r = state.registers;
+  int count = r.BC ? r.BC : 0x10000;
+  int n = iterations < count ? iterations : count;
+  if (!blockCopyFits(state.memory, r.HL - n + 1, r.DE - n + 1, n,
+                     (emulator_types::word)(r.PC - 2)))
+    return 0;
+
+  state.memory.fastCopy(r.DE - n + 1, r.HL - n + 1, n);
+  r.DE -= n;
+  r.HL -= n;
+  r.BC -= n;
+
+  CLEAR_FLAG(H_FLAG, r);
+  CLEAR_FLAG(N_FLAG, r);
+  CLEAR_FLAG(P_FLAG, r);
+
+  if (r.BC != 0)
+    r.PC -= 2;
+  return n;
+}
+
 // Single step versions (LDI/LDD) - If needed.
 // Processor.cpp had LDIR/LDDR but apparently not LDI/LDD logic explicitly
 // (unless shared). I will implement LDI/LDD logic cleanly if I use them. LDI:
 // Transfer, Inc, Dec BC. No loop.
-inline int ldi(ProcessorState &state) {
-  emulator_types::byte value = state.memory[state.registers.HL];
-  state.memory.fastWrite(state.registers.DE, value);
+template <class Bus> inline int ldi(Bus &state) {
+  emulator_types::byte value = state.read(state.registers.HL);
+  state.write(state.registers.DE, value);
   state.registers.DE++;
   state.registers.HL++;
   state.registers.BC--;
@@ -101,9 +162,9 @@ inline int ldi(ProcessorState &state) {
   return 16;
 }
 
-inline int ldd(ProcessorState &state) {
-  emulator_types::byte value = state.memory[state.registers.HL];
-  state.memory.fastWrite(state.registers.DE, value);
+template <class Bus> inline int ldd(Bus &state) {
+  emulator_types::byte value = state.read(state.registers.HL);
+  state.write(state.registers.DE, value);
   state.registers.DE--;
   state.registers.HL--;
   state.registers.BC--;
@@ -120,13 +181,13 @@ inline int ldd(ProcessorState &state) {
 }
 
 // Exchange Instructions
-inline void ex_af_af(ProcessorState &state) {
+inline void ex_af_af(Z80State &state) {
   emulator_types::word temp = state.registers.AF;
   state.registers.AF = state.registers.AF_;
   state.registers.AF_ = temp;
 }
 
-inline void exx(ProcessorState &state) {
+inline void exx(Z80State &state) {
   emulator_types::word tempBC = state.registers.BC;
   emulator_types::word tempDE = state.registers.DE;
   emulator_types::word tempHL = state.registers.HL;
@@ -138,22 +199,22 @@ inline void exx(ProcessorState &state) {
   state.registers.HL_ = tempHL;
 }
 
-inline void ex_de_hl(ProcessorState &state) {
+inline void ex_de_hl(Z80State &state) {
   emulator_types::word temp = state.registers.HL;
   state.registers.HL = state.registers.DE;
   state.registers.DE = temp;
 }
 
-inline void ex_sp_hl(ProcessorState &state) {
-  emulator_types::byte l = state.memory[state.registers.SP];
-  emulator_types::byte h = state.memory[state.registers.SP + 1];
-  state.memory.fastWrite(state.registers.SP, state.registers.L);
-  state.memory.fastWrite(state.registers.SP + 1, state.registers.H);
+template <class Bus> inline void ex_sp_hl(Bus &state) {
+  emulator_types::byte l = state.read(state.registers.SP);
+  emulator_types::byte h = state.read(state.registers.SP + 1);
+  state.write(state.registers.SP, state.registers.L);
+  state.write(state.registers.SP + 1, state.registers.H);
   state.registers.H = h;
   state.registers.L = l;
 }
 
-inline void ld_sp_hl(ProcessorState &state) {
+inline void ld_sp_hl(Z80State &state) {
   state.registers.SP = state.registers.HL;
 }
 
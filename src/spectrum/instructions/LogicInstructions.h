@@ -3,110 +3,42 @@
 
 #include "../../utils/BaseTypes.h"
 #include "../ProcessorMacros.h"
-#include "../ProcessorState.h"
+#include "../Z80State.h"
+#include "FlagTables.h"
 
 namespace Logic {
 
-inline void and8(ProcessorState &state, emulator_types::byte val) {
+inline void and8(Z80State &state, emulator_types::byte val) {
   state.registers.A &= val;
-  // Flags: S, Z, H=1, P/V=Parity, N=0, C=0
-  if (state.registers.A & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-
-  if (state.registers.A == 0)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-
-  SET_FLAG(H_FLAG, state.registers); // H is set for AND
-  CLEAR_FLAG(N_FLAG, state.registers);
-  CLEAR_FLAG(C_FLAG, state.registers);
-
-  // Parity
-  int bits = 0;
-  for (int i = 0; i < 8; i++) {
-    if (state.registers.A & (1 << i))
-      bits++;
-  }
-  if (bits % 2 == 0)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
+  // Flags: S, Z, 5, 3, H=1, P/V=Parity, N=0, C=0
+  state.registers.F = H_FLAG | Flags::sz53p[state.registers.A];
 }
 
-inline void or8(ProcessorState &state, emulator_types::byte val) {
+inline void or8(Z80State &state, emulator_types::byte val) {
   state.registers.A |= val;
-  // Flags: S, Z, H=0, P/V=Parity, N=0, C=0
-  if (state.registers.A & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-
-  if (state.registers.A == 0)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-
-  CLEAR_FLAG(H_FLAG, state.registers); // H is reset for OR
-  CLEAR_FLAG(N_FLAG, state.registers);
-  CLEAR_FLAG(C_FLAG, state.registers);
-
-  // Parity
-  int bits = 0;
-  for (int i = 0; i < 8; i++) {
-    if (state.registers.A & (1 << i))
-      bits++;
-  }
-  if (bits % 2 == 0)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
+  // Flags: S, Z, 5, 3, H=0, P/V=Parity, N=0, C=0
+  state.registers.F = Flags::sz53p[state.registers.A];
 }
 
-inline void xor8(ProcessorState &state, emulator_types::byte val) {
+inline void xor8(Z80State &state, emulator_types::byte val) {
   state.registers.A ^= val;
-  // Flags: S, Z, H=0, P/V=Parity, N=0, C=0
-  if (state.registers.A & 0x80)
-    SET_FLAG(S_FLAG, state.registers);
-  else
-    CLEAR_FLAG(S_FLAG, state.registers);
-
-  if (state.registers.A == 0)
-    SET_FLAG(Z_FLAG, state.registers);
-  else
-    CLEAR_FLAG(Z_FLAG, state.registers);
-
-  CLEAR_FLAG(H_FLAG, state.registers); // H is reset for XOR
-  CLEAR_FLAG(N_FLAG, state.registers);
-  CLEAR_FLAG(C_FLAG, state.registers);
-
-  // Parity
-  int bits = 0;
-  for (int i = 0; i < 8; i++) {
-    if (state.registers.A & (1 << i))
-      bits++;
-  }
-  if (bits % 2 == 0)
-    SET_FLAG(P_FLAG, state.registers);
-  else
-    CLEAR_FLAG(P_FLAG, state.registers);
+  // Flags: S, Z, 5, 3, H=0, P/V=Parity, N=0, C=0
+  state.registers.F = Flags::sz53p[state.registers.A];
 }
 
-inline void cpl(ProcessorState &state) {
+inline void cpl(Z80State &state) {
   state.registers.A = ~state.registers.A;
   SET_FLAG(H_FLAG, state.registers);
   SET_FLAG(N_FLAG, state.registers);
 }
 
-inline void scf(ProcessorState &state) {
+inline void scf(Z80State &state) {
   SET_FLAG(C_FLAG, state.registers);
   CLEAR_FLAG(H_FLAG, state.registers);
   CLEAR_FLAG(N_FLAG, state.registers);
 }
 
-inline void ccf(ProcessorState &state) {
+inline void ccf(Z80State &state) {
   bool c = GET_FLAG(C_FLAG, state.registers);
   if (c)
     SET_FLAG(H_FLAG, state.registers);
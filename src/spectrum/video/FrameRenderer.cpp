@@ -0,0 +1,261 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameRenderer.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FRAME_RENDERER_SSE2
+#endif
+
+FrameRenderer::FrameRenderer() {
+  // Base colours (Bright 0) then bright (Bright 1)
+  const std::uint8_t levels[2] = {205, 255};
+  for (int bright = 0; bright < 2; bright++) {
+    for (int colour = 0; colour < 8; colour++) {
+      std::uint8_t on = levels[bright];
+      palette[bright * 8 + colour] = rgba(colour & 2 ? on : 0,  // Red
+                                          colour & 4 ? on : 0,  // Green
+                                          colour & 1 ? on : 0); // Blue
+    }
+  }
+
+  for (int y = 0; y < VIEWPORT_HEIGHT; y++)
+    lineOfRow[VideoBuffer::encodeAddress(0, y) / BYTES_PER_ROW] = y;
+
+  // Decode Attribute: F B PPP III
+  for (int attr = 0; attr < 256; attr++) {
+    int bright = (attr & 0x40) ? 8 : 0;
+    Pixel inkColour = palette[(attr & 0x07) + bright];
+    Pixel paperColour = palette[((attr >> 3) & 0x07) + bright];
+    bool flash = (attr & 0x80) != 0;
+    ink[0][attr] = inkColour;
+    paper[0][attr] = paperColour;
+    ink[1][attr] = flash ? paperColour : inkColour;
+    paper[1][attr] = flash ? inkColour : paperColour;
+  }
+
+  // MSB is left pixel
+  for (int value = 0; value < 256; value++)
+    for (int bit = 0; bit < 8; bit++)
+      masks[value][bit] = (value & (0x80 >> bit)) ? 0xFFFFFFFF : 0;
+}
+
+FrameRenderer::Pixel FrameRenderer::rgba(std::uint8_t r, std::uint8_t g,
+                                         std::uint8_t b, std::uint8_t a) {
+  const std::uint8_t bytes[4] = {r, g, b, a};
+  Pixel pixel;
+  memcpy(&pixel, bytes, sizeof(pixel));
+  return pixel;
+}
+
+namespace {
+
+/**
+ * Write 8 pixels, ink where the mask is set and paper elsewhere
+ */
+inline void expand(const FrameRenderer::Pixel *mask,
+                   FrameRenderer::Pixel inkColour,
+                   FrameRenderer::Pixel paperColour,
+                   FrameRenderer::Pixel *out) {
+#if defined(__AVX2__)
+  __m256i paper = _mm256_set1_epi32((int)paperColour);
+  __m256i diff = _mm256_set1_epi32((int)(inkColour ^ paperColour));
+  __m256i bits = _mm256_load_si256((const __m256i *)mask);
+  _mm256_storeu_si256(
+      (__m256i *)out,
+      _mm256_xor_si256(paper, _mm256_and_si256(diff, bits)));
+#elif defined(FRAME_RENDERER_SSE2)
+  __m128i paper = _mm_set1_epi32((int)paperColour);
+  __m128i diff = _mm_set1_epi32((int)(inkColour ^ paperColour));
+  __m128i left = _mm_load_si128((const __m128i *)mask);
+  __m128i right = _mm_load_si128((const __m128i *)(mask + 4));
+  _mm_storeu_si128((__m128i *)out,
+                   _mm_xor_si128(paper, _mm_and_si128(diff, left)));
+  _mm_storeu_si128((__m128i *)(out + 4),
+                   _mm_xor_si128(paper, _mm_and_si128(diff, right)));
+#else
+  FrameRenderer::Pixel diff = inkColour ^ paperColour;
+  for (int i = 0; i < 8; i++)
+    out[i] = paperColour ^ (diff & mask[i]);
+#endif
+}
+
+} // namespace
+
+/**
+ * Work out the colour of each group of 8 border pixels from the frame's
+ * border changes
+ * @param frame the frame to draw
+ * @param colours set to the colour of each group, display ones included
+ */
+void FrameRenderer::resolveBorder(
+    const VideoFrame &frame,
+    emulator_types::byte (&colours)[FULL_HEIGHT][BORDER_COLUMNS]) {
+  const std::vector<BorderEvent> &events = frame.borderEvents;
+  if (events.empty()) {
+    memset(colours, frame.borderColor, sizeof(colours));
+    return;
+  }
+
+  // The beam meets the groups in time order, as are the changes
+  size_t next = 0;
+  emulator_types::byte colour = frame.borderColor;
+  for (int y = 0; y < FULL_HEIGHT; y++) {
+    int tStates = tStatesAt(frame, 0, y);
+    for (int column = 0; column < BORDER_COLUMNS; column++, tStates += 4) {
+      while (next < events.size() && events[next].tStates <= tStates)
+        colour = events[next++].colour;
+      colours[y][column] = colour;
+    }
+  }
+}
+
+/**
+ * Draw the border of one line of the full frame
+ * @param colours the colour of each group of 8 pixels on the line
+ * @param y the line
+ * @param pixels the full frame
+ */
+void FrameRenderer::drawBorder(const emulator_types::byte *colours, int y,
+                               Pixel *pixels) const {
+  Pixel *line = pixels + y * FULL_WIDTH;
+  bool display = y >= BORDER_WIDTH && y < BORDER_WIDTH + VIEWPORT_HEIGHT;
+  for (int column = 0; column < BORDER_COLUMNS; column++) {
+    if (display && column == BORDER_WIDTH / 8)
+      column += VIEWPORT_WIDTH / 8;
+    std::fill(line + column * 8, line + column * 8 + 8,
+              palette[colours[column]]);
+  }
+}
+
+/**
+ * Draw the border lines, then the display over them in display memory
+ * order
+ * @param frame the frame to draw
+ * @param flashInverted true in the half second flashing cells are inverted
+ * @param pixels FULL_WIDTH * FULL_HEIGHT pixels to fill
+ */
+void FrameRenderer::render(const VideoFrame &frame, bool flashInverted,
+                           Pixel *pixels) const {
+  emulator_types::byte colours[FULL_HEIGHT][BORDER_COLUMNS];
+  resolveBorder(frame, colours);
+  for (int y = 0; y < FULL_HEIGHT; y++)
+    drawBorder(colours[y], y, pixels);
+
+  const Pixel(&inkOf)[256] = ink[flashInverted];
+  const Pixel(&paperOf)[256] = paper[flashInverted];
+  const emulator_types::byte *data = frame.pixels;
+  for (int row = 0; row < VIEWPORT_HEIGHT; row++) {
+    int y = lineOfRow[row];
+    const emulator_types::byte *attrs = frame.attributes + y * BYTES_PER_ROW;
+    Pixel *out = pixels + (y + BORDER_WIDTH) * FULL_WIDTH + BORDER_WIDTH;
+    for (int x = 0; x < BYTES_PER_ROW; x++, data++, out += 8) {
+      emulator_types::byte attr = attrs[x];
+      expand(masks[*data], inkOf[attr], paperOf[attr], out);
+    }
+  }
+}
+
+/**
+ * Draw one 8x8 character cell
+ * @param frame the frame to draw
+ * @param flashInverted true in the half second flashing cells are inverted
+ * @param row character row, 0 to 23
+ * @param column character column, 0 to 31
+ * @param pixels the full frame
+ */
+void FrameRenderer::drawCell(const VideoFrame &frame, bool flashInverted,
+                             int row, int column, Pixel *pixels) const {
+  const Pixel(&inkOf)[256] = ink[flashInverted];
+  const Pixel(&paperOf)[256] = paper[flashInverted];
+
+  // The 8 lines of a cell are 256 bytes apart in display memory, and each
+  // has its own attribute
+  const emulator_types::byte *data =
+      frame.pixels + VideoBuffer::encodeAddress(column, row * 8);
+  const emulator_types::byte *attr =
+      frame.attributes + row * 8 * BYTES_PER_ROW + column;
+  Pixel *out = pixels + (row * 8 + BORDER_WIDTH) * FULL_WIDTH + BORDER_WIDTH +
+               column * 8;
+  for (int line = 0; line < 8;
+       line++, data += 256, attr += BYTES_PER_ROW, out += FULL_WIDTH)
+    expand(masks[*data], inkOf[*attr], paperOf[*attr], out);
+}
+
+/**
+ * Redraw what changed since the last frame drawn
+ * @param frame the frame to draw
+ * @param flashInverted true in the half second flashing cells are inverted
+ * @param pixels the pixels of the last frame, brought up to date
+ * @param bands set to the runs of lines changed, empty if none were
+ */
+void FrameRenderer::renderChanges(const VideoFrame &frame, bool flashInverted,
+                                  Pixel *pixels, std::vector<Band> &bands) {
+  bands.clear();
+  if (!valid) {
+    render(frame, flashInverted, pixels);
+    resolveBorder(frame, lastBorder);
+    lastFlash = flashInverted;
+    valid = true;
+    bands.push_back({0, FULL_HEIGHT});
+    return;
+  }
+
+  bool changed[FULL_HEIGHT] = {};
+  resolveBorder(frame, border);
+  for (int y = 0; y < FULL_HEIGHT; y++) {
+    if (memcmp(border[y], lastBorder[y], BORDER_COLUMNS) != 0) {
+      memcpy(lastBorder[y], border[y], BORDER_COLUMNS);
+      drawBorder(border[y], y, pixels);
+      changed[y] = true;
+    }
+  }
+
+  bool flashTurned = flashInverted != lastFlash;
+  lastFlash = flashInverted;
+  for (int row = 0; row < VIDEO_HEIGHT_CHARS; row++) {
+    std::uint32_t cells = frame.dirty.rows[row];
+    if (flashTurned) {
+      const emulator_types::byte *attrs =
+          frame.attributes + row * 8 * BYTES_PER_ROW;
+      for (int i = 0; i < 8 * BYTES_PER_ROW; i++)
+        if (attrs[i] & 0x80)
+          cells |= 1u << (i % BYTES_PER_ROW);
+    }
+    if (!cells)
+      continue;
+
+    for (int column = 0; column < BYTES_PER_ROW; column++)
+      if (cells & (1u << column))
+        drawCell(frame, flashInverted, row, column, pixels);
+    std::fill(changed + BORDER_WIDTH + row * 8,
+              changed + BORDER_WIDTH + row * 8 + 8, true);
+  }
+
+  for (int y = 0; y < FULL_HEIGHT; y++) {
+    if (!changed[y])
+      continue;
+    if (!bands.empty() && bands.back().bottom == y)
+      bands.back().bottom++;
+    else
+      bands.push_back({y, y + 1});
+  }
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_FRAMERENDERER_H
+#define ZXEMULATOR_FRAMERENDERER_H
+
+#include "VideoBuffer.h"
+#include <cstdint>
+#include <vector>
+
+#define BORDER_WIDTH 48
+
+#define VIEWPORT_WIDTH 256
+#define VIEWPORT_HEIGHT 192
+#define FULL_WIDTH (VIEWPORT_WIDTH + (BORDER_WIDTH * 2))
+#define FULL_HEIGHT (VIEWPORT_HEIGHT + (BORDER_WIDTH * 2))
+
+// The border changes colour 8 pixels at a time
+#define BORDER_COLUMNS (FULL_WIDTH / 8)
+
+/**
+ * Turns a VideoFrame into 32-bit RGBA pixels, FULL_WIDTH by FULL_HEIGHT
+ * with the border around the display.
+ *
+ * Everything per byte comes from tables: the screen line of each row of
+ * display memory, the ink and paper colours of each attribute in each
+ * flash phase, and an 8 pixel mask for each byte value. Each group of 8
+ * pixels is then paper ^ ((ink ^ paper) & mask), done with SSE2 or AVX2
+ * where the compiler targets them.
+ *
+ * The border is resolved from the frame's colour changes, each seen from
+ * the 8 pixels the beam draws after it.
+ *
+ * renderChanges() keeps the pixels of the last frame and only redraws the
+ * frame's dirty cells, flashing cells when the flash phase turns, and
+ * border lines whose colours changed.
+ */
+class FrameRenderer {
+public:
+  // A pixel as it lies in memory: R, G, B, A bytes
+  typedef std::uint32_t Pixel;
+
+  // Lines top to bottom - 1 of the full frame
+  struct Band {
+    int top;
+    int bottom;
+  };
+
+  FrameRenderer();
+
+  // Draw the frame into pixels, FULL_WIDTH * FULL_HEIGHT of them. With
+  // flashInverted set, flashing cells swap ink and paper.
+  void render(const VideoFrame &frame, bool flashInverted,
+              Pixel *pixels) const;
+
+  // Bring pixels drawn from the previous frame up to date, setting bands
+  // to the runs of lines changed. Draws everything the first time and
+  // after invalidate(), e.g. when a frame was missed.
+  void renderChanges(const VideoFrame &frame, bool flashInverted,
+                     Pixel *pixels, std::vector<Band> &bands);
+  void invalidate() { valid = false; }
+
+  Pixel getColour(int index) const { return palette[index]; }
+
+  static Pixel rgba(std::uint8_t r, std::uint8_t g, std::uint8_t b,
+                    std::uint8_t a = 255);
+
+  // Frame time the beam draws the 8 pixels holding x, y of the full frame
+  static int tStatesAt(const VideoFrame &frame, int x, int y) {
+    return frame.firstDisplayTStates + (y - BORDER_WIDTH) * frame.lineTStates +
+           (x / 8 - BORDER_WIDTH / 8) * 4;
+  }
+
+private:
+  Pixel palette[16];
+
+  // Screen line drawn from each 32 byte row of display memory
+  std::uint8_t lineOfRow[VIEWPORT_HEIGHT];
+  // Ink and paper of each attribute, by flash phase
+  Pixel ink[2][256];
+  Pixel paper[2][256];
+  // Bit set pixels of each byte value, all ones or all zeros
+  alignas(32) Pixel masks[256][8];
+
+  // What renderChanges() last drew
+  bool valid = false;
+  bool lastFlash = false;
+  emulator_types::byte lastBorder[FULL_HEIGHT][BORDER_COLUMNS];
+  emulator_types::byte border[FULL_HEIGHT][BORDER_COLUMNS];
+
+  static void
+  resolveBorder(const VideoFrame &frame,
+                emulator_types::byte (&colours)[FULL_HEIGHT][BORDER_COLUMNS]);
+  void drawBorder(const emulator_types::byte *colours, int y,
+                  Pixel *pixels) const;
+  void drawCell(const VideoFrame &frame, bool flashInverted, int row,
+                int column, Pixel *pixels) const;
+};
+
+#endif // ZXEMULATOR_FRAMERENDERER_H
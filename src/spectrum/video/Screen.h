@@ -23,20 +23,19 @@
 #define SPECTRUM_SCREEN_WIDTH_BYTES (SPECTRUM_SCREEN_WIDTH / 8)
 #define SPECTRUM_SCREEN_HEIGHT 192
 
-class Processor;
+class EmulatorThread;
+struct PresentedFrame;
 
 class Screen {
-protected:
-  VideoBuffer *videoBuffer;
-
 public:
-  virtual void init(VideoBuffer *buffer) = 0;
+  virtual void init() = 0;
   virtual void show() = 0;
   virtual void hide() = 0;
-  virtual void update() = 0;
+  virtual void update(const PresentedFrame &frame) = 0;
   virtual bool processEvents() { return true; };
 
-  virtual void setProcessor(Processor *p) {}
+  // Input and debugger commands go to the emulator
+  virtual void setEmulator(EmulatorThread *e) {}
   virtual void setDebugMode(bool debug) {}
 
   static Screen *Factory();
@@ -15,51 +15,78 @@
  */
 
 #include "VideoBuffer.h"
+#include <algorithm>
 #include <cstring>
 
 /**
- * Overlay the Video videoBuffer onto the main memory map
- * @param memoryMap A pointer to the memory map being used
+ * Overlay the Video videoBuffer onto the memory bank holding the screen
+ * @param screen A pointer to the start of the bank
  */
-VideoBuffer::VideoBuffer(emulator_types::byte *memoryMap) {
-  this->videoBuffer = memoryMap + VIDEO_PIXEL_START;
-  this->colourAttributes = memoryMap + VIDEO_ATTR_START;
+VideoBuffer::VideoBuffer(emulator_types::byte *screen) {
+  setScreen(screen);
 
   // Blank memory out
   memset(videoBuffer, 0, VIDEO_BITMAP_DATA);
   // Set attributes to White Paper (7), Black Ink (0), Bright 0, Flash 0 -> 00
   // 111 000 -> 0x38
   memset(colourAttributes, 0x38, VIDEO_ATTR_DATA);
-
-  scanlineBorderColors.resize(312, 7); // 312 lines (PAL), default white
 }
 
 void VideoBuffer::newFrame() {
-  // Fill with current border color (carry over from previous frame)
-  std::fill(scanlineBorderColors.begin(), scanlineBorderColors.end(),
-            borderColor);
+  // The border carries over from the previous frame
+  frameBorderColor = borderColor;
+  borderEvents.clear();
+  latchedLines = 0;
 }
 
-void VideoBuffer::setBorderColor(emulator_types::byte color, long tStates) {
-  borderColor = color & 0x07;
-  // 224 T-states per line
-  int line = tStates / 224;
-  if (line < 0)
-    line = 0;
-  if (line >= scanlineBorderColors.size())
+/**
+ * Copy the display lines the beam has reached since the last call, so
+ * later writes to them only show next frame
+ * @param tStates the current frame time
+ */
+void VideoBuffer::latchUntil(long tStates) {
+  if (tStates < firstDisplayTStates)
     return;
+  long due = (tStates - firstDisplayTStates) / lineTStates + 1;
+  int lines = due < VIDEO_LINES ? (int)due : VIDEO_LINES;
+  for (; latchedLines < lines; latchedLines++) {
+    int y = latchedLines;
+    emulator_types::word offset = encodeAddress(0, y);
+    memcpy(latchedPixels + offset, videoBuffer + offset, BYTES_PER_ROW);
+    memcpy(latchedAttributes + y * BYTES_PER_ROW,
+           colourAttributes + (y >> 3) * BYTES_PER_ROW, BYTES_PER_ROW);
+  }
+}
 
-  // Set from current line to end
-  std::fill(scanlineBorderColors.begin() + line, scanlineBorderColors.end(),
-            borderColor);
+/**
+ * @param tStates set to the frame time of the next line to latch
+ * @return false once every display line is latched
+ */
+bool VideoBuffer::nextLineTime(int &tStates) const {
+  if (latchedLines >= VIDEO_LINES)
+    return false;
+  tStates = firstDisplayTStates + latchedLines * lineTStates;
+  return true;
 }
 
-emulator_types::byte VideoBuffer::getBorderColorAtLine(int line) const {
-  if (line < 0)
-    return scanlineBorderColors[0];
-  if (line >= scanlineBorderColors.size())
-    return scanlineBorderColors.back();
-  return scanlineBorderColors[line];
+/**
+ * Note a border change. The border is drawn 8 pixels, 4 T-states, at a
+ * time, so only the last change before each group shows.
+ * @param color the new colour
+ * @param tStates the frame time of the change
+ */
+void VideoBuffer::setBorderColor(emulator_types::byte color, long tStates) {
+  color &= 0x07;
+  if (color == borderColor)
+    return;
+  borderColor = color;
+
+  // First frame time of a group of 8 pixels drawn in the new colour
+  int shown = (int)((tStates + 3) & ~3L);
+  if (!borderEvents.empty() && borderEvents.back().tStates >= shown)
+    borderEvents.back().colour = color;
+  else
+    borderEvents.push_back({shown, color});
 }
 
 /**
@@ -119,6 +146,28 @@ emulator_types::byte VideoBuffer::getAttribute(int x, int y) const {
   return colourAttributes[offset];
 }
 
+/**
+ * Copy the display lines and border lines into a frame: the lines latched
+ * as the beam passed them, and memory as it is now for the rest
+ * @param frame the frame to fill
+ */
+void VideoBuffer::copyTo(VideoFrame &frame) const {
+  for (int y = 0; y < VIDEO_LINES; y++) {
+    emulator_types::word offset = encodeAddress(0, y);
+    bool latched = y < latchedLines;
+    memcpy(frame.pixels + offset,
+           (latched ? latchedPixels : videoBuffer) + offset, BYTES_PER_ROW);
+    memcpy(frame.attributes + y * BYTES_PER_ROW,
+           latched ? latchedAttributes + y * BYTES_PER_ROW
+                   : colourAttributes + (y >> 3) * BYTES_PER_ROW,
+           BYTES_PER_ROW);
+  }
+  frame.borderColor = frameBorderColor;
+  frame.borderEvents.assign(borderEvents.begin(), borderEvents.end());
+  frame.firstDisplayTStates = firstDisplayTStates;
+  frame.lineTStates = lineTStates;
+}
+
 /**
  * Override the [] operator to allow direct access the the video videoBuffer
  * @param index
@@ -139,7 +188,7 @@ emulator_types::byte &VideoBuffer::operator[](int index) {
  * @param y Y Position
  * @return The address offset of the given x,y coordinates
  */
-emulator_types::word VideoBuffer::encodeAddress(int x, int y) const {
+emulator_types::word VideoBuffer::encodeAddress(int x, int y) {
   emulator_types::word address = 0x00;
   // copy X bits X0-X4 to 0-4 in the address
   address |= (x & 0b11111);
@@ -18,6 +18,9 @@
 #define ZXEMULATOR_VIDEOBUFFER_H
 
 #include "../../utils/BaseTypes.h"
+#include "../MachineModel.h"
+#include <cstdint>
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -26,6 +29,7 @@
 #define VIDEO_ATTR_START 0x5800 // Start of the attribute data
 #define VIDEO_BITMAP_DATA 6144  // Number of bytes of bitmap data
 #define VIDEO_ATTR_DATA 768     // NUmber of bytes of colour data
+#define VIDEO_DATA (VIDEO_BITMAP_DATA + VIDEO_ATTR_DATA)
 #define VIDEO_WIDTH_CHARS 32    // Width of the attribute character map
 #define VIDEO_HEIGHT_CHARS 24   // Height of the attribute character map
 
@@ -42,43 +46,151 @@
  * https://www.overtakenbyevents.com/lets-talk-about-the-zx-specrum-screen-layout/#:~:text=The%20spectrum's%20screen%20memory%20starts,32%20bytes%20by%20192%20rows).
  */
 #define BYTES_PER_ROW 32
+#define VIDEO_LINES 192 // Display lines
+
+#define VIDEO_PIXEL_END VIDEO_ATTR_START
+#define VIDEO_ATTR_END (VIDEO_ATTR_START + VIDEO_ATTR_DATA)
+
+struct VideoFrame;
+
+// A change of border colour, seen from the given frame time on
+struct BorderEvent {
+  int tStates;
+  emulator_types::byte colour;
+};
+
+/**
+ * The 8x8 character cells changed since the last frame, a bit per column
+ * in a word per character row
+ */
+struct DirtyCells {
+  std::uint32_t rows[VIDEO_HEIGHT_CHARS];
+
+  DirtyCells() { setAll(); }
+
+  // Character row shown by a byte of display memory, 0x4000 to 0x5AFF
+  static int rowOf(long address) {
+    long offset = address - VIDEO_PIXEL_START;
+    if (address < VIDEO_PIXEL_END)
+      return ((offset >> 11) << 3) | ((offset >> 5) & 0x07); // Y7 Y6 Y5 Y4 Y3
+    return (offset - VIDEO_BITMAP_DATA) >> 5;
+  }
+
+  void setAll() { std::fill(rows, rows + VIDEO_HEIGHT_CHARS, 0xFFFFFFFF); }
+  void clear() { std::fill(rows, rows + VIDEO_HEIGHT_CHARS, 0); }
+
+  // Mark the cell shown by a byte of display memory, 0x4000 to 0x5AFF
+  void mark(long address) {
+    rows[rowOf(address)] |= 1u << ((address - VIDEO_PIXEL_START) & 0x1F);
+  }
+};
 
 class VideoBuffer {
 private:
   emulator_types::byte *videoBuffer;
   emulator_types::byte *colourAttributes;
   emulator_types::byte borderColor = 7; // Default white border
-  std::vector<emulator_types::byte> scanlineBorderColors;
+  emulator_types::byte frameBorderColor = 7; // Border as the frame started
+  std::vector<BorderEvent> borderEvents;      // Changes this frame
+
+  // Display lines latched as the beam reached them this frame, with the
+  // attributes each was drawn with
+  emulator_types::byte latchedPixels[VIDEO_BITMAP_DATA];
+  emulator_types::byte latchedAttributes[VIDEO_LINES * BYTES_PER_ROW];
+  int latchedLines = 0;
+
+  // When the beam reaches the display, a 48K's until set
+  int firstDisplayTStates = Spectrum48K::FIRST_DISPLAY_TSTATES;
+  int lineTStates = Spectrum48K::LINE_TSTATES;
 
-  emulator_types::word encodeAddress(int x, int y) const;
   void printBits(std::string msg, size_t const size,
                  void const *const ptr) const;
 
 public:
-  explicit VideoBuffer(emulator_types::byte *memoryMap);
+  explicit VideoBuffer(emulator_types::byte *screen);
+
+  // Show the screen held at the start of another bank
+  void setScreen(emulator_types::byte *screen) {
+    videoBuffer = screen;
+    colourAttributes = screen + VIDEO_BITMAP_DATA;
+  }
 
   emulator_types::byte getByte(int x, int y) const;
   void setByte(int x, int y, emulator_types::byte);
   emulator_types::byte getAttribute(int x, int y) const;
 
+  // Set the border for the whole frame, e.g. from a snapshot
   void setBorderColor(emulator_types::byte color) {
     borderColor = color & 0x07;
-    // Fallback: fill all?
-    std::fill(scanlineBorderColors.begin(), scanlineBorderColors.end(),
-              borderColor);
+    frameBorderColor = borderColor;
+    borderEvents.clear();
+  }
+
+  // Time the beam to a machine model
+  template <class Model> void setTiming() {
+    firstDisplayTStates = Model::FIRST_DISPLAY_TSTATES;
+    lineTStates = Model::LINE_TSTATES;
   }
+  int getFirstDisplayTStates() const { return firstDisplayTStates; }
+  int getLineTStates() const { return lineTStates; }
 
+  // Change the border at a frame time, as an OUT to the ULA does
   void setBorderColor(emulator_types::byte color, long tStates);
   void newFrame();
 
+  // Latch every display line the beam has started by the given frame time.
+  // Lines not latched by the end of the frame are taken from memory.
+  void latchUntil(long tStates);
+  // Frame time the beam starts the next line to latch, if any is left
+  bool nextLineTime(int &tStates) const;
+  // True once the beam has started drawing the cell at a display address,
+  // so a write there is only seen next frame
+  bool isLatched(long address) const {
+    return DirtyCells::rowOf(address) * 8 < latchedLines;
+  }
+
   emulator_types::byte getBorderColor() const { return borderColor; }
-  emulator_types::byte getBorderColorAtLine(int line) const;
 
   // Override operators
   emulator_types::byte &operator[](int index);
 
   // Get a pointer to the start of the requested row
   emulator_types::byte *getBuffer() const { return videoBuffer; };
+
+  // Copy the display for drawing on another thread
+  void copyTo(VideoFrame &frame) const;
+
+  static emulator_types::word encodeAddress(int x, int y);
+};
+
+/**
+ * A finished frame: the display bytes, the attributes each display line was
+ * drawn with and the border changes in time order, as copied out of the
+ * VideoBuffer at the frame end.
+ */
+struct VideoFrame {
+  emulator_types::byte pixels[VIDEO_BITMAP_DATA];
+  emulator_types::byte attributes[VIDEO_LINES * BYTES_PER_ROW];
+  emulator_types::byte borderColor = 7; // Border as the frame started
+  std::vector<BorderEvent> borderEvents;
+  // Beam timing of the machine that drew it
+  int firstDisplayTStates = Spectrum48K::FIRST_DISPLAY_TSTATES;
+  int lineTStates = Spectrum48K::LINE_TSTATES;
+  // Cells whose pixels or attributes changed since the last frame
+  DirtyCells dirty;
+
+  emulator_types::byte getByte(int x, int y) const {
+    return pixels[VideoBuffer::encodeAddress(x, y)];
+  }
+  emulator_types::byte getAttribute(int x, int y) const {
+    return attributes[y * BYTES_PER_ROW + x];
+  }
+  emulator_types::byte getBorderColorAt(int tStates) const {
+    auto next = std::upper_bound(
+        borderEvents.begin(), borderEvents.end(), tStates,
+        [](int t, const BorderEvent &event) { return t < event.tStates; });
+    return next == borderEvents.begin() ? borderColor : (next - 1)->colour;
+  }
 };
 
 #endif // ZXEMULATOR_VIDEOBUFFER_H
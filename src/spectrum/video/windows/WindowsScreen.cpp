@@ -20,42 +20,13 @@
 #include <cstdio>
 
 #include "../../../utils/FileDialog.h"
-#include "../../../utils/PeriodTimer.h"
 #include "../../../utils/ResourceUtils.h"
-#include "../../Processor.h"
-#include "../../SnapshotLoader.h"
 #include "WindowsScreen.h"
 
-using namespace std::chrono;
-
-static const int numberOfRows = 192;
-static const int bytesPerRow = 32;
-
-WindowsScreen::WindowsScreen() : sprite(texture) {
-  // Base colors (Bright 0)
-  colors[0] = sf::Color(0, 0, 0);       // Black
-  colors[1] = sf::Color(0, 0, 205);     // Blue
-  colors[2] = sf::Color(205, 0, 0);     // Red
-  colors[3] = sf::Color(205, 0, 205);   // Magenta
-  colors[4] = sf::Color(0, 205, 0);     // Green
-  colors[5] = sf::Color(0, 205, 205);   // Cyan
-  colors[6] = sf::Color(205, 205, 0);   // Yellow
-  colors[7] = sf::Color(205, 205, 205); // White
-
-  // Bright colors (Bright 1)
-  colors[8] = sf::Color(0, 0, 0);        // Black
-  colors[9] = sf::Color(0, 0, 255);      // Bright Blue
-  colors[10] = sf::Color(255, 0, 0);     // Bright Red
-  colors[11] = sf::Color(255, 0, 255);   // Bright Magenta
-  colors[12] = sf::Color(0, 255, 0);     // Bright Green
-  colors[13] = sf::Color(0, 255, 255);   // Bright Cyan
-  colors[14] = sf::Color(255, 255, 0);   // Bright Yellow
-  colors[15] = sf::Color(255, 255, 255); // Bright White
-}
+WindowsScreen::WindowsScreen() : sprite(texture) {}
 
-void WindowsScreen::init(VideoBuffer *buffer) {
+void WindowsScreen::init() {
   printf("Init window()\n");
-  this->videoBuffer = buffer;
 
   // Create the texture and assign it to a scaled sprite
   // Note: Sprite is already bound to texture in constructor
@@ -100,143 +71,40 @@ void WindowsScreen::show() {
 void WindowsScreen::hide() { printf("Hide window()\n"); }
 
 /**
- * Redraw the screen from the Video buffer
- * The way we do this read the video memory and draw to a byte buffer
- * (screenBuffer) The byte buffer is copied to a sprint texture which is then
- * copied to the window The window copy is scaled to increase its size
+ * Redraw the screen from a finished frame
+ * The frame's changes are rendered to a pixel buffer and the changed bands
+ * of lines copied to the sprite's texture. The sprite is scaled up to fill
+ * the window. A frame with no changes costs nothing.
+ * @param frame the frame to show, kept for the debugger until the next one
  */
-void WindowsScreen::update() {
+void WindowsScreen::update(const PresentedFrame &frame) {
+  this->frame = &frame;
+
   // Update Flash Counter (0-31), toggles every 16 frames
   flashFrameCounter = (flashFrameCounter + 1) % 32;
 
-  // printf("Starting frame update\n");
-
-  // Start a timer
-  PeriodTimer timer;
-  timer.start();
-
-  // Redraw the double buffer
-  std::uint8_t *currentPixelPtr = pixelBuffer;
-  int bufferRow = 0;
+  // The dirty cells are only those since the previous frame
+  if (frame.number != lastFrameNumber + 1)
+    renderer.invalidate();
+  lastFrameNumber = frame.number;
 
-  // Loop through drawing all the rows of the screen
-  for (int y = 0; y < FULL_HEIGHT; y++) {
-    if ((y < BORDER_WIDTH) || (y >= (FULL_HEIGHT - BORDER_WIDTH))) {
-      // Draw the top and bottom borders
-      drawBorderRow(&currentPixelPtr, y);
-    } else {
-      // Draw a row from the video buffer
-      // y is absolute screen y. Need relative y for video buffer (0-191)
-      int videoY = y - BORDER_WIDTH;
-      drawRow(&currentPixelPtr, videoY, y); // Pass absolute y too
-    }
-
-    // screenBufferPtr += BYTES_PER_ROW;
+  renderer.renderChanges(frame.video, flashFrameCounter >= 16, pixelBuffer,
+                         bands);
+  if (bands.empty() && !exposed)
+    return;
+  exposed = false;
+
+  for (const FrameRenderer::Band &band : bands) {
+    texture.update(
+        reinterpret_cast<const std::uint8_t *>(pixelBuffer +
+                                               band.top * FULL_WIDTH),
+        sf::Vector2u(FULL_WIDTH, band.bottom - band.top),
+        sf::Vector2u(0, band.top));
   }
 
-  texture.update(pixelBuffer);
-  // Debug attribute at 0,0 (Top Left)
-  // printf("Attribute(0,0): %02X\n", videoBuffer->getAttribute(0, 0));
-
   theWindow.clear(sf::Color::Black);
   theWindow.draw(sprite);
-
-  theWindow.draw(sprite);
-
   theWindow.display();
-
-  // Get starting timepoint
-  // printf("Finished frame update - execution %ld microseconds\n",
-  // timer.stop());
-}
-
-// processEvents moved to bottom
-// bool WindowsScreen::processEvents() { ... }
-
-/**
- * Draw a full border row for use at the top and bottom on the screen
- * May not be needed when I sort it all out
- * @param pixels
- * @return
- */
-void WindowsScreen::drawBorderRow(std::uint8_t **pixels, int y) const {
-  byte borderIdx = (*videoBuffer).getBorderColorAtLine(y);
-  sf::Color borderColour = colors[borderIdx];
-
-  for (int x = 0; x < FULL_WIDTH; x++) {
-    setPixel(pixels, borderColour);
-  }
-}
-
-/**
- * Draw a single row from the screen buffer including the pre and post borders
- * @param pixels
- * @param y
- * @return
- */
-void WindowsScreen::drawRow(std::uint8_t **pixels, int y, int absY) const {
-  byte borderIdx = (*videoBuffer).getBorderColorAtLine(absY);
-  sf::Color borderColour = colors[borderIdx];
-
-  // Draw the left border
-  for (int i = 0; i < BORDER_WIDTH; i++) {
-    setPixel(pixels, borderColour);
-  }
-
-  for (int x = 0; x < VIEWPORT_WIDTH / 8; x++) {
-    byte data = (*videoBuffer).getByte(x, y);
-    byte attr = (*videoBuffer).getAttribute(x, y);
-
-    // Decode Attribute: F B PPP III
-    int brightIdx = (attr & 0x40) ? 8 : 0;
-    int paperIdx = ((attr >> 3) & 0x07) + brightIdx;
-    int inkIdx = (attr & 0x07) + brightIdx;
-
-    sf::Color paperColor = colors[paperIdx];
-    sf::Color inkColor = colors[inkIdx];
-
-    // Handle Flash (Bit 7)
-    if ((attr & 0x80) && (flashFrameCounter >= 16)) {
-      std::swap(paperColor, inkColor);
-    }
-
-    for (int bits = 0; bits < 8; bits++) {
-      // MSB is left pixel
-      bool pixelSet = (data & (0x80 >> bits)) != 0;
-      sf::Color colour = pixelSet ? inkColor : paperColor;
-      setPixel(pixels, colour);
-    }
-  }
-
-  // Draw the right border
-  for (int i = 0; i < BORDER_WIDTH; i++) {
-    setPixel(pixels, borderColour);
-  }
-}
-
-/**
- * Draw the border pixels into the buffer
- * @param pixel
- * @param colour
- */
-void WindowsScreen::drawBorder(std::uint8_t **pixel, sf::Color colour) const {
-  for (int x = 0; x < BORDER_WIDTH; x++) {
-    setPixel(pixel, colour);
-  }
-}
-
-/**
- * Set the colour of a specific pixel
- * @param pixel
- * @param colour
- */
-void WindowsScreen::setPixel(std::uint8_t **pixel, sf::Color colour) const {
-  std::uint8_t *&ptr = *pixel;
-  // printf("Colour : %d\n" , colour.toInteger());
-  *(ptr++) = colour.r;
-  *(ptr++) = colour.g;
-  *(ptr++) = colour.b;
-  *(ptr++) = colour.a;
 }
 
 void WindowsScreen::waitForEvent() {
@@ -265,7 +133,9 @@ void WindowsScreen::drawDebugWindow() {
 
   debugWindow.clear(sf::Color(50, 50, 50));
 
-  ProcessorState &state = processor->getState();
+  if (!frame)
+    return;
+  const Z80Registers &registers = frame->registers;
 
   char buffer[256];
   sf::Text text(debugFont);
@@ -276,17 +146,18 @@ void WindowsScreen::drawDebugWindow() {
   // Registers
   snprintf(buffer, sizeof(buffer),
            "A: %02X  F: %02X\nBC: %04X\nDE: %04X\nHL: %04X\nSP: %04X\nPC: "
-           "%04X\n\nFlags: %c%c%c%c%c%c%c%c",
-           state.registers.A, state.registers.F, state.registers.BC,
-           state.registers.DE, state.registers.HL, state.registers.SP,
-           state.registers.PC, (state.registers.F & 0x80) ? 'S' : '-',
-           (state.registers.F & 0x40) ? 'Z' : '-',
-           (state.registers.F & 0x20) ? '5' : '-',
-           (state.registers.F & 0x10) ? 'H' : '-',
-           (state.registers.F & 0x08) ? '3' : '-',
-           (state.registers.F & 0x04) ? 'P' : '-',
-           (state.registers.F & 0x02) ? 'N' : '-',
-           (state.registers.F & 0x01) ? 'C' : '-');
+           "%04X\n\nFlags: %c%c%c%c%c%c%c%c\n\nIdle skipped: %ld T",
+           registers.A, registers.F, registers.BC,
+           registers.DE, registers.HL, registers.SP,
+           registers.PC, (registers.F & 0x80) ? 'S' : '-',
+           (registers.F & 0x40) ? 'Z' : '-',
+           (registers.F & 0x20) ? '5' : '-',
+           (registers.F & 0x10) ? 'H' : '-',
+           (registers.F & 0x08) ? '3' : '-',
+           (registers.F & 0x04) ? 'P' : '-',
+           (registers.F & 0x02) ? 'N' : '-',
+           (registers.F & 0x01) ? 'C' : '-',
+           frame->idleTStatesSkipped);
   text.setString(buffer);
   debugWindow.draw(text);
 
@@ -294,8 +165,8 @@ void WindowsScreen::drawDebugWindow() {
   sf::Text statusText(debugFont);
   statusText.setCharacterSize(14);
   statusText.setPosition({200, 180});
-  if (processor->isRunning()) {
-    if (processor->isPaused()) {
+  if (frame->running) {
+    if (frame->paused) {
       statusText.setString("Status: PAUSED");
       statusText.setFillColor(sf::Color::Yellow);
     } else {
@@ -308,12 +179,12 @@ void WindowsScreen::drawDebugWindow() {
   }
   debugWindow.draw(statusText);
 
-  if (!processor->getLastError().empty()) {
+  if (!frame->lastError.empty()) {
     sf::Text errorText(debugFont);
     errorText.setCharacterSize(12);
     errorText.setFillColor(sf::Color::Red);
     errorText.setPosition({10, 250});
-    errorText.setString("Error: " + processor->getLastError());
+    errorText.setString("Error: " + frame->lastError);
     debugWindow.draw(errorText);
   }
 
@@ -324,7 +195,7 @@ void WindowsScreen::drawDebugWindow() {
   btnText.setCharacterSize(16);
   btnText.setPosition({10, 200});
 
-  if (processor->isPaused()) {
+  if (frame->paused) {
     btnText.setString("[RESUME]");
     btnText.setFillColor(sf::Color::Green);
     btnText.setPosition({10, 200});
@@ -340,6 +211,20 @@ void WindowsScreen::drawDebugWindow() {
     btnText.setPosition({210, 200});
     debugWindow.draw(btnText);
 
+    btnText.setString("[OVER]");
+    btnText.setPosition({10, 225});
+    debugWindow.draw(btnText);
+
+    btnText.setString("[OUT]");
+    btnText.setPosition({130, 225});
+    debugWindow.draw(btnText);
+
+    // Toggles a breakpoint where execution has stopped
+    btnText.setString(breakpoints.count(registers.PC) ? "[UNBREAK]"
+                                                      : "[BREAK]");
+    btnText.setPosition({210, 225});
+    debugWindow.draw(btnText);
+
   } else {
     btnText.setString("[PAUSE]");
     btnText.setFillColor(sf::Color::Red); // Changed from Red to be consistent?
@@ -359,6 +244,9 @@ bool WindowsScreen::processEvents() {
       if (debugWindow.isOpen())
         debugWindow.close();
       return false;
+    } else if (event->is<sf::Event::Resized>() ||
+               event->is<sf::Event::FocusGained>()) {
+      exposed = true;
     } else if (const auto *keyPressed = event->getIf<sf::Event::KeyPressed>()) {
       handleKey(keyPressed->code, true);
     } else if (const auto *keyReleased =
@@ -376,23 +264,23 @@ bool WindowsScreen::processEvents() {
       // Axis 0 = X, Axis 1 = Y
       // Kempston: 0=Right, 1=Left, 2=Down, 3=Up
       if (joyMove->axis == sf::Joystick::Axis::X) {
-        processor->getState().keyboard.setKempstonKey(0, joyMove->position >
+        setKempstonKey(0, joyMove->position >
                                                              50.0f);
-        processor->getState().keyboard.setKempstonKey(1, joyMove->position <
+        setKempstonKey(1, joyMove->position <
                                                              -50.0f);
       } else if (joyMove->axis == sf::Joystick::Axis::Y) {
-        processor->getState().keyboard.setKempstonKey(2, joyMove->position >
+        setKempstonKey(2, joyMove->position >
                                                              50.0f);
-        processor->getState().keyboard.setKempstonKey(3, joyMove->position <
+        setKempstonKey(3, joyMove->position <
                                                              -50.0f);
       }
     } else if (const auto *joyBtnPress =
                    event->getIf<sf::Event::JoystickButtonPressed>()) {
       // Map any button to Fire (Bit 4)
-      processor->getState().keyboard.setKempstonKey(4, true);
+      setKempstonKey(4, true);
     } else if (const auto *joyBtnRelease =
                    event->getIf<sf::Event::JoystickButtonReleased>()) {
-      processor->getState().keyboard.setKempstonKey(4, false);
+      setKempstonKey(4, false);
     } else if (const auto *joyConnect =
                    event->getIf<sf::Event::JoystickConnected>()) {
       handleJoystickConnect(true, joyConnect->joystickId);
@@ -408,40 +296,54 @@ bool WindowsScreen::processEvents() {
       if (event->is<sf::Event::Closed>()) {
         showDebug = false;
         debugWindow.close();
-        if (processor)
-          processor->resume();
+        sendCommand(EmulatorCommand::DEBUG_MODE, false);
+        sendCommand(EmulatorCommand::RESUME);
       }
       // Simple click handling for buttons
       else if (const auto *mouseButton =
                    event->getIf<sf::Event::MouseButtonPressed>()) {
         if (mouseButton->button == sf::Mouse::Button::Left) {
-          printf("Debug Win Click: %d, %d. Processor: %p\n",
-                 mouseButton->position.x, mouseButton->position.y,
-                 (void *)processor);
+          printf("Debug Win Click: %d, %d\n", mouseButton->position.x,
+                 mouseButton->position.y);
+          int x = mouseButton->position.x;
           int y = mouseButton->position.y;
-          if (y > 190 && y < 230) { // Rough button area
-            if (processor) {
-              if (processor->isPaused()) {
-                // Resume or Step?
-                // Resume or Step?
-                if (mouseButton->position.x < 120) {
+          if (y > 190 && y < 250) { // Rough button area
+            if (emulator && frame) {
+              if (frame->paused && y < 220) {
+                // Resume, Step or Reset
+                if (x < 120) {
                   printf("Resume requested\n");
-                  processor->resume();
-                } else if (mouseButton->position.x >= 120 &&
-                           mouseButton->position.x < 200) {
+                  sendCommand(EmulatorCommand::RESUME);
+                } else if (x < 200) {
                   printf("Step requested\n");
-                  processor->step();
-                } else if (mouseButton->position.x >= 200) {
+                  sendCommand(EmulatorCommand::STEP);
+                } else {
                   printf("Reset requested\n");
-                  processor->reset();
-                  processor->pause();
+                  sendCommand(EmulatorCommand::RESET);
+                }
+              } else if (frame->paused) {
+                // Step over, Step out or toggle a breakpoint at PC
+                word pc = frame->registers.PC;
+                if (x < 120) {
+                  printf("Step over requested\n");
+                  sendCommand(EmulatorCommand::STEP_OVER);
+                } else if (x < 200) {
+                  printf("Step out requested\n");
+                  sendCommand(EmulatorCommand::STEP_OUT);
+                } else if (breakpoints.erase(pc)) {
+                  printf("Breakpoint cleared at %04X\n", pc);
+                  sendCommand(EmulatorCommand::BREAKPOINT, false, pc);
+                } else {
+                  printf("Breakpoint set at %04X\n", pc);
+                  breakpoints.insert(pc);
+                  sendCommand(EmulatorCommand::BREAKPOINT, true, pc);
                 }
               } else {
                 printf("Pause requested\n");
-                processor->pause();
+                sendCommand(EmulatorCommand::PAUSE);
               }
             } else {
-              printf("Error: Processor is null\n");
+              printf("Error: Emulator is null\n");
             }
           }
         }
@@ -462,166 +364,169 @@ void WindowsScreen::handleJoystickConnect(bool connected, unsigned int id) {
 }
 
 void WindowsScreen::handleKey(sf::Keyboard::Key key, bool pressed) {
-  if (!processor)
+  if (!emulator)
     return;
 
   // Kempston Joystick Mapping
   // Right (0), Left (1), Down (2), Up (3), Fire (4)
   if (key == sf::Keyboard::Key::Right)
-    processor->getState().keyboard.setKempstonKey(0, pressed);
+    setKempstonKey(0, pressed);
   if (key == sf::Keyboard::Key::Left)
-    processor->getState().keyboard.setKempstonKey(1, pressed);
+    setKempstonKey(1, pressed);
   if (key == sf::Keyboard::Key::Down)
-    processor->getState().keyboard.setKempstonKey(2, pressed);
+    setKempstonKey(2, pressed);
   if (key == sf::Keyboard::Key::Up)
-    processor->getState().keyboard.setKempstonKey(3, pressed);
+    setKempstonKey(3, pressed);
   if (key == sf::Keyboard::Key::LAlt || key == sf::Keyboard::Key::RAlt ||
       key == sf::Keyboard::Key::RControl)
-    processor->getState().keyboard.setKempstonKey(4, pressed);
+    setKempstonKey(4, pressed);
 
   // F5 = Save Snapshot
   if (key == sf::Keyboard::Key::F5 && pressed) {
     std::string path =
         utils::FileDialog::saveFile("Save Snapshot", "snapshot.sna");
     if (!path.empty()) {
-      SnapshotLoader::exportSNA(path.c_str(), processor->getState());
+      EmulatorCommand command;
+      command.type = EmulatorCommand::SAVE_SNAPSHOT;
+      command.path = std::make_shared<const std::string>(path);
+      emulator->send(command);
     }
   }
 
   // Mapping
   // Line 0 (0xFE): SHIFT (0), Z (1), X (2), C (3), V (4)
   if (key == sf::Keyboard::Key::LShift || key == sf::Keyboard::Key::RShift)
-    processor->getState().keyboard.setKey(0, 0, pressed);
+    setKey(0, 0, pressed);
   if (key == sf::Keyboard::Key::Z)
-    processor->getState().keyboard.setKey(0, 1, pressed);
+    setKey(0, 1, pressed);
   if (key == sf::Keyboard::Key::X)
-    processor->getState().keyboard.setKey(0, 2, pressed);
+    setKey(0, 2, pressed);
   if (key == sf::Keyboard::Key::C)
-    processor->getState().keyboard.setKey(0, 3, pressed);
+    setKey(0, 3, pressed);
   if (key == sf::Keyboard::Key::V)
-    processor->getState().keyboard.setKey(0, 4, pressed);
+    setKey(0, 4, pressed);
 
   // Line 1 (0xFD): A (0), S (1), D (2), F (3), G (4)
   if (key == sf::Keyboard::Key::A)
-    processor->getState().keyboard.setKey(1, 0, pressed);
+    setKey(1, 0, pressed);
   if (key == sf::Keyboard::Key::S)
-    processor->getState().keyboard.setKey(1, 1, pressed);
+    setKey(1, 1, pressed);
   if (key == sf::Keyboard::Key::D)
-    processor->getState().keyboard.setKey(1, 2, pressed);
+    setKey(1, 2, pressed);
   if (key == sf::Keyboard::Key::F)
-    processor->getState().keyboard.setKey(1, 3, pressed);
+    setKey(1, 3, pressed);
   if (key == sf::Keyboard::Key::G)
-    processor->getState().keyboard.setKey(1, 4, pressed);
+    setKey(1, 4, pressed);
 
   // Line 2 (0xFB): Q (0), W (1), E (2), R (3), T (4)
   if (key == sf::Keyboard::Key::Q)
-    processor->getState().keyboard.setKey(2, 0, pressed);
+    setKey(2, 0, pressed);
   if (key == sf::Keyboard::Key::W)
-    processor->getState().keyboard.setKey(2, 1, pressed);
+    setKey(2, 1, pressed);
   if (key == sf::Keyboard::Key::E)
-    processor->getState().keyboard.setKey(2, 2, pressed);
+    setKey(2, 2, pressed);
   if (key == sf::Keyboard::Key::R)
-    processor->getState().keyboard.setKey(2, 3, pressed);
+    setKey(2, 3, pressed);
   if (key == sf::Keyboard::Key::T)
-    processor->getState().keyboard.setKey(2, 4, pressed);
+    setKey(2, 4, pressed);
 
   // Line 3 (0xF7): 1 (0), 2 (1), 3 (2), 4 (3), 5 (4)
   if (key == sf::Keyboard::Key::Num1 || key == sf::Keyboard::Key::Numpad1)
-    processor->getState().keyboard.setKey(3, 0, pressed);
+    setKey(3, 0, pressed);
   if (key == sf::Keyboard::Key::Num2 || key == sf::Keyboard::Key::Numpad2) {
     bool shift = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LShift) ||
                  sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RShift);
     if (pressed) {
       if (shift) {
         // Shift + 2 = " (UK Layout) -> Symbol Shift + P
-        processor->getState().keyboard.setKey(7, 1, true);  // Symbol Shift
-        processor->getState().keyboard.setKey(5, 0, true);  // P
-        processor->getState().keyboard.setKey(0, 0, false); // Caps Shift OFF
+        setKey(7, 1, true);  // Symbol Shift
+        setKey(5, 0, true);  // P
+        setKey(0, 0, false); // Caps Shift OFF
       } else {
-        processor->getState().keyboard.setKey(3, 1, true); // 2
+        setKey(3, 1, true); // 2
       }
     } else {
-      processor->getState().keyboard.setKey(3, 1, false); // 2
-      processor->getState().keyboard.setKey(5, 0, false); // P
+      setKey(3, 1, false); // 2
+      setKey(5, 0, false); // P
 
       // Restore states based on physical keys
       bool ctrl = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LControl) ||
                   sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RControl);
       if (!ctrl)
-        processor->getState().keyboard.setKey(7, 1, false);
+        setKey(7, 1, false);
 
       if (shift)
-        processor->getState().keyboard.setKey(0, 0, true);
+        setKey(0, 0, true);
     }
   }
   if (key == sf::Keyboard::Key::Num3 || key == sf::Keyboard::Key::Numpad3)
-    processor->getState().keyboard.setKey(3, 2, pressed);
+    setKey(3, 2, pressed);
   if (key == sf::Keyboard::Key::Num4 || key == sf::Keyboard::Key::Numpad4)
-    processor->getState().keyboard.setKey(3, 3, pressed);
+    setKey(3, 3, pressed);
   if (key == sf::Keyboard::Key::Num5 || key == sf::Keyboard::Key::Numpad5)
-    processor->getState().keyboard.setKey(3, 4, pressed);
+    setKey(3, 4, pressed);
 
   // Line 4 (0xEF): 0 (0), 9 (1), 8 (2), 7 (3), 6 (4)
   if (key == sf::Keyboard::Key::Num0 || key == sf::Keyboard::Key::Numpad0)
-    processor->getState().keyboard.setKey(4, 0, pressed);
+    setKey(4, 0, pressed);
   if (key == sf::Keyboard::Key::Num9 || key == sf::Keyboard::Key::Numpad9)
-    processor->getState().keyboard.setKey(4, 1, pressed);
+    setKey(4, 1, pressed);
   if (key == sf::Keyboard::Key::Num8 || key == sf::Keyboard::Key::Numpad8)
-    processor->getState().keyboard.setKey(4, 2, pressed);
+    setKey(4, 2, pressed);
   if (key == sf::Keyboard::Key::Num7 || key == sf::Keyboard::Key::Numpad7)
-    processor->getState().keyboard.setKey(4, 3, pressed);
+    setKey(4, 3, pressed);
   if (key == sf::Keyboard::Key::Num6 || key == sf::Keyboard::Key::Numpad6)
-    processor->getState().keyboard.setKey(4, 4, pressed);
+    setKey(4, 4, pressed);
 
   // Line 5 (0xDF): P (0), O (1), I (2), U (3), Y (4)
   if (key == sf::Keyboard::Key::P)
-    processor->getState().keyboard.setKey(5, 0, pressed);
+    setKey(5, 0, pressed);
   if (key == sf::Keyboard::Key::O)
-    processor->getState().keyboard.setKey(5, 1, pressed);
+    setKey(5, 1, pressed);
   if (key == sf::Keyboard::Key::I)
-    processor->getState().keyboard.setKey(5, 2, pressed);
+    setKey(5, 2, pressed);
   if (key == sf::Keyboard::Key::U)
-    processor->getState().keyboard.setKey(5, 3, pressed);
+    setKey(5, 3, pressed);
   if (key == sf::Keyboard::Key::Y)
-    processor->getState().keyboard.setKey(5, 4, pressed);
+    setKey(5, 4, pressed);
 
   // Line 6 (0xBF): ENTER (0), L (1), K (2), J (3), H (4)
   if (key == sf::Keyboard::Key::Enter)
-    processor->getState().keyboard.setKey(6, 0, pressed);
+    setKey(6, 0, pressed);
   if (key == sf::Keyboard::Key::L)
-    processor->getState().keyboard.setKey(6, 1, pressed);
+    setKey(6, 1, pressed);
   if (key == sf::Keyboard::Key::K)
-    processor->getState().keyboard.setKey(6, 2, pressed);
+    setKey(6, 2, pressed);
   if (key == sf::Keyboard::Key::J)
-    processor->getState().keyboard.setKey(6, 3, pressed);
+    setKey(6, 3, pressed);
   if (key == sf::Keyboard::Key::H)
-    processor->getState().keyboard.setKey(6, 4, pressed);
+    setKey(6, 4, pressed);
 
   // Line 7 (0x7F): SPACE (0), SYM (1), M (2), N (3), B (4)
   if (key == sf::Keyboard::Key::Space)
-    processor->getState().keyboard.setKey(7, 0, pressed);
+    setKey(7, 0, pressed);
   if (key == sf::Keyboard::Key::LControl || key == sf::Keyboard::Key::RControl)
-    processor->getState().keyboard.setKey(
+    setKey(
         7, 1,
         pressed); // Symbol Shift mapped to Ctrl
   if (key == sf::Keyboard::Key::M)
-    processor->getState().keyboard.setKey(7, 2, pressed);
+    setKey(7, 2, pressed);
   if (key == sf::Keyboard::Key::N)
-    processor->getState().keyboard.setKey(7, 3, pressed);
+    setKey(7, 3, pressed);
   if (key == sf::Keyboard::Key::B)
-    processor->getState().keyboard.setKey(7, 4, pressed);
+    setKey(7, 4, pressed);
 
   // Special Keys
   // Delete (Shift + 0)
   if (key == sf::Keyboard::Key::Backspace) {
-    processor->getState().keyboard.setKey(0, 0, pressed); // Shift
-    processor->getState().keyboard.setKey(4, 0, pressed); // 0
+    setKey(0, 0, pressed); // Shift
+    setKey(4, 0, pressed); // 0
   }
 
   // Extended Mode Shortcut (Left Alt / Option) -> Caps Shift + Symbol Shift
   if (key == sf::Keyboard::Key::LAlt || key == sf::Keyboard::Key::RAlt) {
-    processor->getState().keyboard.setKey(0, 0, pressed); // Caps Shift
-    processor->getState().keyboard.setKey(7, 1, pressed); // Symbol Shift
+    setKey(0, 0, pressed); // Caps Shift
+    setKey(7, 1, pressed); // Symbol Shift
   }
 
   // Quote handling (" and ')
@@ -645,39 +550,78 @@ void WindowsScreen::handleKey(sf::Keyboard::Key key, bool pressed) {
     mapSymbol(pressed, 0, 4, 0, 3); // V (/), C (?)
 }
 
+/**
+ * Queue a key change for the emulator
+ * @param line keyboard half-row
+ * @param bit key within the half-row
+ * @param pressed true if pressed
+ */
+void WindowsScreen::setKey(int line, int bit, bool pressed) {
+  if (!emulator)
+    return;
+  EmulatorCommand command;
+  command.line = line;
+  command.bit = bit;
+  command.pressed = pressed;
+  emulator->send(command);
+}
+
+void WindowsScreen::setKempstonKey(int bit, bool pressed) {
+  if (!emulator)
+    return;
+  EmulatorCommand command;
+  command.type = EmulatorCommand::KEMPSTON;
+  command.bit = bit;
+  command.pressed = pressed;
+  emulator->send(command);
+}
+
+void WindowsScreen::sendCommand(EmulatorCommand::Type type, bool pressed,
+                                int line) {
+  if (!emulator)
+    return;
+  EmulatorCommand command;
+  command.type = type;
+  command.pressed = pressed;
+  command.line = line;
+  emulator->send(command);
+}
+
 void WindowsScreen::mapSymbol(bool pressed, int unshiftedLine, int unshiftedBit,
                               int shiftedLine, int shiftedBit) {
-  if (!processor)
+  if (!emulator)
     return;
 
   bool shift = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LShift) ||
                sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RShift);
 
   // Symbol Shift always needed for both
-  processor->getState().keyboard.setKey(7, 1, pressed);
+  setKey(7, 1, pressed);
 
   if (pressed) {
     if (shift) {
-      processor->getState().keyboard.setKey(shiftedLine, shiftedBit, true);
+      setKey(shiftedLine, shiftedBit, true);
       // Force Caps Shift OFF to enable symbol mode without Extended Mode
-      processor->getState().keyboard.setKey(0, 0, false);
+      setKey(0, 0, false);
     } else {
-      processor->getState().keyboard.setKey(unshiftedLine, unshiftedBit, true);
+      setKey(unshiftedLine, unshiftedBit, true);
     }
   } else {
     // RELEASE: Release BOTH to ensure no keys stuck if Shift changed state
-    processor->getState().keyboard.setKey(shiftedLine, shiftedBit, false);
-    processor->getState().keyboard.setKey(unshiftedLine, unshiftedBit, false);
+    setKey(shiftedLine, shiftedBit, false);
+    setKey(unshiftedLine, unshiftedBit, false);
 
     // Restore Caps Shift if it is physically held
     if (shift) {
-      processor->getState().keyboard.setKey(0, 0, true);
+      setKey(0, 0, true);
     }
   }
 }
 
 void WindowsScreen::setDebugMode(bool debug) {
   showDebug = debug;
+  // The emulator only runs the slower, hooked loop while the window is up
+  sendCommand(EmulatorCommand::DEBUG_MODE, debug);
   if (showDebug) {
     if (!debugWindow.isOpen()) {
       debugWindow.create(sf::VideoMode({400, 300}), "Debugger");
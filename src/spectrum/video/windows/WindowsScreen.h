@@ -17,6 +17,7 @@
 #ifndef ZXEMULATOR_WINDOWSSCREEN_H
 #define ZXEMULATOR_WINDOWSSCREEN_H
 
+#include "../FrameRenderer.h"
 #include "../Screen.h"
 #include <SFML/Graphics/Font.hpp>
 #include <SFML/Graphics/RectangleShape.hpp>
@@ -26,16 +27,12 @@
 #include <SFML/Graphics/Texture.hpp>
 #include <SFML/Window.hpp>
 #include <cstdint>
+#include <set>
+#include <vector>
 
 #define WINDOW_SCALE 2
-#define BORDER_WIDTH 48
 
-#define VIEWPORT_WIDTH (SPECTRUM_SCREEN_WIDTH)
-#define VIEWPORT_HEIGHT (SPECTRUM_SCREEN_HEIGHT)
-#define FULL_WIDTH (VIEWPORT_WIDTH + (BORDER_WIDTH * 2))
-#define FULL_HEIGHT (VIEWPORT_HEIGHT + (BORDER_WIDTH * 2))
-
-class Processor;
+#include "../../../frontend/EmulatorThread.h"
 
 /**
  *
@@ -45,22 +42,23 @@ private:
   sf::RenderWindow theWindow;
   sf::Texture texture;
   sf::Sprite sprite;
-  std::uint8_t *pixelBuffer =
-      new std::uint8_t[FULL_WIDTH * FULL_HEIGHT *
-                       4]; // * 4 because pixelBuffer have 4 components (RGBA)
+  FrameRenderer renderer;
+  FrameRenderer::Pixel *pixelBuffer =
+      new FrameRenderer::Pixel[FULL_WIDTH * FULL_HEIGHT];
 
-  sf::Color colors[16];
+  std::vector<FrameRenderer::Band> bands;
+  long lastFrameNumber = 0;
+  bool exposed = true; // Window needs drawing even if the frame didn't change
   int flashFrameCounter = 0;
 
-  void drawRow(unsigned char **pixels, int y, int absY) const;
-
-  void setPixel(unsigned char **pixel, sf::Color colour) const;
-
-  void drawBorderRow(unsigned char **pixels, int y) const;
-
-  void drawBorder(unsigned char **pixel, sf::Color colour) const;
+  // The frame being shown, owned by the emulator's triple buffer
+  const PresentedFrame *frame = nullptr;
 
   void handleKey(sf::Keyboard::Key key, bool pressed);
+  void setKey(int line, int bit, bool pressed);
+  void setKempstonKey(int bit, bool pressed);
+  void sendCommand(EmulatorCommand::Type type, bool pressed = false,
+                   int line = 0);
   void mapSymbol(bool pressed, int unshiftedLine, int unshiftedBit,
                  int shiftedLine, int shiftedBit);
   void handleJoystickConnect(bool connected, unsigned int id);
@@ -69,16 +67,17 @@ public:
   sf::RenderWindow debugWindow;
   sf::Font debugFont;
   bool showDebug = false;
-  Processor *processor = nullptr;
+  std::set<emulator_types::word> breakpoints; // As sent to the emulator
+  EmulatorThread *emulator = nullptr;
 
   void drawDebugWindow();
   void initDebug();
 
 public:
   WindowsScreen();
-  void init(VideoBuffer *buffer) override;
+  void init() override;
 
-  void update() override;
+  void update(const PresentedFrame &frame) override;
 
   void show() override;
 
@@ -87,7 +86,7 @@ public:
   bool processEvents() override;
   void waitForEvent();
 
-  void setProcessor(Processor *p) override { processor = p; };
+  void setEmulator(EmulatorThread *e) override { emulator = e; };
   void setDebugMode(bool debug) override;
 };
 
@@ -0,0 +1,81 @@
+#include "../spectrum/Audio.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+class CaptureSink : public AudioSink {
+public:
+  std::vector<std::int16_t> samples;
+
+  void write(const std::int16_t *data, std::size_t count) override {
+    samples.insert(samples.end(), data, data + count);
+  }
+};
+
+} // namespace
+
+// One edge mid-frame settles on the new level either side of the kernel,
+// with only the small overshoot of a band-limited step
+TEST(AudioTest, EdgeRendersAsBandLimitedStep) {
+  CaptureSink sink;
+  Audio audio(sink);
+  std::vector<AudioEdge> edges = {{Spectrum48K::FRAME_TSTATES / 2, 20000}};
+  audio.renderFrame(edges, Spectrum48K::FRAME_TSTATES);
+
+  ASSERT_EQ(sink.samples.size(), (size_t)Audio::SAMPLES_PER_FRAME);
+  EXPECT_TRUE(edges.empty());
+
+  const int edge = Audio::SAMPLES_PER_FRAME / 2;
+  EXPECT_EQ(sink.samples[edge - 2], 0);
+  EXPECT_EQ(sink.samples[edge + Audio::KERNEL_WIDTH + 2], 20000);
+  EXPECT_EQ(sink.samples.back(), 20000);
+  auto [low, high] =
+      std::minmax_element(sink.samples.begin(), sink.samples.end());
+  EXPECT_GT(*low, -2000);
+  EXPECT_LT(*high, 22000);
+}
+
+// An edge from an instruction overrunning the frame end sounds in the next
+// frame, and a step's tail carries over with it
+TEST(AudioTest, OverrunEdgesCarryToNextFrame) {
+  CaptureSink sink;
+  Audio audio(sink);
+  std::vector<AudioEdge> edges = {{Spectrum48K::FRAME_TSTATES - 10, 8000},
+                                  {Spectrum48K::FRAME_TSTATES + 20, 28000}};
+  audio.renderFrame(edges, Spectrum48K::FRAME_TSTATES + 23);
+
+  ASSERT_EQ(edges.size(), 1u);
+  EXPECT_EQ(edges[0].tStates, 20);
+  EXPECT_LT(sink.samples.back(), 8000); // still rising, half a kernel late
+
+  edges.push_back({Spectrum48K::FRAME_TSTATES / 2, 0});
+  audio.renderFrame(edges, Spectrum48K::FRAME_TSTATES);
+  ASSERT_EQ(sink.samples.size(), 2u * Audio::SAMPLES_PER_FRAME);
+  EXPECT_EQ(sink.samples[Audio::SAMPLES_PER_FRAME + Audio::KERNEL_WIDTH + 2],
+            28000);
+  EXPECT_EQ(sink.samples.back(), 0);
+}
+
+// A square wave well below Nyquist keeps its level between edges, so the
+// samples average to half the level over whole cycles
+TEST(AudioTest, SquareWaveAveragesToHalfLevel) {
+  CaptureSink sink;
+  Audio audio(sink);
+  const int period = 3500; // 1kHz
+  for (int frame = 0; frame < 2; frame++) {
+    std::vector<AudioEdge> edges;
+    for (int t = 0; t < Spectrum48K::FRAME_TSTATES; t += period / 2)
+      edges.push_back({t, (std::int16_t)((t / (period / 2)) % 2 ? 0 : 20000)});
+    audio.renderFrame(edges, Spectrum48K::FRAME_TSTATES);
+  }
+
+  // Whole cycles from the second frame, which starts on a cycle boundary
+  long total = 0;
+  int count = 0;
+  for (size_t i = Audio::SAMPLES_PER_FRAME + Audio::KERNEL_WIDTH;
+       i + 44 <= sink.samples.size(); i++, count++)
+    total += sink.samples[i];
+  EXPECT_NEAR((double)total / count, 10000, 300);
+}
@@ -0,0 +1,102 @@
+#include "../batch/BatchJob.h"
+#include "../batch/WorkStealingPool.h"
+#include <atomic>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <thread>
+
+TEST(BatchTest, PoolRunsEveryTaskOnce) {
+  std::vector<std::atomic<int>> counts(500);
+  std::vector<WorkStealingPool::Task> tasks;
+  for (auto &count : counts)
+    tasks.push_back([&count]() { count++; });
+
+  WorkStealingPool pool(4);
+  pool.run(std::move(tasks));
+
+  for (auto &count : counts)
+    EXPECT_EQ(count, 1);
+}
+
+TEST(BatchTest, ParseManifestLine) {
+  BatchJob job = BatchJob::parse("game.tzx frames=200 input=keys.txt");
+  EXPECT_EQ(job.tape, "game.tzx");
+  EXPECT_TRUE(job.snapshot.empty());
+  EXPECT_EQ(job.frames, 200);
+  EXPECT_EQ(job.input, "keys.txt");
+  EXPECT_EQ(job.rom, "roms/48k.bin");
+  EXPECT_EQ(job.name, "game.tzx");
+
+  EXPECT_THROW(BatchJob::parse("frames=ten"), std::runtime_error);
+  EXPECT_THROW(BatchJob::parse("colour=red"), std::runtime_error);
+}
+
+// Jobs share nothing but the ROM, so the same job gives the same result
+// whichever thread runs it
+TEST(BatchTest, JobsAreDeterministicAcrossThreads) {
+  Rom rom("roms/48k.bin");
+  BatchJob job = BatchJob::parse("frames=100");
+
+  std::vector<BatchResult> results(8);
+  std::vector<WorkStealingPool::Task> tasks;
+  for (auto &result : results)
+    tasks.push_back([&result, &job, &rom]() { result = job.run(rom); });
+  WorkStealingPool(4).run(std::move(tasks));
+
+  for (const BatchResult &result : results) {
+    EXPECT_TRUE(result.error.empty()) << result.error;
+    EXPECT_EQ(result.frames, 100);
+    EXPECT_EQ(result.screenHash, results[0].screenHash);
+    EXPECT_EQ(result.registers, results[0].registers);
+    EXPECT_EQ(result.tStates, results[0].tStates);
+  }
+  EXPECT_GE(results[0].tStates, 100L * 69888);
+}
+
+// A key held in the input script reaches the keyboard
+TEST(BatchTest, InputScriptPressesKeys) {
+  const char *script = "batch_test_keys.txt";
+  FILE *file = fopen(script, "w");
+  ASSERT_NE(file, nullptr);
+  fprintf(file, "150 P down\n155 P up\n");
+  fclose(file);
+
+  Rom rom("roms/48k.bin");
+  BatchResult idle = BatchJob::parse("frames=200").run(rom);
+  BatchResult typed =
+      BatchJob::parse(std::string("frames=200 input=") + script).run(rom);
+  remove(script);
+
+  EXPECT_TRUE(typed.error.empty()) << typed.error;
+  EXPECT_NE(typed.screenHash, idle.screenHash); // PRINT on the edit line
+}
+
+// The wav key records the beeper, 882 samples a frame, with the header
+// sizes filled in when the job finishes
+TEST(BatchTest, WavKeyRecordsAudio) {
+  const char *wav = "batch_test_audio.wav";
+  Rom rom("roms/48k.bin");
+  BatchResult result =
+      BatchJob::parse(std::string("frames=50 wav=") + wav).run(rom);
+  EXPECT_TRUE(result.error.empty()) << result.error;
+
+  FILE *file = fopen(wav, "rb");
+  ASSERT_NE(file, nullptr);
+  unsigned char header[44];
+  ASSERT_EQ(fread(header, 1, sizeof header, file), sizeof header);
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  remove(wav);
+
+  auto read32 = [&header](int at) {
+    return header[at] | header[at + 1] << 8 | header[at + 2] << 16 |
+           (unsigned)header[at + 3] << 24;
+  };
+  EXPECT_EQ(std::string((char *)header, 4), "RIFF");
+  EXPECT_EQ(std::string((char *)header + 8, 8), "WAVEfmt ");
+  EXPECT_EQ(read32(24), 44100u);
+  EXPECT_EQ(read32(4), (unsigned)size - 8);
+  EXPECT_EQ(read32(40), (unsigned)size - 44);
+  EXPECT_NEAR(read32(40) / 2.0, 50 * 882, 1);
+}
@@ -0,0 +1,101 @@
+#include "../spectrum/FlatBus.h"
+#include "../spectrum/OpcodeTables.h"
+#include "../spectrum/Processor.h"
+#include "../spectrum/instructions/LoadInstructions.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+// 8000: LD IX, 0x9000
+//       LD HL, 0x1234
+//       LD B, 0x20
+// 8009: LD (IX+0), L
+//       RLC (IX+0)
+//       ADC HL, BC
+//       INC IX
+//       DJNZ 0x8009
+//       LD HL, 0x9000
+//       LD DE, 0x9100
+//       LD BC, 0x0020
+//       LDIR
+//       HALT
+static const std::vector<byte> program = {
+    0xDD, 0x21, 0x00, 0x90, 0x21, 0x34, 0x12, 0x06, 0x20, 0xDD, 0x75,
+    0x00, 0xDD, 0xCB, 0x00, 0x06, 0xED, 0x4A, 0xDD, 0x23, 0x10, 0xF3,
+    0x21, 0x00, 0x90, 0x11, 0x00, 0x91, 0x01, 0x20, 0x00, 0xED, 0xB0,
+    0x76};
+
+// Run until HALT, returning the T-states taken
+template <class Bus> static long runToHalt(Bus &bus) {
+  long tStates = 0;
+  for (int i = 0; i < 10000 && !bus.isHalted(); i++)
+    tStates += Opcodes::step(bus);
+  return tStates;
+}
+
+// The same handlers instantiated for two buses give the same results
+TEST(BusTest, FlatBusMatchesSpectrumBus) {
+  Processor processor;
+  ProcessorState &spectrum = processor.getState();
+  FlatBus flat;
+  for (size_t i = 0; i < program.size(); i++) {
+    spectrum.write(0x8000 + i, program[i]);
+    flat.write(0x8000 + i, program[i]);
+  }
+  spectrum.registers = flat.registers = Z80Registers();
+  spectrum.registers.PC = flat.registers.PC = 0x8000;
+  spectrum.registers.SP = flat.registers.SP = 0xFF00;
+
+  long expected = runToHalt(spectrum);
+  long actual = runToHalt(flat);
+
+  ASSERT_TRUE(flat.isHalted());
+  EXPECT_EQ(actual, expected);
+  EXPECT_EQ(flat.registers.PC, spectrum.registers.PC);
+  EXPECT_EQ(flat.registers.AF, spectrum.registers.AF);
+  EXPECT_EQ(flat.registers.BC, spectrum.registers.BC);
+  EXPECT_EQ(flat.registers.DE, spectrum.registers.DE);
+  EXPECT_EQ(flat.registers.HL, spectrum.registers.HL);
+  EXPECT_EQ(flat.registers.IX, spectrum.registers.IX);
+  EXPECT_EQ(flat.registers.R, spectrum.registers.R);
+  for (word address = 0x9000; address < 0x9140; address++)
+    ASSERT_EQ(flat.read(address), spectrum.read(address)) << "at " << address;
+}
+
+// A CP/M harness: BDOS calls are trapped at 0x0005 and a jump to 0x0000
+// ends the program
+TEST(BusTest, FlatBusRunsCpmProgram) {
+  // 0100: LD DE, 0x010D
+  //       LD C, 9
+  //       OUT (0x12), A
+  //       CALL 5
+  //       JP 0
+  // 010D: "Hi$"
+  const std::vector<byte> cpm = {0x11, 0x0D, 0x01, 0x0E, 0x09, 0xD3,
+                                 0x12, 0xCD, 0x05, 0x00, 0xC3, 0x00,
+                                 0x00, 'H',  'i',  '$'};
+  FlatBus bus;
+  for (size_t i = 0; i < cpm.size(); i++)
+    bus.write(0x0100 + i, cpm[i]);
+  bus.registers.PC = 0x0100;
+  bus.registers.SP = 0xF000;
+  bus.registers.A = 0x55;
+
+  std::string output;
+  for (int i = 0; i < 100 && bus.registers.PC != 0x0000; i++) {
+    if (bus.registers.PC == 0x0005) {
+      if (bus.registers.C == 9) {
+        for (word p = bus.registers.DE; bus.read(p) != '$'; p++)
+          output += (char)bus.read(p);
+      }
+      bus.registers.PC = Load::pop16(bus);
+      continue;
+    }
+    Opcodes::step(bus);
+  }
+
+  EXPECT_EQ(output, "Hi");
+  EXPECT_EQ(bus.portWrites, 1u);
+  EXPECT_EQ(bus.lastPort, 0x5512);
+  EXPECT_EQ(bus.lastOutput, 0x55);
+}
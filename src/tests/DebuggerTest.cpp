@@ -0,0 +1,113 @@
+#include "../spectrum/Processor.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+// 8000: LD A, 1
+//       CALL 0x9000
+// 8005: OUT (0xFE), A
+// 8007: JR 0x8007
+// 9000: LD (0xA000), A
+//       RET
+class DebuggerTest : public ::testing::Test {
+protected:
+  Processor processor;
+  ProcessorState &state = processor.getState();
+  Debugger &debugger = processor.getDebugger();
+
+  void SetUp() override {
+    processor.setTurbo(true);
+    const std::vector<byte> main = {0x3E, 0x01, 0xCD, 0x00, 0x90,
+                                    0xD3, 0xFE, 0x18, 0xFE};
+    const std::vector<byte> routine = {0x32, 0x00, 0xA0, 0xC9};
+    for (size_t i = 0; i < main.size(); i++)
+      state.memory.fastWrite(0x8000 + i, main[i]);
+    for (size_t i = 0; i < routine.size(); i++)
+      state.memory.fastWrite(0x9000 + i, routine[i]);
+    state.registers.PC = 0x8000;
+    state.registers.SP = 0xF000;
+  }
+};
+
+// The fast loop has no hooks; the debug loop stops before a breakpoint and
+// carries on from it, and the rest of the frame, when resumed
+TEST_F(DebuggerTest, BreakpointsOnlyInDebugMode) {
+  debugger.setBreakpoint(0x8005);
+  processor.executeFrame();
+  EXPECT_FALSE(processor.isPaused());
+  EXPECT_EQ(state.registers.PC, 0x8007);
+
+  state.registers.PC = 0x8000;
+  processor.setDebugMode(true);
+  processor.executeFrame();
+  ASSERT_TRUE(processor.isPaused());
+  EXPECT_EQ(state.registers.PC, 0x8005);
+  EXPECT_EQ(debugger.getStop().reason, Debugger::StopReason::BREAKPOINT);
+  long stoppedAt = state.getFrameTStates();
+  EXPECT_LT(stoppedAt, 100);
+
+  // Nothing runs while paused
+  processor.executeFrame();
+  EXPECT_EQ(state.registers.PC, 0x8005);
+
+  processor.resume();
+  processor.executeFrame();
+  EXPECT_FALSE(processor.isPaused());
+  EXPECT_EQ(state.registers.PC, 0x8007);
+  EXPECT_GE(state.getFrameTStates(), Spectrum48K::FRAME_TSTATES);
+}
+
+TEST_F(DebuggerTest, WatchpointsStopAfterTheAccess) {
+  processor.setDebugMode(true);
+  debugger.watchMemory(0xA000, Debugger::WRITE);
+  debugger.watchPort(0x0001, 0x0000, Debugger::WRITE); // The ULA
+
+  processor.executeFrame();
+  ASSERT_TRUE(processor.isPaused());
+  EXPECT_EQ(debugger.getStop().reason, Debugger::StopReason::MEMORY_WRITE);
+  EXPECT_EQ(debugger.getStop().address, 0xA000);
+  EXPECT_EQ(state.registers.PC, 0x9003);
+  EXPECT_EQ(state.memory.fastRead(0xA000), 0x01);
+
+  processor.resume();
+  processor.executeFrame();
+  ASSERT_TRUE(processor.isPaused());
+  EXPECT_EQ(debugger.getStop().reason, Debugger::StopReason::PORT_OUT);
+  EXPECT_EQ(debugger.getStop().address, 0x01FE);
+  EXPECT_EQ(state.registers.PC, 0x8007);
+
+  // With nothing to stop it the frame runs on to the end
+  debugger.clear();
+  processor.resume();
+  processor.executeFrame();
+  EXPECT_FALSE(processor.isPaused());
+}
+
+TEST_F(DebuggerTest, StepOverAndOut) {
+  processor.pause();
+  processor.step(); // LD A, 1
+  processor.executeFrame();
+  EXPECT_EQ(state.registers.PC, 0x8002);
+
+  processor.stepOver(); // The whole CALL
+  processor.executeFrame();
+  EXPECT_TRUE(processor.isPaused());
+  EXPECT_EQ(state.registers.PC, 0x8005);
+  EXPECT_EQ(state.registers.SP, 0xF000);
+  EXPECT_EQ(state.memory.fastRead(0xA000), 0x01);
+
+  // Into the routine and back out of it
+  state.registers.PC = 0x8002;
+  processor.step();
+  processor.executeFrame();
+  EXPECT_EQ(state.registers.PC, 0x9000);
+  processor.stepOut();
+  processor.executeFrame();
+  EXPECT_TRUE(processor.isPaused());
+  EXPECT_EQ(state.registers.PC, 0x8005);
+  EXPECT_EQ(debugger.getStop().reason, Debugger::StopReason::STEP);
+
+  // Anything else steps over as a single step
+  processor.stepOver();
+  processor.executeFrame();
+  EXPECT_EQ(state.registers.PC, 0x8007);
+}
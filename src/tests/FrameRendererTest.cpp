@@ -0,0 +1,147 @@
+#include "../spectrum/Memory.h"
+#include "../spectrum/Processor.h"
+#include "../spectrum/video/FrameRenderer.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+// Only writes that change a screen byte mark its cell
+TEST(FrameRendererTest, DirtyCellsFollowWrites) {
+  Memory memory;
+  memory.clearDirtyCells();
+
+  memory.fastWrite(0x4800 + 0x0700 + 0x20 * 3 + 5, 0xFF); // line 95, column 5
+  memory.fastWrite(0x5800 + 32 * 20 + 31, 0x47);          // row 20, column 31
+  memory.fastWrite(0x4801, memory.fastRead(0x4801));      // no change
+  memory.fastWrite(0x5B00, 0x12);                         // past the screen
+
+  DirtyCells expected;
+  expected.clear();
+  expected.rows[11] = 1u << 5;
+  expected.rows[20] = 1u << 31;
+  for (int row = 0; row < VIDEO_HEIGHT_CHARS; row++)
+    EXPECT_EQ(memory.getDirtyCells().rows[row], expected.rows[row]) << row;
+}
+
+// Drawing only the changes gives the same pixels as drawing everything,
+// through screen writes, border changes and the flash turning
+TEST(FrameRendererTest, RenderChangesMatchesFullRender) {
+  Memory memory;
+  VideoBuffer &video = *memory.getVideoBuffer();
+  std::mt19937 rng(7);
+  FrameRenderer renderer;
+  std::vector<FrameRenderer::Pixel> full(FULL_WIDTH * FULL_HEIGHT);
+  std::vector<FrameRenderer::Pixel> changes(FULL_WIDTH * FULL_HEIGHT);
+  std::vector<FrameRenderer::Band> bands;
+  VideoFrame frame;
+
+  for (int n = 0; n < 40; n++) {
+    video.newFrame();
+    if (n % 5 == 2)
+      video.setBorderColor(rng() & 7, (rng() % 312) * 224);
+    int writes = n % 7 == 3 ? 0 : rng() % 50;
+    for (int i = 0; i < writes; i++)
+      memory.fastWrite(0x4000 + rng() % 6912, rng());
+    bool flash = (n / 8) & 1;
+
+    video.copyTo(frame);
+    frame.dirty = memory.getDirtyCells();
+    memory.clearDirtyCells();
+
+    renderer.renderChanges(frame, flash, changes.data(), bands);
+    renderer.render(frame, flash, full.data());
+    ASSERT_EQ(changes, full) << "frame " << n;
+    // Nothing to do without writes, a border change (which also shows in
+    // the frame after, as the new colour fills it) or the flash turning
+    if (n > 0 && writes == 0 && n % 5 != 2 && n % 5 != 3 && n % 8 != 0) {
+      EXPECT_TRUE(bands.empty()) << "frame " << n;
+    }
+  }
+}
+
+// A write the beam has already passed shows from the next line it reaches,
+// and its cell stays dirty for the frame after
+TEST(FrameRendererTest, LatchedLinesKeepTheirAttributes) {
+  Memory memory;
+  VideoBuffer &video = *memory.getVideoBuffer();
+  video.newFrame();
+  memory.fastWrite(0x5800 + 32 * 10 + 4, 0x07);
+  video.latchUntil(video.getFirstDisplayTStates() +
+                   84 * video.getLineTStates());
+  memory.clearDirtyCells();
+  memory.fastWrite(0x5800 + 32 * 10 + 4, 0x38);
+
+  VideoFrame frame;
+  video.copyTo(frame);
+  for (int y = 80; y < 88; y++)
+    EXPECT_EQ(frame.getAttribute(4, y), y <= 84 ? 0x07 : 0x38) << y;
+
+  EXPECT_EQ(memory.getDirtyCells().rows[10], 1u << 4);
+  memory.clearDirtyCells();
+  EXPECT_EQ(memory.getDirtyCells().rows[10], 1u << 4);
+  memory.clearDirtyCells();
+  EXPECT_EQ(memory.getDirtyCells().rows[10], 0u);
+}
+
+// With beam racing each display line shows the attribute as the beam
+// reached it, without it the attribute at the frame end
+TEST(FrameRendererTest, BeamRacingLatchesEachLine) {
+  for (bool racing : {false, true}) {
+    Processor processor;
+    processor.setBeamRacing(racing);
+    ProcessorState &state = processor.getState();
+    // DI; LD HL,0x5800; loop: INC (HL); JR loop - 23 T-states a pass
+    const byte program[] = {0xF3, 0x21, 0x00, 0x58, 0x34, 0x18, 0xFD};
+    for (size_t i = 0; i < sizeof program; i++)
+      state.memory.fastWrite(0x8000 + i, program[i]);
+    state.registers.PC = 0x8000;
+    processor.executeFrame();
+
+    VideoFrame frame;
+    state.memory.getVideoBuffer()->copyTo(frame);
+    for (int y = 1; y < 8; y++) {
+      int passes =
+          (byte)(frame.getAttribute(0, y) - frame.getAttribute(0, y - 1));
+      if (racing) {
+        EXPECT_GE(passes, 9) << y;
+        EXPECT_LE(passes, 10) << y;
+      } else {
+        EXPECT_EQ(passes, 0) << y;
+      }
+    }
+  }
+}
+
+// Border writes are kept as changes, the last in each 4 T-states counting,
+// and drawn from the 8 pixels the beam reaches next
+TEST(FrameRendererTest, BorderChangesMidLine) {
+  Memory memory;
+  VideoBuffer &video = *memory.getVideoBuffer();
+  video.setBorderColor(1);
+  video.newFrame();
+
+  // Line 20 of the top border, 10 groups in
+  VideoFrame frame;
+  int tStates = FrameRenderer::tStatesAt(frame, 80, 20);
+  video.setBorderColor(1, tStates - 5); // no change
+  video.setBorderColor(2, tStates - 3);
+  video.setBorderColor(3, tStates - 2);
+  video.setBorderColor(4, tStates - 1);
+  video.setBorderColor(5, tStates + 1);
+
+  video.copyTo(frame);
+  ASSERT_EQ(frame.borderEvents.size(), 2u);
+  EXPECT_EQ(frame.borderEvents[0].tStates, tStates);
+  EXPECT_EQ(frame.borderEvents[0].colour, 4);
+
+  FrameRenderer renderer;
+  std::vector<FrameRenderer::Pixel> pixels(FULL_WIDTH * FULL_HEIGHT);
+  renderer.render(frame, false, pixels.data());
+  const FrameRenderer::Pixel *line = pixels.data() + 20 * FULL_WIDTH;
+  EXPECT_EQ(line[79], renderer.getColour(1));
+  EXPECT_EQ(line[80], renderer.getColour(4));
+  EXPECT_EQ(line[87], renderer.getColour(4));
+  EXPECT_EQ(line[88], renderer.getColour(5));
+  EXPECT_EQ(pixels[21 * FULL_WIDTH], renderer.getColour(5));
+  EXPECT_EQ(pixels[19 * FULL_WIDTH + 100], renderer.getColour(1));
+}
@@ -60,8 +60,8 @@ TEST_F(InstructionTest, CALL_nn) {
   EXPECT_EQ(state->registers.SP, 0xFFFD);
 
   // Check pushed return address
-  byte low = state->memory[0xFFFD];
-  byte high = state->memory[0xFFFE];
+  byte low = state->memory.fastRead(0xFFFD);
+  byte high = state->memory.fastRead(0xFFFE);
   word returnAddr = (high << 8) | low;
   EXPECT_EQ(returnAddr, 0x8003);
 }
@@ -71,8 +71,8 @@ TEST_F(InstructionTest, RET) {
   state->registers.SP = 0xFFFD;
 
   // Push return address 0x9000
-  state->memory[0xFFFD] = 0x00;
-  state->memory[0xFFFE] = 0x90;
+  state->memory.fastWrite(0xFFFD, 0x00);
+  state->memory.fastWrite(0xFFFE, 0x90);
 
   // RET
   executeInstruction({0xC9}, 0x8000);
@@ -97,8 +97,8 @@ TEST_F(InstructionTest, CALL_NZ_Taken) {
   EXPECT_EQ(state->registers.PC, 0x8020);
 
   // Check return address: It should be 0x8003 (instruction size is 3)
-  byte low = state->memory[state->registers.SP];
-  byte high = state->memory[state->registers.SP + 1];
+  byte low = state->memory.fastRead(state->registers.SP);
+  byte high = state->memory.fastRead(state->registers.SP + 1);
   word returnAddr = (high << 8) | low;
 
   EXPECT_EQ(returnAddr, 0x8003);
@@ -338,7 +338,7 @@ TEST_F(InstructionTest, ED_LDIR_SingleStep) {
   executeInstruction({0xED, 0xB0}, 0x8000);
 
   // Verify first byte copied
-  EXPECT_EQ(state->memory[dest], 0xAA);
+  EXPECT_EQ(state->memory.fastRead(dest), 0xAA);
   // Verify pointers updated
   EXPECT_EQ(state->registers.HL, src + 1);
   EXPECT_EQ(state->registers.DE, dest + 1);
@@ -356,7 +356,7 @@ TEST_F(InstructionTest, ED_LDIR_SingleStep) {
   processor.step();         // Execute next (which is same LDIR)
   processor.executeFrame(); // ACTUALLY execute it
 
-  EXPECT_EQ(state->memory[dest + 1], 0xBB);
+  EXPECT_EQ(state->memory.fastRead(dest + 1), 0xBB);
   EXPECT_EQ(state->registers.HL, src + 2);
   EXPECT_EQ(state->registers.DE, dest + 2);
   EXPECT_EQ(state->registers.BC, 0);
@@ -380,7 +380,7 @@ TEST_F(InstructionTest, ED_LDDR_SingleStep) {
 
   executeInstruction({0xED, 0xB8}, 0x8000);
 
-  EXPECT_EQ(state->memory[dest], 0xCC);
+  EXPECT_EQ(state->memory.fastRead(dest), 0xCC);
   EXPECT_EQ(state->registers.HL, src - 1);
   EXPECT_EQ(state->registers.DE, dest - 1);
   EXPECT_EQ(state->registers.BC, 0);
@@ -422,3 +422,305 @@ TEST_F(InstructionTest, DAA_Sub_LowNibble) {
   EXPECT_TRUE(checkFlag(H_FLAG));
   EXPECT_TRUE(checkFlag(N_FLAG));
 }
+
+// Test DD CB d 00 (RLC (IX+d), B) - undocumented copy of the result into B
+TEST_F(InstructionTest, DDCB_RLC_IXd_CopiesToRegister) {
+  state->registers.IX = 0x9000;
+  state->registers.B = 0x00;
+  writeBytes(0x8FFF, 0x81);
+
+  // RLC (IX-1), B
+  executeInstruction({0xDD, 0xCB, 0xFF, 0x00}, 0x8000);
+
+  EXPECT_EQ(state->memory.fastRead(0x8FFF), 0x03);
+  EXPECT_EQ(state->registers.B, 0x03);
+  EXPECT_TRUE(checkFlag(C_FLAG));
+  EXPECT_EQ(state->registers.PC, 0x8004);
+}
+
+// Test FD 85 (ADD A, IYL)
+TEST_F(InstructionTest, FD_ADD_A_IYL) {
+  state->registers.A = 0x10;
+  state->registers.IY = 0x1234;
+  state->registers.L = 0xFF;
+
+  executeInstruction({0xFD, 0x85}, 0x8000);
+
+  EXPECT_EQ(state->registers.A, 0x44);
+  EXPECT_EQ(state->registers.PC, 0x8002);
+}
+
+// An index prefix before a non-index opcode is skipped and the opcode runs
+// unprefixed on the next step
+TEST_F(InstructionTest, DD_NonIndexOpcode) {
+  state->registers.A = 0x00;
+
+  executeInstruction({0xDD, 0x3C}, 0x8000);
+  EXPECT_EQ(state->registers.PC, 0x8001);
+
+  processor.step();
+  processor.executeFrame();
+  EXPECT_EQ(state->registers.A, 0x01);
+  EXPECT_EQ(state->registers.PC, 0x8002);
+}
+
+// Test ADD A, n (0xC6) half carry and overflow: 0x7F + 0x01 = 0x80
+TEST_F(InstructionTest, ADD_A_n_HalfCarryOverflow) {
+  state->registers.A = 0x7F;
+  state->registers.F = 0;
+  executeInstruction({0xC6, 0x01}, 0x8000);
+
+  EXPECT_EQ(state->registers.A, 0x80);
+  EXPECT_TRUE(checkFlag(S_FLAG));
+  EXPECT_FALSE(checkFlag(Z_FLAG));
+  EXPECT_TRUE(checkFlag(H_FLAG));
+  EXPECT_TRUE(checkFlag(P_FLAG));
+  EXPECT_FALSE(checkFlag(N_FLAG));
+  EXPECT_FALSE(checkFlag(C_FLAG));
+}
+
+// Test SUB n (0xD6) borrow: 0x10 - 0x20 = 0xF0
+TEST_F(InstructionTest, SUB_n_Borrow) {
+  state->registers.A = 0x10;
+  state->registers.F = 0;
+  executeInstruction({0xD6, 0x20}, 0x8000);
+
+  EXPECT_EQ(state->registers.A, 0xF0);
+  EXPECT_TRUE(checkFlag(S_FLAG));
+  EXPECT_FALSE(checkFlag(H_FLAG));
+  EXPECT_FALSE(checkFlag(P_FLAG));
+  EXPECT_TRUE(checkFlag(N_FLAG));
+  EXPECT_TRUE(checkFlag(C_FLAG));
+}
+
+// Test XOR A (0xAF): zero result with even parity, carry cleared
+TEST_F(InstructionTest, XOR_A_Parity) {
+  state->registers.A = 0x5A;
+  state->registers.F = C_FLAG | N_FLAG;
+  executeInstruction({0xAF}, 0x8000);
+
+  EXPECT_EQ(state->registers.A, 0x00);
+  EXPECT_EQ(state->registers.F, Z_FLAG | P_FLAG);
+}
+
+// Lazy flag core: a DEC/JR NZ loop branches on the deferred Z flag and F is
+// built before PUSH AF reads it
+TEST_F(InstructionTest, LazyFlags_DecJrNzPushAf) {
+  processor.setLazyFlags(true);
+  state->registers.SP = 0xFFF0;
+  state->registers.B = 0x02;
+  state->registers.F = C_FLAG;
+
+  // loop: DEC B ; JR NZ, loop ; PUSH AF
+  executeInstruction({0x05, 0x20, 0xFD, 0xF5}, 0x8000);
+  for (int i = 0; i < 4; i++) {
+    processor.step();
+    processor.executeFrame();
+  }
+
+  EXPECT_EQ(state->registers.B, 0x00);
+  EXPECT_EQ(state->registers.PC, 0x8004);
+  // DEC B to zero sets Z and N and preserves C
+  byte pushedF = state->memory.fastRead(0xFFEE);
+  EXPECT_EQ(pushedF, Z_FLAG | N_FLAG | C_FLAG);
+  EXPECT_EQ(state->registers.F, pushedF);
+}
+
+// Decode cache: rewriting code that has already run replaces the cached entry
+TEST_F(InstructionTest, DecodeCache_InvalidatedByWrite) {
+  // LD IX, 0x1234
+  executeInstruction({0xDD, 0x21, 0x34, 0x12}, 0x8000);
+  EXPECT_EQ(state->registers.IX, 0x1234);
+
+  // Same address, new prefix and operand: LD IY, 0x5678
+  executeInstruction({0xFD, 0x21, 0x78, 0x56}, 0x8000);
+  EXPECT_EQ(state->registers.IY, 0x5678);
+  EXPECT_EQ(state->registers.IX, 0x1234);
+
+  // Self modifying: LD (0x8004), A overwrites the operand of the LD B, n
+  // that follows it
+  state->registers.A = 0x99;
+  executeInstruction({0x06, 0x11}, 0x8003);
+  executeInstruction({0x32, 0x04, 0x80}, 0x8000);
+  processor.step();
+  processor.executeFrame();
+  EXPECT_EQ(state->registers.B, 0x99);
+}
+
+// Block replay: a frame of self modifying code with a port write gives
+// the same machine state as the interpreter
+TEST_F(InstructionTest, BlockReplay_MatchesInterpreter) {
+  // 8000: LD HL, 0x9000
+  //       LD B, 0x10
+  // 8005: LD (HL), B
+  //       INC HL
+  // 8007: INC C              ; flipped between INC C and DEC C below
+  //       DJNZ 0x8005
+  //       LD A, (0x8007)
+  //       XOR 0x01
+  //       LD (0x8007), A
+  //       OUT (0xFE), A
+  //       JR 0x8000
+  const std::vector<byte> program = {
+      0x21, 0x00, 0x90, 0x06, 0x10, 0x70, 0x23, 0x0C, 0x10, 0xFB, 0x3A,
+      0x07, 0x80, 0xEE, 0x01, 0x32, 0x07, 0x80, 0xD3, 0xFE, 0x18, 0xEA};
+
+  Processor replayed;
+  replayed.setBlockReplay(true);
+  // Full frames, so don't wait for the audio device
+  processor.setTurbo(true);
+  replayed.setTurbo(true);
+  ProcessorState *states[] = {state, &replayed.getState()};
+  for (ProcessorState *s : states) {
+    for (size_t i = 0; i < program.size(); i++)
+      s->memory.fastWrite(0x8000 + i, program[i]);
+    s->registers.PC = 0x8000;
+    s->setInterrupts(false);
+  }
+
+  processor.executeFrame();
+  replayed.executeFrame();
+
+  const ProcessorState &expected = *states[0];
+  const ProcessorState &actual = *states[1];
+  EXPECT_EQ(actual.registers.PC, expected.registers.PC);
+  EXPECT_EQ(actual.registers.AF, expected.registers.AF);
+  EXPECT_EQ(actual.registers.BC, expected.registers.BC);
+  EXPECT_EQ(actual.registers.HL, expected.registers.HL);
+  EXPECT_EQ(actual.registers.R, expected.registers.R);
+  EXPECT_EQ(actual.getFrameTStates(), expected.getFrameTStates());
+  EXPECT_EQ(actual.getSpeakerBit(), expected.getSpeakerBit());
+  for (word address = 0x8000; address < 0x9100; address++)
+    ASSERT_EQ(actual.memory.fastRead(address),
+              expected.memory.fastRead(address))
+        << "at " << address;
+}
+
+// The last instruction of a frame can run past the frame end. The overrun is
+// where the next frame starts, so no T-states are lost between frames.
+TEST_F(InstructionTest, FrameOverrunCarriedIntoNextFrame) {
+  processor.setTurbo(true);
+  state->setInterrupts(false);
+
+  // JP 0x8000 (10 T-states) forever
+  writeBytes(0x8000, 0xC3);
+  writeBytes(0x8001, 0x00);
+  writeBytes(0x8002, 0x80);
+  state->registers.PC = 0x8000;
+
+  // 6989 x 10 = 69890, two past the 69888 T-state frame
+  processor.executeFrame();
+  EXPECT_EQ(state->getFrameTStates(), 69890);
+
+  // Starts at 2, so 6989 more jumps reach 69892
+  processor.executeFrame();
+  EXPECT_EQ(state->getFrameTStates(), 69892);
+}
+
+// HALT with interrupts off runs NOPs to the end of the frame in one step,
+// with the same T-states and R as running them one at a time
+TEST_F(InstructionTest, HALT_FastForwardToFrameEnd) {
+  processor.setTurbo(true);
+  state->setInterrupts(false);
+  state->registers.R = 0x80;
+  writeBytes(0x8000, 0x76);
+  state->registers.PC = 0x8000;
+
+  processor.executeFrame();
+
+  // HALT then (69888 - 4) / 4 = 17471 NOPs, 17472 M1 cycles in all
+  EXPECT_TRUE(state->isHalted());
+  EXPECT_EQ(state->registers.PC, 0x8001);
+  EXPECT_EQ(state->getFrameTStates(), 69888);
+  EXPECT_EQ(state->registers.R, 0x80 | (17472 & 0x7F));
+}
+
+// LDIR runs its passes in bulk but lands on the same registers, T-states
+// and R as stepping it 256 times
+TEST_F(InstructionTest, ED_LDIR_BulkMatchesIterative) {
+  processor.setTurbo(true);
+  state->setInterrupts(false);
+  for (int i = 0; i < 0x100; i++)
+    writeBytes(0x9000 + i, i);
+
+  writeBytes(0x8000, 0xED); // LDIR
+  writeBytes(0x8001, 0xB0);
+  writeBytes(0x8002, 0x76); // HALT
+  state->registers.PC = 0x8000;
+  state->registers.HL = 0x9000;
+  state->registers.DE = 0xA000;
+  state->registers.BC = 0x0100;
+  state->registers.R = 0;
+
+  processor.executeFrame();
+
+  for (int i = 0; i < 0x100; i++)
+    ASSERT_EQ(state->memory.fastRead(0xA000 + i), i);
+  EXPECT_EQ(state->registers.HL, 0x9100);
+  EXPECT_EQ(state->registers.DE, 0xA100);
+  EXPECT_EQ(state->registers.BC, 0);
+  EXPECT_FALSE(checkFlag(P_FLAG));
+
+  // 255 x 21 + 16 for LDIR, 4 for HALT, then 16129 NOPs past the frame end
+  EXPECT_EQ(state->getFrameTStates(), 5375 + 16129 * 4);
+  EXPECT_EQ(state->registers.R, (256 + 1 + 16129) & 0x7F);
+}
+
+// CPIR stops on the match with the flags of that compare
+TEST_F(InstructionTest, ED_CPIR_BulkMatchesIterative) {
+  processor.setTurbo(true);
+  state->setInterrupts(false);
+  for (int i = 0; i < 0x100; i++)
+    writeBytes(0x9000 + i, 0);
+  writeBytes(0x9010, 0x55);
+
+  writeBytes(0x8000, 0xED); // CPIR
+  writeBytes(0x8001, 0xB1);
+  writeBytes(0x8002, 0x76); // HALT
+  state->registers.PC = 0x8000;
+  state->registers.A = 0x55;
+  state->registers.HL = 0x9000;
+  state->registers.BC = 0x0100;
+  state->registers.R = 0;
+
+  processor.executeFrame();
+
+  EXPECT_EQ(state->registers.HL, 0x9011);
+  EXPECT_EQ(state->registers.BC, 0x00EF);
+  EXPECT_TRUE(checkFlag(Z_FLAG));
+  EXPECT_TRUE(checkFlag(P_FLAG));
+
+  // 16 x 21 + 16 for CPIR, 4 for HALT, then 17383 NOPs to the frame end
+  EXPECT_EQ(state->getFrameTStates(), 356 + 17383 * 4);
+  EXPECT_EQ(state->registers.R, (17 + 1 + 17383) & 0x7F);
+}
+
+// A DJNZ delay and a memory poll that can't end before the frame does are
+// fast-forwarded, ending on the same T-states and R as running them
+TEST_F(InstructionTest, IdleLoopSkippedToFrameEnd) {
+  processor.setTurbo(true);
+  state->setInterrupts(false);
+  writeBytes(0x9000, 0x00);
+
+  writeBytes(0x8000, 0x10); // DJNZ $
+  writeBytes(0x8001, 0xFE);
+  writeBytes(0x8002, 0x3A); // LD A,(0x9000)
+  writeBytes(0x8003, 0x00);
+  writeBytes(0x8004, 0x90);
+  writeBytes(0x8005, 0xFE); // CP 0
+  writeBytes(0x8006, 0x00);
+  writeBytes(0x8007, 0x28); // JR Z,0x8002
+  writeBytes(0x8008, 0xF9);
+  state->registers.PC = 0x8000;
+  state->registers.B = 0x10;
+  state->registers.R = 0;
+
+  processor.executeFrame();
+
+  // 15 x 13 + 8 for DJNZ, then 2178 polls of 32 T-states
+  EXPECT_EQ(state->registers.PC, 0x8002);
+  EXPECT_EQ(state->registers.B, 0);
+  EXPECT_EQ(state->getFrameTStates(), 203 + 2178 * 32);
+  EXPECT_EQ(state->registers.R, (16 + 3 * 2178) & 0x7F);
+  EXPECT_GT(processor.getStats().idleTStatesSkipped, 60000);
+}
@@ -0,0 +1,109 @@
+#include "../spectrum/Processor.h"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+// Load a ROM set of the given number of 16K ROMs, all HALT
+void initWithRoms(Processor &processor, int roms) {
+  const char *romFile = "machine_model_test_rom.bin";
+  std::vector<byte> image(roms * BANK_SIZE, 0x76);
+  FILE *file = fopen(romFile, "wb");
+  ASSERT_NE(file, nullptr);
+  fwrite(image.data(), 1, image.size(), file);
+  fclose(file);
+  processor.init(romFile);
+  remove(romFile);
+}
+
+void writeCode(ProcessorState &state, word address,
+               const std::vector<byte> &code) {
+  for (size_t i = 0; i < code.size(); i++)
+    state.memory.fastWrite(address + i, code[i]);
+}
+
+} // namespace
+
+// The ROM set picks the machine, and with it the frame and line lengths
+TEST(MachineModelTest, RomSetSelectsTimings) {
+  const struct {
+    int roms;
+    Machine machine;
+    int frame;
+    int line;
+  } machines[] = {{1, Machine::SPECTRUM_48K, 69888, 224},
+                  {2, Machine::SPECTRUM_128K, 70908, 228},
+                  {4, Machine::PLUS_2A, 70908, 228}};
+
+  for (const auto &expected : machines) {
+    Processor processor;
+    processor.setTurbo(true);
+    initWithRoms(processor, expected.roms);
+    ProcessorState &state = processor.getState();
+    EXPECT_EQ(processor.getMachine(), expected.machine);
+    EXPECT_EQ(processor.getFrameLength(), expected.frame);
+    EXPECT_EQ(state.memory.getVideoBuffer()->getLineTStates(), expected.line);
+
+    // HALT with interrupts off runs to the end of the frame
+    state.setInterrupts(false);
+    state.registers.PC = 0x8000;
+    writeCode(state, 0x8000, {0x76});
+    processor.executeFrame();
+    EXPECT_EQ(state.getFrameTStates(), expected.frame) << expected.roms;
+  }
+}
+
+// /INT is held for the start of the frame, so an EI there still takes the
+// interrupt, one instruction later. Later EIs miss it.
+TEST(MachineModelTest, InterruptHeldForInterruptLength) {
+  for (int nops : {0, 8}) {
+    Processor processor;
+    processor.setTurbo(true);
+    initWithRoms(processor, 1);
+    ProcessorState &state = processor.getState();
+
+    // IM 2 through 0x80FF to 0x9000: LD A,0x42; LD (0x9100),A; HALT
+    state.setInterrupts(false);
+    state.setInterruptMode(2);
+    state.registers.I = 0x80;
+    state.registers.SP = 0xF000;
+    writeCode(state, 0x80FF, {0x00, 0x90});
+    writeCode(state, 0x9000, {0x3E, 0x42, 0x32, 0x00, 0x91, 0x76});
+
+    // NOPs, EI, NOP, then JR $
+    std::vector<byte> code(nops, 0x00);
+    code.insert(code.end(), {0xFB, 0x00, 0x18, 0xFE});
+    writeCode(state, 0x8000, code);
+    state.registers.PC = 0x8000;
+    processor.executeFrame();
+
+    if (nops == 0) {
+      EXPECT_EQ(state.memory.fastRead(0x9100), 0x42);
+      EXPECT_EQ(state.memory.getWord(0xEFFE), 0x8002);
+    } else {
+      EXPECT_EQ(state.memory.fastRead(0x9100), 0x00);
+      EXPECT_EQ(state.registers.SP, 0xF000);
+    }
+  }
+}
+
+TEST(MachineModelTest, ContentionPatterns) {
+  EXPECT_EQ(contentionDelay<Spectrum48K>(14334), 0);
+  EXPECT_EQ(contentionDelay<Spectrum48K>(14335), 6);
+  EXPECT_EQ(contentionDelay<Spectrum48K>(14336), 5);
+  EXPECT_EQ(contentionDelay<Spectrum48K>(14335 + 6), 0);
+  EXPECT_EQ(contentionDelay<Spectrum48K>(14335 + 128), 0);
+  EXPECT_EQ(contentionDelay<Spectrum48K>(14335 + 224), 6);
+  EXPECT_EQ(contentionDelay<Spectrum48K>(14335 + 192 * 224), 0);
+  EXPECT_EQ(contentionDelay<Spectrum128K>(14361 + 228), 6);
+  EXPECT_EQ(contentionDelay<Plus2A>(14365), 1);
+  EXPECT_EQ(contentionDelay<Plus2A>(14367), 7);
+
+  EXPECT_TRUE(isContended<Spectrum48K>(5));
+  EXPECT_FALSE(isContended<Spectrum48K>(2));
+  EXPECT_TRUE(isContended<Spectrum128K>(7));
+  EXPECT_FALSE(isContended<Spectrum128K>(4));
+  EXPECT_TRUE(isContended<Plus2A>(4));
+  EXPECT_FALSE(isContended<Plus2A>(3));
+}
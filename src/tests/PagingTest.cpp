@@ -0,0 +1,268 @@
+#include "../spectrum/Processor.h"
+#include "../spectrum/SnapshotLoader.h"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <vector>
+
+// A 128K machine from a 32K ROM image: the editor ROM filled with 0xA0 and
+// the 48K BASIC ROM with 0xB1
+class PagingTest : public ::testing::Test {
+protected:
+  const char *romFile = "paging_test_rom.bin";
+  Memory memory;
+
+  void SetUp() override {
+    std::vector<byte> image(2 * BANK_SIZE, 0xA0);
+    std::fill(image.begin() + BANK_SIZE, image.end(), 0xB1);
+    FILE *file = fopen(romFile, "wb");
+    ASSERT_NE(file, nullptr);
+    fwrite(image.data(), 1, image.size(), file);
+    fclose(file);
+  }
+
+  void TearDown() override { remove(romFile); }
+
+  void load128K() {
+    Rom rom(romFile);
+    memory.loadIntoMemory(rom);
+  }
+};
+
+TEST_F(PagingTest, FortyEightKIgnoresPagingPort) {
+  Rom rom("roms/48k.bin");
+  ASSERT_GT(rom.getSize(), 0);
+  memory.loadIntoMemory(rom);
+  EXPECT_FALSE(memory.isPageable());
+
+  memory.writePagingPort(PAGING_ROM | 3);
+  memory.fastWrite(0xC000, 0x42);
+  EXPECT_EQ(memory.getBank(0)[0], 0x42);
+  EXPECT_EQ(memory.getPagingRegister(), 0);
+}
+
+// Port 0x7FFD maps ROMs and banks in place, keeping what each bank holds
+TEST_F(PagingTest, PagingPortMapsBanks) {
+  load128K();
+  ASSERT_TRUE(memory.isPageable());
+  EXPECT_EQ(memory.fastRead(0x0000), 0xA0);
+
+  memory.writePagingPort(PAGING_ROM | 3);
+  EXPECT_EQ(memory.fastRead(0x0000), 0xB1);
+  memory.fastWrite(0xC000, 0x42);
+  EXPECT_EQ(memory.getBank(3)[0], 0x42);
+
+  memory.writePagingPort(0);
+  EXPECT_EQ(memory.fastRead(0x0000), 0xA0);
+  EXPECT_EQ(memory.fastRead(0xC000), 0x00);
+  memory.writePagingPort(3);
+  EXPECT_EQ(memory.fastRead(0xC000), 0x42);
+
+  // Bank 5 is the screen at 0x4000 wherever else it is mapped
+  memory.writePagingPort(5);
+  memory.fastWrite(0xC123, 0x99);
+  EXPECT_EQ(memory.fastRead(0x4123), 0x99);
+
+  // Block copies cross from one bank to the next
+  memory.writePagingPort(1);
+  for (int i = 0; i < 16; i++)
+    memory.fastWrite(0xBFF8 + i, i);
+  memory.fastCopy(0x9000, 0xBFF8, 16);
+  for (int i = 0; i < 16; i++)
+    EXPECT_EQ(memory.fastRead(0x9000 + i), i) << i;
+  EXPECT_EQ(memory.getBank(1)[7], 15);
+}
+
+// The shadow screen in bank 7 is shown, and marks cells, wherever it is
+// mapped. Writes once the register is locked are ignored until reset.
+TEST_F(PagingTest, ShadowScreenAndLock) {
+  load128K();
+  memory.writePagingPort(PAGING_SHADOW | 7);
+  EXPECT_EQ(memory.getVideoBuffer()->getBuffer(), memory.getBank(7));
+
+  memory.clearDirtyCells();
+  memory.fastWrite(0x4000, 0xFF); // bank 5, not on screen
+  memory.fastWrite(0xC000 + VIDEO_BITMAP_DATA + 33, 0x47);
+  EXPECT_EQ(memory.getDirtyCells().rows[0], 0u);
+  EXPECT_EQ(memory.getDirtyCells().rows[1], 1u << 1);
+
+  memory.writePagingPort(PAGING_LOCKED | 1);
+  memory.writePagingPort(4);
+  EXPECT_EQ(memory.getPagingRegister(), PAGING_LOCKED | 1);
+  EXPECT_EQ(memory.getVideoBuffer()->getBuffer(), memory.getBank(5));
+
+  memory.setPagingRegister(0);
+  memory.writePagingPort(4);
+  EXPECT_EQ(memory.getPagingRegister(), 4);
+}
+
+// Code decoded from one bank doesn't run once another is paged in
+TEST_F(PagingTest, PagingDropsCachedCode) {
+  Rom rom(romFile);
+  Processor processor;
+  processor.init(rom);
+  ProcessorState &state = processor.getState();
+  const byte one[] = {0x3E, 0x11};   // LD A,0x11
+  const byte three[] = {0xAF, 0x33}; // XOR A
+  std::copy(one, one + 2, state.memory.getBank(1));
+  std::copy(three, three + 2, state.memory.getBank(3));
+
+  processor.pause();
+  for (byte bank : {1, 3, 1}) {
+    state.memory.writePagingPort(bank);
+    state.registers.PC = 0xC000;
+    processor.step();
+    processor.executeFrame();
+    EXPECT_EQ(state.registers.A, bank == 1 ? 0x11 : 0x00) << (int)bank;
+  }
+}
+
+// Bank 2 mapped at 0xC000 as well as 0x8000: code changed through one
+// address isn't run stale through the other
+TEST_F(PagingTest, WritesReachCodeAtEveryMapping) {
+  Rom rom(romFile);
+  Processor processor;
+  processor.init(rom);
+  ProcessorState &state = processor.getState();
+  state.memory.writePagingPort(2);
+  // LD A,0x11 : LD B,0x00 : JR $, then the loads swapped round
+  const byte before[] = {0x3E, 0x11, 0x06, 0x00, 0x18, 0xFE};
+  const byte after[] = {0x06, 0x11, 0x3E, 0x00};
+  for (int i = 0; i < 6; i++)
+    state.memory.fastWrite(0x8000 + i, before[i]);
+
+  state.registers.PC = 0xC000;
+  processor.executeFrame();
+  EXPECT_EQ(state.registers.A, 0x11);
+
+  for (int i = 0; i < 4; i++)
+    state.memory.fastWrite(0x8000 + i, after[i]);
+  state.registers.PC = 0xC000;
+  processor.executeFrame();
+  EXPECT_EQ(state.registers.A, 0x00);
+  EXPECT_EQ(state.registers.B, 0x11);
+}
+
+// An LDIR from bank 5 at 0x4000 to one byte on, through its mapping at
+// 0xC000, fills like it would within one mapping
+TEST_F(PagingTest, BlockCopyBetweenMappingsOfOneBank) {
+  Rom rom(romFile);
+  Processor processor;
+  processor.init(rom);
+  ProcessorState &state = processor.getState();
+  state.memory.writePagingPort(5);
+  const byte ldir[] = {0xED, 0xB0, 0x18, 0xFE}; // LDIR : JR $
+  for (int i = 0; i < 4; i++)
+    state.memory.fastWrite(0x8000 + i, ldir[i]);
+  for (int i = 0; i < 9; i++)
+    state.memory.fastWrite(0x6000 + i, i ? i : 0xAA);
+
+  state.registers.HL = 0x6000;
+  state.registers.DE = 0xE001;
+  state.registers.BC = 8;
+  state.registers.PC = 0x8000;
+  processor.executeFrame();
+  for (int i = 0; i < 9; i++)
+    EXPECT_EQ(state.memory.fastRead(0x6000 + i), 0xAA) << i;
+}
+
+// Writes to the ROM go nowhere, whichever ROM is paged in, and addresses
+// wrap at 64K
+TEST_F(PagingTest, RomWritesAreDiscarded) {
+  load128K();
+  for (byte rom : {0, PAGING_ROM}) {
+    memory.writePagingPort(rom);
+    byte before = memory.fastRead(0x1234);
+    memory.fastWrite(0x1234, before ^ 0xFF);
+    EXPECT_EQ(memory.fastRead(0x1234), before);
+  }
+
+  // Nor do they count as changes or drop code decoded from the ROM
+  DecodeCache &decoded = memory.getDecodeCache();
+  decoded.store(0x1234, DecodeCache::Entry());
+  unsigned long changes = memory.getChanges();
+  unsigned long generation = decoded.getGeneration();
+  memory.fastWrite(0x1234, 0x55);
+  memory.fastCopy(0x1230, 0x8000, 8);
+  EXPECT_EQ(memory.getChanges(), changes);
+  EXPECT_EQ(decoded.getGeneration(), generation);
+
+  memory.fastWrite(0xFFFF, 0x34);
+  EXPECT_EQ(memory.getWord(0xFFFF), (memory.fastRead(0x0000) << 8) | 0x34);
+}
+
+// A 64K ROM makes a +2A: 0x1FFD picks the upper ROMs, or maps RAM over the
+// whole address space, and is locked with 0x7FFD
+TEST(PlusPagingTest, PlusPagingPortMapsRomsAndRam) {
+  const char *romFile = "plus_paging_test_rom.bin";
+  std::vector<byte> image(4 * BANK_SIZE);
+  for (int rom = 0; rom < 4; rom++)
+    std::fill(image.begin() + rom * BANK_SIZE,
+              image.begin() + (rom + 1) * BANK_SIZE, 0xC0 + rom);
+  FILE *file = fopen(romFile, "wb");
+  ASSERT_NE(file, nullptr);
+  fwrite(image.data(), 1, image.size(), file);
+  fclose(file);
+  Rom rom(romFile);
+  remove(romFile);
+
+  Memory memory;
+  memory.loadIntoMemory(rom);
+  ASSERT_EQ(memory.getRomCount(), 4);
+  EXPECT_EQ(memory.fastRead(0x0000), 0xC0);
+  memory.writePagingPort(PAGING_ROM);
+  memory.writePlusPagingPort(PLUS_PAGING_ROM);
+  EXPECT_EQ(memory.fastRead(0x0000), 0xC3);
+
+  // Banks 4, 7, 6 and 3, the first written at 0x0000 and shown as the
+  // shadow screen at 0x4000
+  memory.writePagingPort(PAGING_SHADOW);
+  memory.writePlusPagingPort(PLUS_PAGING_SPECIAL | 0x06);
+  memory.fastWrite(0x0000, 0x42);
+  EXPECT_EQ(memory.getBank(4)[0], 0x42);
+  memory.clearDirtyCells();
+  memory.fastWrite(0x4000, 0x99);
+  EXPECT_EQ(memory.getBank(7)[0], 0x99);
+  EXPECT_EQ(memory.getDirtyCells().rows[0], 1u);
+
+  memory.writePagingPort(PAGING_LOCKED);
+  memory.writePlusPagingPort(0);
+  EXPECT_EQ(memory.fastRead(0x0000), 0x42);
+  memory.setPlusPagingRegister(0);
+  EXPECT_EQ(memory.fastRead(0x0000), 0xC0);
+}
+
+// A 48K snapshot runs on 48K BASIC, ROM 3 of a +2A's set, whatever 0x1FFD
+// held before
+TEST(PlusPagingTest, SnapshotResetsPlusPaging) {
+  const char *romFile = "plus_snapshot_test_rom.bin";
+  std::vector<byte> image(4 * BANK_SIZE);
+  for (int rom = 0; rom < 4; rom++)
+    std::fill(image.begin() + rom * BANK_SIZE,
+              image.begin() + (rom + 1) * BANK_SIZE, 0xC0 + rom);
+  FILE *file = fopen(romFile, "wb");
+  ASSERT_NE(file, nullptr);
+  fwrite(image.data(), 1, image.size(), file);
+  fclose(file);
+  Rom rom(romFile);
+  remove(romFile);
+
+  // 27 bytes of registers, SP at 0x8000, then 48K of RAM
+  const char *snapshotFile = "plus_snapshot_test.sna";
+  std::vector<byte> snapshot(27 + 3 * BANK_SIZE);
+  snapshot[24] = 0x80;
+  file = fopen(snapshotFile, "wb");
+  ASSERT_NE(file, nullptr);
+  fwrite(snapshot.data(), 1, snapshot.size(), file);
+  fclose(file);
+
+  Processor processor;
+  processor.init(rom);
+  ProcessorState &state = processor.getState();
+  state.memory.setPlusPagingRegister(PLUS_PAGING_SPECIAL);
+  EXPECT_EQ(state.memory.fastRead(0x0000), 0x00);
+
+  SnapshotLoader::load(snapshotFile, state);
+  remove(snapshotFile);
+  EXPECT_EQ(state.memory.fastRead(0x0000), 0xC3);
+  EXPECT_EQ(state.memory.getPlusPagingRegister(), PLUS_PAGING_ROM);
+}
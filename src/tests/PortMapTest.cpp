@@ -0,0 +1,100 @@
+#include "../spectrum/OpcodeTables.h"
+#include "../spectrum/Processor.h"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+// Answers reads with a fixed value and remembers the last write
+struct TestDevice : PortDevice {
+  byte value;
+  int writes = 0;
+  explicit TestDevice(byte value) : value(value) {}
+  byte read(word) override { return value; }
+  void write(word, byte data) override {
+    value = data;
+    writes++;
+  }
+};
+
+// Run the instruction at 0x8000 on the processor's bus
+void execute(ProcessorState &state, const std::vector<byte> &code) {
+  for (size_t i = 0; i < code.size(); i++)
+    state.write(0x8000 + i, code[i]);
+  state.registers.PC = 0x8000;
+  Opcodes::step(state);
+}
+
+} // namespace
+
+TEST(PortMapTest, DevicesAnswerTheirDecodedPorts) {
+  PortMap ports;
+  TestDevice even(0xF0), low(0x3C);
+  ports.attach(even, 0x0001, 0x0000);
+  ports.attach(low, 0x00FF, 0x00FE, true, false);
+
+  EXPECT_EQ(ports.read(0x7FFF), 0xFF); // Nothing there
+  EXPECT_EQ(ports.read(0x12FC), 0xF0);
+  EXPECT_EQ(ports.read(0x12FE), 0xF0 & 0x3C); // Both pull lines low
+
+  ports.write(0x00FE, 0x07);
+  EXPECT_EQ(even.writes, 1);
+  EXPECT_EQ(low.writes, 0); // Attached for reads only
+
+  ports.clear();
+  EXPECT_EQ(ports.read(0x12FE), 0xFF);
+}
+
+// IN r, (C) and OUT (C), r decode ports as IN A, (n) and OUT (n), A do
+TEST(PortMapTest, RegisterPortsDecodeLikeImmediatePorts) {
+  Processor processor;
+  ProcessorState &state = processor.getState();
+
+  state.keyboard.setKempstonKey(0, true);
+  state.registers.BC = 0x001F;
+  execute(state, {0xED, 0x78}); // IN A, (C)
+  EXPECT_EQ(state.registers.A, state.keyboard.readKempstonPort());
+  EXPECT_NE(state.registers.A, 0xFF);
+
+  // Any even port reaches the ULA
+  state.registers.BC = 0x00FC;
+  state.registers.A = 0x10;
+  execute(state, {0xED, 0x79}); // OUT (C), A
+  EXPECT_TRUE(state.getSpeakerBit());
+}
+
+// The AY registers are only on the ports of a 128K
+TEST(PortMapTest, AyRegistersOnlyOn128K) {
+  Processor processor;
+  processor.init("roms/48k.bin");
+  ProcessorState &state = processor.getState();
+  state.registers.BC = 0xFFFD;
+  execute(state, {0xED, 0x78}); // IN A, (C)
+  EXPECT_EQ(state.registers.A, 0xFF);
+
+  const char *romFile = "port_map_test_rom.bin";
+  std::vector<byte> image(2 * BANK_SIZE, 0xFF);
+  FILE *file = fopen(romFile, "wb");
+  ASSERT_NE(file, nullptr);
+  fwrite(image.data(), 1, image.size(), file);
+  fclose(file);
+  processor.init(romFile);
+  remove(romFile);
+
+  // Select register 7 then write it; register 1 only keeps 4 bits
+  state.registers.BC = 0xFFFD;
+  state.registers.A = 7;
+  execute(state, {0xED, 0x79}); // OUT (C), A
+  state.registers.BC = 0xBFFD;
+  state.registers.A = 0x38;
+  execute(state, {0xED, 0x79});
+  state.registers.BC = 0xFFFD;
+  execute(state, {0xED, 0x78}); // IN A, (C)
+  EXPECT_EQ(state.registers.A, 0x38);
+  EXPECT_EQ(state.ay.getRegister(7), 0x38);
+
+  state.ay.write(0xFFFD, 1);
+  state.ay.write(0xBFFD, 0xFF);
+  EXPECT_EQ(state.ay.getRegister(1), 0x0F);
+}
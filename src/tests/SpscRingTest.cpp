@@ -0,0 +1,58 @@
+#include "../utils/SpscRing.h"
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using utils::SpscRing;
+
+TEST(SpscRingTest, FillsToCapacityAndWraps) {
+  SpscRing<int, 8> ring;
+  int in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  int out[10] = {};
+
+  EXPECT_EQ(ring.push(in, 10), 8u); // the rest don't fit
+  EXPECT_EQ(ring.size(), 8u);
+  EXPECT_EQ(ring.pop(out, 5), 5u);
+  EXPECT_EQ(out[4], 4);
+
+  // Wraps round the end of the storage
+  EXPECT_EQ(ring.push(in, 5), 5u);
+  EXPECT_EQ(ring.pop(out, 10), 8u);
+  EXPECT_EQ(std::vector<int>(out, out + 8),
+            std::vector<int>({5, 6, 7, 0, 1, 2, 3, 4}));
+  EXPECT_EQ(ring.pop(out, 10), 0u);
+}
+
+// Everything pushed by one thread comes out of the other, in order
+TEST(SpscRingTest, ProducerAndConsumerThreads) {
+  static SpscRing<std::uint32_t, 256> ring;
+  const std::uint32_t total = 200000;
+
+  std::thread producer([&]() {
+    std::uint32_t next = 0, chunk[37];
+    while (next < total) {
+      std::uint32_t count = std::min<std::uint32_t>(37, total - next);
+      for (std::uint32_t i = 0; i < count; i++)
+        chunk[i] = next + i;
+      std::uint32_t pushed = ring.push(chunk, count);
+      if (pushed == 0)
+        std::this_thread::yield();
+      next += pushed;
+    }
+  });
+
+  std::uint32_t expected = 0, chunk[53];
+  bool inOrder = true;
+  while (expected < total) {
+    std::size_t count = ring.pop(chunk, 53);
+    if (count == 0)
+      std::this_thread::yield();
+    for (std::size_t i = 0; i < count; i++)
+      inOrder &= chunk[i] == expected++;
+  }
+  producer.join();
+
+  EXPECT_TRUE(inOrder);
+  EXPECT_EQ(ring.size(), 0u);
+}
@@ -0,0 +1,64 @@
+#include "../utils/TripleBuffer.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+using utils::TripleBuffer;
+
+TEST(TripleBufferTest, ReaderGetsNewestFrame) {
+  TripleBuffer<int> buffer;
+  EXPECT_FALSE(buffer.update());
+
+  buffer.writeBuffer() = 1;
+  buffer.publish();
+  buffer.writeBuffer() = 2;
+  buffer.publish(); // 1 is dropped, never read
+
+  EXPECT_TRUE(buffer.update());
+  EXPECT_EQ(buffer.readBuffer(), 2);
+  EXPECT_FALSE(buffer.update());
+  EXPECT_EQ(buffer.readBuffer(), 2);
+
+  buffer.writeBuffer() = 3;
+  buffer.publish();
+  EXPECT_TRUE(buffer.update());
+  EXPECT_EQ(buffer.readBuffer(), 3);
+}
+
+// The reader never sees a frame the writer is still filling in, and frames
+// only move forwards
+TEST(TripleBufferTest, FramesAreWholeAcrossThreads) {
+  struct Frame {
+    int values[64];
+  };
+  static TripleBuffer<Frame> buffer;
+  const int total = 20000;
+
+  std::thread writer([&]() {
+    for (int n = 1; n <= total; n++) {
+      Frame &frame = buffer.writeBuffer();
+      for (int &value : frame.values)
+        value = n;
+      buffer.publish();
+      if (n % 64 == 0)
+        std::this_thread::yield();
+    }
+  });
+
+  int last = 0;
+  bool whole = true, forwards = true;
+  while (last < total) {
+    if (!buffer.update()) {
+      std::this_thread::yield();
+      continue;
+    }
+    const Frame &frame = buffer.readBuffer();
+    for (int value : frame.values)
+      whole &= value == frame.values[0];
+    forwards &= frame.values[0] > last;
+    last = frame.values[0];
+  }
+  writer.join();
+
+  EXPECT_TRUE(whole);
+  EXPECT_TRUE(forwards);
+}
@@ -16,6 +16,7 @@
 #include <sys/stat.h>
 
 #include "BinaryFileLoader.h"
+#include "Logger.h"
 
 using namespace emulator_types;
 
@@ -62,7 +63,10 @@ void BinaryFileLoader::readFileToBuffer(const char *filename, byte *buffer,
 
     FILE *file_p = fopen(expandedPath.c_str(), "rb");
     int bytes_read = fread(buffer, sizeof(byte), size, file_p);
-    printf("Read file %s - read %d of %d bytes\n", filename, size, bytes_read);
+    char msg[512];
+    snprintf(msg, sizeof(msg), "Read file %s - read %d of %d bytes", filename,
+             size, bytes_read);
+    utils::Logger::write(msg);
     if (file_p) {
       fclose(file_p);
     }
@@ -3,14 +3,24 @@
 //
 
 #include <iostream>
+#include <mutex>
 #include "Logger.h"
 
 using namespace std;
 
 namespace utils {
 
+    static ostream *output = &cout;
+    static mutex outputMutex; // processors may run on several threads
+
     void Logger::write(const char *message) {
-        cout << message << std::endl;
+        lock_guard<mutex> lock(outputMutex);
+        *output << message << std::endl;
+    }
+
+    void Logger::setOutput(ostream &stream) {
+        lock_guard<mutex> lock(outputMutex);
+        output = &stream;
     }
 
 } // utils
\ No newline at end of file
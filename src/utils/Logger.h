@@ -5,11 +5,16 @@
 #ifndef ZXEMULATOR_LOGGER_H
 #define ZXEMULATOR_LOGGER_H
 
+#include <ostream>
+
 namespace utils {
 
     class Logger {
     public:
         static void write(const char *message);
+
+        // Send messages somewhere other than std::cout
+        static void setOutput(std::ostream &stream);
     };
 
 } // utils
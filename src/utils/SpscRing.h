@@ -0,0 +1,94 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_SPSCRING_H
+#define ZXEMULATOR_SPSCRING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace utils {
+
+/**
+ * Fixed size lock-free ring buffer for one producer thread and one
+ * consumer thread. Neither side ever waits for the other: push() takes
+ * what fits and pop() takes what's there.
+ *
+ * Indices run freely and wrap at the power of two capacity, so a full ring
+ * holds all Capacity elements.
+ */
+template <typename T, std::size_t Capacity> class SpscRing {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "capacity must be a power of two");
+
+private:
+  static constexpr std::size_t MASK = Capacity - 1;
+  static constexpr std::size_t CACHE_LINE = 64;
+
+  // Written by the producer, read by the consumer, and the other way
+  // round. Kept on separate lines so the two threads don't share one.
+  alignas(CACHE_LINE) std::atomic<std::size_t> head{0};
+  alignas(CACHE_LINE) std::atomic<std::size_t> tail{0};
+  alignas(CACHE_LINE) T items[Capacity];
+
+  // Copy count elements between a linear buffer and the ring at index,
+  // in at most two pieces around the wrap
+  template <typename Copy>
+  static void wrapped(std::size_t index, std::size_t count, Copy copy) {
+    std::size_t first = std::min(count, Capacity - (index & MASK));
+    copy(index & MASK, 0, first);
+    copy(0, first, count - first);
+  }
+
+public:
+  static constexpr std::size_t capacity() { return Capacity; }
+
+  // Producer only. Returns how many were stored.
+  std::size_t push(const T *data, std::size_t count) {
+    std::size_t h = head.load(std::memory_order_relaxed);
+    std::size_t t = tail.load(std::memory_order_acquire);
+    count = std::min(count, Capacity - (h - t));
+    wrapped(h, count, [&](std::size_t at, std::size_t from, std::size_t n) {
+      std::copy(data + from, data + from + n, items + at);
+    });
+    head.store(h + count, std::memory_order_release);
+    return count;
+  }
+
+  // Consumer only. Returns how many were taken.
+  std::size_t pop(T *data, std::size_t count) {
+    std::size_t t = tail.load(std::memory_order_relaxed);
+    std::size_t h = head.load(std::memory_order_acquire);
+    count = std::min(count, h - t);
+    wrapped(t, count, [&](std::size_t at, std::size_t from, std::size_t n) {
+      std::move(items + at, items + at + n, data + from);
+    });
+    tail.store(t + count, std::memory_order_release);
+    return count;
+  }
+
+  // Either side. Exact for the caller's own end, a snapshot of the other.
+  std::size_t size() const {
+    std::size_t t = tail.load(std::memory_order_acquire);
+    return head.load(std::memory_order_acquire) - t;
+  }
+};
+
+} // namespace utils
+
+#endif // ZXEMULATOR_SPSCRING_H
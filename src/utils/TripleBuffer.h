@@ -0,0 +1,68 @@
+/*
+ * Copyright 2026 G.Pimblott
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZXEMULATOR_TRIPLEBUFFER_H
+#define ZXEMULATOR_TRIPLEBUFFER_H
+
+#include <atomic>
+
+namespace utils {
+
+/**
+ * Lock-free hand-off of whole values, e.g. video frames, from one writer
+ * thread to one reader thread. The writer fills its own buffer and
+ * publishes it; the reader takes the newest published one. Neither side
+ * waits, and frames the reader doesn't get to in time are dropped.
+ *
+ * The three buffers are the writer's, the reader's and a spare which the
+ * two swap with. The spare index carries a flag saying whether it holds a
+ * frame the reader hasn't taken yet.
+ */
+template <typename T> class TripleBuffer {
+private:
+  static constexpr int INDEX = 0x03;
+  static constexpr int FRESH = 0x04;
+
+  T buffers[3];
+  int back = 0;  // Writer only
+  int front = 1; // Reader only
+  std::atomic<int> spare{2};
+
+public:
+  // Writer: the buffer to fill in
+  T &writeBuffer() { return buffers[back]; }
+
+  // Writer: hand the filled buffer over and start on another
+  void publish() {
+    back = spare.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+  }
+
+  // Reader: move on to the newest published buffer. False if nothing has
+  // been published since the last call.
+  bool update() {
+    if (!(spare.load(std::memory_order_relaxed) & FRESH))
+      return false;
+    front = spare.exchange(front, std::memory_order_acq_rel) & INDEX;
+    return true;
+  }
+
+  // Reader: the buffer taken by the last update()
+  const T &readBuffer() const { return buffers[front]; }
+};
+
+} // namespace utils
+
+#endif // ZXEMULATOR_TRIPLEBUFFER_H